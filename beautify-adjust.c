@@ -0,0 +1,297 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <libgimp/gimp.h>
+
+#include "color-lut.h"
+#include "beautify-adjust.h"
+#include "pixel-kernel.h"
+
+void
+beautify_adjust_init (BeautifyAdjust *adjust)
+{
+  gint i;
+
+  memset (adjust, 0, sizeof (BeautifyAdjust));
+
+  for (i = 0; i < 256; i++)
+  {
+    adjust->levels_lut[0][i] = i;
+    adjust->levels_lut[1][i] = i;
+    adjust->levels_lut[2][i] = i;
+    adjust->hue_transfer[i] = i;
+    adjust->saturation_transfer[i] = i;
+  }
+}
+
+/* gimp_operation_levels_map () */
+static gdouble
+levels_map (gdouble value,
+            gdouble inv_gamma,
+            gdouble low_input,
+            gdouble high_input,
+            gdouble low_output,
+            gdouble high_output)
+{
+  /*  determine input intensity  */
+  if (high_input != low_input)
+    value = (value - low_input) / (high_input - low_input);
+  else
+    value = (value - low_input);
+
+  value = CLAMP (value, 0.0, 1.0);
+
+  if (inv_gamma != 1.0 && value > 0)
+    value = pow (value, inv_gamma);
+
+  /*  determine the output intensity  */
+  if (high_output >= low_output)
+    value = value * (high_output - low_output) + low_output;
+  else
+    value = low_output - value * (low_output - high_output);
+
+  return value;
+}
+
+void
+beautify_adjust_levels (BeautifyAdjust *adjust,
+                        gint            low_input,
+                        gint            high_input,
+                        gdouble         gamma,
+                        gint            low_output,
+                        gint            high_output)
+{
+  guchar map[256];
+  gint   c, i;
+
+  for (i = 0; i < 256; i++)
+  {
+    gdouble value = levels_map (i / 255.0,
+                                1.0 / gamma,
+                                low_input / 255.0, high_input / 255.0,
+                                low_output / 255.0, high_output / 255.0);
+
+    map[i] = CLAMP (ROUND (value * 255.0), 0, 255);
+  }
+
+  /* chain with the curves and levels set before */
+  for (c = 0; c < 3; c++)
+    for (i = 0; i < 256; i++)
+      adjust->levels_lut[c][i] = map[adjust->levels_lut[c][i]];
+
+  adjust->levels = TRUE;
+}
+
+void
+beautify_adjust_curves (BeautifyAdjust *adjust,
+                        const ColorLut *lut)
+{
+  gint c, i;
+
+  if (color_lut_is_identity (lut))
+    return;
+
+  for (c = 0; c < 3; c++)
+    for (i = 0; i < 256; i++)
+      adjust->levels_lut[c][i] =
+        lut->lut[COLOR_LUT_RED + c][lut->lut[COLOR_LUT_VALUE][adjust->levels_lut[c][i]]];
+
+  adjust->levels = TRUE;
+}
+
+void
+beautify_adjust_hue_saturation (BeautifyAdjust *adjust,
+                                gdouble         hue,
+                                gdouble         saturation)
+{
+  gint i;
+
+  /* hue_saturation_calculate_transfers (), all hue ranges are the same */
+  gint hue_value = hue * 255.0 / 360.0;
+  gint saturation_value = CLAMP ((gint) (saturation * 255.0 / 100.0), -255, 255);
+
+  for (i = 0; i < 256; i++)
+  {
+    if ((i + hue_value) < 0)
+      adjust->hue_transfer[i] = 255 + (i + hue_value);
+    else if ((i + hue_value) > 255)
+      adjust->hue_transfer[i] = i + hue_value - 255;
+    else
+      adjust->hue_transfer[i] = i + hue_value;
+
+    adjust->saturation_transfer[i] = CLAMP ((i * (255 + saturation_value)) / 255, 0, 255);
+  }
+
+  adjust->hue_saturation = TRUE;
+}
+
+void
+beautify_adjust_color_balance (BeautifyAdjust   *adjust,
+                               GimpTransferMode  transfer_mode,
+                               gboolean          preserve_lum,
+                               gdouble           cyan_red,
+                               gdouble           magenta_green,
+                               gdouble           yellow_blue)
+{
+  adjust->color_balance[transfer_mode] = TRUE;
+  adjust->preserve_lum[transfer_mode] = preserve_lum;
+  adjust->balance[transfer_mode][0] = cyan_red / 100.0;
+  adjust->balance[transfer_mode][1] = magenta_green / 100.0;
+  adjust->balance[transfer_mode][2] = yellow_blue / 100.0;
+}
+
+gboolean
+beautify_adjust_is_identity (const BeautifyAdjust *adjust)
+{
+  return (!adjust->levels && !adjust->hue_saturation &&
+          !adjust->color_balance[GIMP_SHADOWS] &&
+          !adjust->color_balance[GIMP_MIDTONES] &&
+          !adjust->color_balance[GIMP_HIGHLIGHTS]);
+}
+
+/* the weight of a transfer mode at a lightness, see
+ * gimp_operation_color_balance_map ()
+ */
+static inline gdouble
+color_balance_weight (GimpTransferMode transfer_mode,
+                      gdouble          lightness)
+{
+  static const gdouble a = 0.25, b = 0.333, scale = 0.7;
+
+  switch (transfer_mode)
+  {
+    case GIMP_SHADOWS:
+      return CLAMP ((lightness - b) / -a + 0.5, 0, 1) * scale;
+    case GIMP_MIDTONES:
+      return (CLAMP ((lightness - b) /  a + 0.5, 0, 1) *
+              CLAMP ((lightness + b - 1) / -a + 0.5, 0, 1) * scale);
+    case GIMP_HIGHLIGHTS:
+      return CLAMP ((lightness + b - 1) /  a + 0.5, 0, 1) * scale;
+  }
+
+  return 0;
+}
+
+static inline void
+color_balance (const BeautifyAdjust *adjust,
+               GimpRGB              *rgb)
+{
+  gint mode;
+
+  for (mode = GIMP_SHADOWS; mode <= GIMP_HIGHLIGHTS; mode++)
+  {
+    GimpHSL hsl;
+    GimpRGB out;
+
+    if (!adjust->color_balance[mode])
+      continue;
+
+    gimp_rgb_to_hsl (rgb, &hsl);
+
+    gdouble weight = color_balance_weight (mode, hsl.l);
+
+    out.r = CLAMP (rgb->r + adjust->balance[mode][0] * weight, 0.0, 1.0);
+    out.g = CLAMP (rgb->g + adjust->balance[mode][1] * weight, 0.0, 1.0);
+    out.b = CLAMP (rgb->b + adjust->balance[mode][2] * weight, 0.0, 1.0);
+    out.a = rgb->a;
+
+    if (adjust->preserve_lum[mode])
+    {
+      GimpHSL out_hsl;
+
+      gimp_rgb_to_hsl (&out, &out_hsl);
+      out_hsl.l = hsl.l;
+      gimp_hsl_to_rgb (&out_hsl, &out);
+    }
+
+    *rgb = out;
+  }
+}
+
+void
+beautify_adjust_pixels (const guchar *src,
+                        guchar       *dest,
+                        gint          n_pixels,
+                        gint          bpp,
+                        gpointer      data)
+{
+  const BeautifyAdjust *adjust = data;
+  const guchar         *r_lut = adjust->levels_lut[0];
+  const guchar         *g_lut = adjust->levels_lut[1];
+  const guchar         *b_lut = adjust->levels_lut[2];
+  gboolean              has_color = (bpp >= 3);
+  gboolean              has_balance = (adjust->color_balance[GIMP_SHADOWS] ||
+                                       adjust->color_balance[GIMP_MIDTONES] ||
+                                       adjust->color_balance[GIMP_HIGHLIGHTS]);
+  gint                  alpha = (bpp == 2 || bpp == 4) ? bpp - 1 : -1;
+
+  if (!has_color)
+  {
+    /* hue, saturation and color balance leave gray alone */
+    for (; n_pixels--; src += bpp, dest += bpp)
+    {
+      dest[0] = r_lut[src[0]];
+      if (alpha > 0)
+        dest[alpha] = src[alpha];
+    }
+    return;
+  }
+
+  for (; n_pixels--; src += bpp, dest += bpp)
+  {
+    gint r = r_lut[src[0]];
+    gint g = g_lut[src[1]];
+    gint b = b_lut[src[2]];
+
+    if (adjust->hue_saturation)
+    {
+      gimp_rgb_to_hsl_int (&r, &g, &b);
+      r = adjust->hue_transfer[r];
+      g = adjust->saturation_transfer[g];
+      gimp_hsl_to_rgb_int (&r, &g, &b);
+    }
+
+    if (has_balance)
+    {
+      GimpRGB rgb = { r / 255.0, g / 255.0, b / 255.0, 1.0 };
+
+      color_balance (adjust, &rgb);
+
+      r = ROUND (rgb.r * 255.0);
+      g = ROUND (rgb.g * 255.0);
+      b = ROUND (rgb.b * 255.0);
+    }
+
+    dest[0] = r;
+    dest[1] = g;
+    dest[2] = b;
+    if (alpha > 0)
+      dest[alpha] = src[alpha];
+  }
+}
+
+void
+beautify_adjust_run (gint32                drawable_ID,
+                     const BeautifyAdjust *adjust)
+{
+  if (beautify_adjust_is_identity (adjust))
+    return;
+
+  pixel_kernel_run (drawable_ID, beautify_adjust_pixels, (gpointer) adjust);
+}
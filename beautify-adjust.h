@@ -0,0 +1,78 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The point operations of the adjustment sliders, evaluated together in
+ * one pass over the pixels. Each setter takes the same arguments as the
+ * GIMP procedure it replaces and follows GIMP 2.8's math. Per pixel the
+ * operations run as adjustment () used to call them: levels, hue and
+ * saturation, then color balance for shadows, midtones and highlights.
+ * Curves of the effects run before can be put in front of the levels.
+ */
+typedef struct
+{
+  /* curves and levels, one table per channel, gray uses the first */
+  gboolean levels;
+  guchar   levels_lut[3][256];
+
+  gboolean hue_saturation;
+  guchar   hue_transfer[256];
+  guchar   saturation_transfer[256];
+
+  /* color balance, one pass per transfer mode which is set */
+  gboolean color_balance[3];
+  gboolean preserve_lum[3];
+  gdouble  balance[3][3];
+} BeautifyAdjust;
+
+void beautify_adjust_init           (BeautifyAdjust   *adjust);
+
+/* chain the color channels of lut, before any levels are set */
+void beautify_adjust_curves         (BeautifyAdjust   *adjust,
+                                     const ColorLut   *lut);
+
+/* gimp_levels () on GIMP_HISTOGRAM_VALUE */
+void beautify_adjust_levels         (BeautifyAdjust   *adjust,
+                                     gint              low_input,
+                                     gint              high_input,
+                                     gdouble           gamma,
+                                     gint              low_output,
+                                     gint              high_output);
+
+/* gimp_hue_saturation () on GIMP_ALL_HUES, lightness 0 */
+void beautify_adjust_hue_saturation (BeautifyAdjust   *adjust,
+                                     gdouble           hue,
+                                     gdouble           saturation);
+
+/* gimp_color_balance () */
+void beautify_adjust_color_balance  (BeautifyAdjust   *adjust,
+                                     GimpTransferMode  transfer_mode,
+                                     gboolean          preserve_lum,
+                                     gdouble           cyan_red,
+                                     gdouble           magenta_green,
+                                     gdouble           yellow_blue);
+
+gboolean beautify_adjust_is_identity (const BeautifyAdjust *adjust);
+
+/* process pixels, a PixelKernelFunc */
+void beautify_adjust_pixels         (const guchar     *src,
+                                     guchar           *dest,
+                                     gint              n_pixels,
+                                     gint              bpp,
+                                     gpointer          data);
+
+void beautify_adjust_run            (gint32                drawable_ID,
+                                     const BeautifyAdjust *adjust);
@@ -20,8 +20,10 @@
 // fix gimp-2.6 issue: Procedure 'gimp-layer-new' has been called with value '100' for argument 'mode'
 #include <libgimp/gimpui.h>
 
+#include "color-lut.h"
 #include "beautify-effect.h"
 #include "beautify-textures.h"
+#include "image-stats.h"
 
 static void black_and_white (gint32 image_ID, gint32 drawable_ID)
 {
@@ -49,96 +51,82 @@ static void black_and_white (gint32 image_ID, gint32 drawable_ID)
   //gimp_desaturate_full (drawable_ID, GIMP_DESATURATE_LUMINOSITY);
 }
 
-void
-run_effect (gint32 image_ID, BeautifyEffectType effect)
-{
-  gimp_context_push ();
-
-  gint32 layer = gimp_image_get_active_layer (image_ID);
-  gint32 effect_layer = gimp_layer_copy (layer);
-  gimp_image_add_layer (image_ID, effect_layer, -1);
-  //gimp_layer_set_lock_alpha (effect_layer, TRUE);
+/* the image run_effect_region () works on is the region at
+ * (region_x, region_y) of an image of full_width x full_height
+ */
+static gint full_width;
+static gint full_height;
+static gint region_x;
+static gint region_y;
 
+/* scale a texture layer to the full image size, but only keep the part
+ * covering the region, so the cost does not depend on the full size
+ */
+static void
+texture_fit (gint32 image_ID, gint32 layer)
+{
   gint width = gimp_image_width (image_ID);
   gint height = gimp_image_height (image_ID);
 
-  switch (effect)
+  if (width == full_width && height == full_height)
   {
-    case BEAUTIFY_EFFECT_SOFT_LIGHT:
-    {
-      gint32     layer;
-
-      layer = gimp_layer_copy (effect_layer);
-      gimp_image_add_layer (image_ID, layer, -1);
-      gimp_levels (layer, GIMP_HISTOGRAM_VALUE, 20, 255, 1, 0, 255);
+    gimp_layer_scale (layer, width, height, FALSE);
+    return;
+  }
 
-      GimpParam *return_vals;
-      gint nreturn_vals;
-      return_vals = gimp_run_procedure ("plug-in-gauss",
-                                        &nreturn_vals,
-                                        GIMP_PDB_INT32, GIMP_RUN_NONINTERACTIVE,
-                                        GIMP_PDB_IMAGE, image_ID,
-                                        GIMP_PDB_DRAWABLE, layer,
-                                        GIMP_PDB_FLOAT, 15.0,
-                                        GIMP_PDB_FLOAT, 15.0,
-                                        GIMP_PDB_INT32, 1,
-                                        GIMP_PDB_END);
-      gimp_destroy_params (return_vals, nreturn_vals);
+  gint    texture_width = gimp_drawable_width (layer);
+  gint    texture_height = gimp_drawable_height (layer);
+  gdouble scale_x = (gdouble) full_width / texture_width;
+  gdouble scale_y = (gdouble) full_height / texture_height;
+
+  /* texture pixels under the region, one more on each side for interpolation */
+  gint x1 = CLAMP (floor (region_x / scale_x) - 1, 0, texture_width - 1);
+  gint y1 = CLAMP (floor (region_y / scale_y) - 1, 0, texture_height - 1);
+  gint x2 = CLAMP (ceil ((region_x + width) / scale_x) + 1, x1 + 1, texture_width);
+  gint y2 = CLAMP (ceil ((region_y + height) / scale_y) + 1, y1 + 1, texture_height);
+
+  gimp_layer_resize (layer, x2 - x1, y2 - y1, -x1, -y1);
+  gimp_layer_scale (layer,
+                    MAX (1, ROUND (x2 * scale_x) - ROUND (x1 * scale_x)),
+                    MAX (1, ROUND (y2 * scale_y) - ROUND (y1 * scale_y)),
+                    FALSE);
+  gimp_layer_set_offsets (layer,
+                          ROUND (x1 * scale_x) - region_x,
+                          ROUND (y1 * scale_y) - region_y);
+}
 
-      gimp_layer_set_mode (layer, GIMP_SCREEN_MODE);
-      gimp_layer_set_opacity (layer, 35);
-      gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_IMAGE);
+/* the effects which are nothing but curves */
+typedef struct
+{
+  BeautifyEffectType effect;
+  gint               num_points[3];
+  guint8             control_pts[3][34];
+} CurvesEffect;
 
-      break;
-    }
-    case BEAUTIFY_EFFECT_WARM:
+static const CurvesEffect curves_effects[] =
+{
+  {
+    BEAUTIFY_EFFECT_WARM,
+    { 6, 6, 0 },
     {
-      guint8 red_pts[] = {
+      {
         0.0, 0.082031 * 255,
         0.405488 * 255, 0.621094 * 255,
         0.954268 * 255, 1.000000 * 255,
-      };
-      guint8 green_pts[] = {
+      },
+      {
         0.0, 0.0,
         0.503049 * 255, 0.636719 * 255,
         1.000000 * 255, 1.000000 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 6, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 6, green_pts);
-    }
-      break;
-
-    case BEAUTIFY_EFFECT_SHARPEN:
-    {
-      gint nreturn_vals;
-      GimpParam *return_vals = gimp_run_procedure ("plug-in-sharpen",
-                                                   &nreturn_vals,
-                                                   GIMP_PDB_INT32, 1,
-                                                   GIMP_PDB_IMAGE, image_ID,
-                                                   GIMP_PDB_DRAWABLE, effect_layer,
-                                                   GIMP_PDB_INT32, 50,
-                                                   GIMP_PDB_END);
-      gimp_destroy_params (return_vals, nreturn_vals);
-      break;
-    }
-    case BEAUTIFY_EFFECT_SOFT:
-    {
-      gint nreturn_vals;
-      GimpParam *return_vals = gimp_run_procedure ("plug-in-gauss",
-                                                   &nreturn_vals,
-                                                   GIMP_PDB_INT32, 1,
-                                                   GIMP_PDB_IMAGE, image_ID,
-                                                   GIMP_PDB_DRAWABLE, effect_layer,
-                                                   GIMP_PDB_FLOAT, 1.2,
-                                                   GIMP_PDB_FLOAT, 1.2,
-                                                   GIMP_PDB_INT32, 1,
-                                                   GIMP_PDB_END);
-      gimp_destroy_params (return_vals, nreturn_vals);
-      break;
-    }
-    case BEAUTIFY_EFFECT_STRONG_CONTRAST:
+      },
+      { 0 },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_STRONG_CONTRAST,
+    { 18, 18, 18 },
     {
-      guint8 red_pts[] = {
+      {
         0.000000 * 255, 0.003922 * 255,
         0.121569 * 255, 0.039216 * 255,
         0.247059 * 255, 0.105882 * 255,
@@ -148,8 +136,8 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.858824 * 255,
         0.874510 * 255, 0.929412 * 255,
         1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 green_pts[] = {
+      },
+      {
         0.000000 * 255, 0.003922 * 255,
         0.121569 * 255, 0.027451 * 255,
         0.247059 * 255, 0.117647 * 255,
@@ -159,8 +147,8 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.890196 * 255,
         0.874510 * 255, 0.952941 * 255,
         1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 blue_pts[] = {
+      },
+      {
         0.000000 * 255, 0.003922 * 255,
         0.121569 * 255, 0.050980 * 255,
         0.247059 * 255, 0.133333 * 255,
@@ -170,194 +158,41 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.874510 * 255,
         0.874510 * 255, 0.941176 * 255,
         1.000000 * 255, 1.000000 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
-    }
-    case BEAUTIFY_EFFECT_SMART_COLOR:
-    {
-      guint8 red_pts[] = {
-        0.0, 0.001012 * 255, 0.121569 * 255, 0.126695 * 255,
-        0.247059 * 255, 0.279821 * 255, 0.372549 * 255, 0.428038 * 255,
-        0.498039 * 255, 0.567700 * 255, 0.623529 * 255, 0.699439 * 255,
-        0.749020 * 255, 0.821423 * 255, 0.874510 * 255, 0.953474 * 255,
-        1.000000 * 255, 0.997988 * 255,
-      };
-      guint8 green_pts[] = {
-        0.0, 0.004278 * 255, 0.121569 * 255, 0.107139 * 255,
-        0.247059 * 255, 0.225961 * 255, 0.372549 * 255, 0.346578 * 255,
-        0.498039 * 255, 0.472647 * 255, 0.623529 * 255, 0.602136 * 255,
-        0.749020 * 255, 0.730046 * 255, 0.874510 * 255, 0.873495 * 255,
-        1.000000 * 255, 0.996787 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.0, 0.000105 * 255, 0.121569 * 255, 0.060601 * 255,
-        0.247059 * 255, 0.146772 * 255, 0.372549 * 255, 0.262680 * 255,
-        0.498039 * 255, 0.408053 * 255, 0.623529 * 255, 0.566459 * 255,
-        0.749020 * 255, 0.691468 * 255, 0.874510 * 255, 0.847356 * 255,
-        1.000000 * 255, 0.999226 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-    }
-      break;
-    case BEAUTIFY_EFFECT_BLACK_AND_WHITE:
-    {
-      black_and_white (image_ID, effect_layer);
-      break;
-    }
-    case BEAUTIFY_EFFECT_INVERT:
-      gimp_invert (effect_layer);
-      break;
-    case BEAUTIFY_EFFECT_CLASSIC_LOMO:
-    {
-      gint32     layer;
-      GdkPixbuf *pixbuf;
-
-      pixbuf = gdk_pixbuf_new_from_inline (-1, texture_classic_LOMO_1, FALSE, NULL);
-      layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_OVERLAY_MODE, 0, 0);
-      gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
-      gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
-
-      guint8 red_pts[] = {
-        0.000000 * 255, 0.000430 * 255,
-        0.121569 * 255, 0.034226 * 255,
-        0.247059 * 255, 0.156268 * 255,
-        0.372549 * 255, 0.337497 * 255,
-        0.498039 * 255, 0.542195 * 255,
-        0.623529 * 255, 0.728355 * 255,
-        0.749020 * 255, 0.862534 * 255,
-        0.874510 * 255, 0.942754 * 255,
-        1.000000 * 255, 0.994413 * 255,
-      };
-      guint8 green_pts[] = {
-        0.000000 * 255, 0.000167 * 255,
-        0.121569 * 255, 0.023472 * 255,
-        0.247059 * 255, 0.139498 * 255,
-        0.372549 * 255, 0.318074 * 255,
-        0.498039 * 255, 0.520901 * 255,
-        0.623529 * 255, 0.705862 * 255,
-        0.749020 * 255, 0.849380 * 255,
-        0.874510 * 255, 0.952092 * 255,
-        1.000000 * 255, 0.994484 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.000000 * 255, 0.000377 * 255,
-        0.121569 * 255, 0.030137 * 255,
-        0.247059 * 255, 0.160170 * 255,
-        0.372549 * 255, 0.335944 * 255,
-        0.498039 * 255, 0.545279 * 255,
-        0.623529 * 255, 0.719690 * 255,
-        0.749020 * 255, 0.867722 * 255,
-        0.874510 * 255, 0.965811 * 255,
-        1.000000 * 255, 0.995110 * 255,
-      };
-      layer = gimp_image_get_active_layer (image_ID);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-
-      pixbuf = gdk_pixbuf_new_from_inline (-1, texture_classic_LOMO_2, FALSE, NULL);
-      layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_MULTIPLY_MODE, 0, 0);
-      gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
-      gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
-
-      break;
-    }
-    case BEAUTIFY_EFFECT_RETRO_LOMO:
-    {
-      guint8 red_pts[] = {
-        0.000000 * 255, 0.009477 * 255,
-        0.121569 * 255, 0.066342 * 255,
-        0.247059 * 255, 0.211570 * 255,
-        0.372549 * 255, 0.391796 * 255,
-        0.498039 * 255, 0.576389 * 255,
-        0.623529 * 255, 0.745091 * 255,
-        0.749020 * 255, 0.875015 * 255,
-        0.874510 * 255, 0.959604 * 255,
-        1.000000 * 255, 0.989234 * 255,
-      };
-      guint8 green_pts[] = {
-        0.000000 * 255, 0.075980 * 255,
-        0.121569 * 255, 0.176692 * 255,
-        0.247059 * 255, 0.294329 * 255,
-        0.372549 * 255, 0.415297 * 255,
-        0.498039 * 255, 0.536491 * 255,
-        0.623529 * 255, 0.651230 * 255,
-        0.749020 * 255, 0.751355 * 255,
-        0.874510 * 255, 0.843675 * 255,
-        1.000000 * 255, 0.921772 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.000000 * 255, 0.246068 * 255,
-        0.121569 * 255, 0.310134 * 255,
-        0.247059 * 255, 0.373558 * 255,
-        0.372549 * 255, 0.435251 * 255,
-        0.498039 * 255, 0.503361 * 255,
-        0.623529 * 255, 0.565592 * 255,
-        0.749020 * 255, 0.629995 * 255,
-        0.874510 * 255, 0.690267 * 255,
-        1.000000 * 255, 0.751997 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-
-      gint       nreturn_vals;
-      GimpParam *return_vals;
-
-      return_vals = gimp_run_procedure ("plug-in-rgb-noise",
-                                        &nreturn_vals,
-                                        GIMP_PDB_INT32, 1,
-                                        GIMP_PDB_IMAGE, image_ID,
-                                        GIMP_PDB_DRAWABLE, effect_layer,
-                                        GIMP_PDB_INT32, 0,
-                                        GIMP_PDB_INT32, 0,
-                                        GIMP_PDB_FLOAT, 0.03,
-                                        GIMP_PDB_FLOAT, 0.03,
-                                        GIMP_PDB_FLOAT, 0.03,
-                                        GIMP_PDB_FLOAT, 0.03,
-                                        GIMP_PDB_END);
-      gimp_destroy_params (return_vals, nreturn_vals);
-
-      break;
-    }
-    case BEAUTIFY_EFFECT_GOTHIC_STYLE:
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_GOTHIC_STYLE,
+    { 18, 18, 18 },
     {
-      guint8 red_pts[] = {
+      {
         0.0, 0.003922 * 255, 0.121569 * 255, 0.011765 * 255,
         0.247059 * 255, 0.074510 * 255, 0.372549 * 255, 0.200000 * 255,
         0.498039 * 255, 0.380392 * 255, 0.623529 * 255, 0.584314 * 255,
         0.749020 * 255, 0.784314 * 255, 0.874510 * 255, 0.933333 * 255,
         1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 green_pts[] = {
+      },
+      {
         0.0, 0.003922 * 255, 0.121569 * 255, 0.039216 * 255,
         0.247059 * 255, 0.160784 * 255, 0.372549 * 255, 0.317647 * 255,
         0.498039 * 255, 0.501961 * 255, 0.623529 * 255, 0.682353 * 255,
         0.749020 * 255, 0.843137 * 255, 0.874510 * 255, 0.952941 * 255,
         1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 blue_pts[] = {
+      },
+      {
         0.0, 0.003922 * 255, 0.121569 * 255, 0.007843 * 255,
         0.247059 * 255, 0.058824 * 255, 0.372549 * 255, 0.172549 * 255,
         0.498039 * 255, 0.349020 * 255, 0.623529 * 255, 0.556863 * 255,
         0.749020 * 255, 0.768627 * 255, 0.874510 * 255, 0.929412 * 255,
         1.000000 * 255, 1.000000 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-    }
-      break;
-    case BEAUTIFY_EFFECT_FILM:
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_FILM,
+    { 18, 18, 18 },
     {
-      guint8 red_pts[] = {
+      {
         0.000000 * 255, 0.101961 * 255,
         0.121569 * 255, 0.101961 * 255,
         0.247059 * 255, 0.164706 * 255,
@@ -367,8 +202,8 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.850980 * 255,
         0.874510 * 255, 0.956863 * 255,
         1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 green_pts[] = {
+      },
+      {
         0.000000 * 255, 0.192157 * 255,
         0.121569 * 255, 0.192157 * 255,
         0.247059 * 255, 0.192157 * 255,
@@ -378,8 +213,8 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.850980 * 255,
         0.874510 * 255, 0.956863 * 255,
         1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 blue_pts[] = {
+      },
+      {
         0.000000 * 255, 0.266667 * 255,
         0.121569 * 255, 0.266667 * 255,
         0.247059 * 255, 0.266667 * 255,
@@ -389,15 +224,14 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.827451 * 255,
         0.874510 * 255, 0.949020 * 255,
         1.000000 * 255, 1.000000 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
-    }
-    case BEAUTIFY_EFFECT_HDR:
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_HDR,
+    { 18, 18, 18 },
     {
-      guint8 red_pts[] = {
+      {
         0.000000 * 255, 0.003922 * 255,
         0.121569 * 255, 0.015686 * 255,
         0.247059 * 255, 0.207843 * 255,
@@ -407,8 +241,8 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.811765 * 255,
         0.874510 * 255, 0.909804 * 255,
         1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 green_pts[] = {
+      },
+      {
         0.000000 * 255, 0.003922 * 255,
         0.121569 * 255, 0.015686 * 255,
         0.247059 * 255, 0.200000 * 255,
@@ -418,8 +252,8 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.800000 * 255,
         0.874510 * 255, 0.901961 * 255,
         1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 blue_pts[] = {
+      },
+      {
         0.000000 * 255, 0.054902 * 255,
         0.121569 * 255, 0.121569 * 255,
         0.247059 * 255, 0.262745 * 255,
@@ -429,93 +263,41 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.780392 * 255,
         0.874510 * 255, 0.890196 * 255,
         1.000000 * 255, 1.000000 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
-    }
-    case BEAUTIFY_EFFECT_CLASSIC_HDR:
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_CLASSIC_HDR,
+    { 18, 18, 18 },
     {
-      guint8 red_pts[] = {
+      {
         0.0, 0.054902 * 255, 0.121569 * 255, 0.070588 * 255,
         0.247059 * 255, 0.243137 * 255, 0.372549 * 255, 0.407843 * 255,
         0.498039 * 255, 0.552941 * 255, 0.623529 * 255, 0.678431 * 255,
         0.749020 * 255, 0.780392 * 255, 0.874510 * 255, 0.866667 * 255,
         1.000000 * 255, 0.949020 * 255,
-      };
-      guint8 green_pts[] = {
+      },
+      {
         0.0, 0.007843 * 255, 0.121569 * 255, 0.023529 * 255,
         0.247059 * 255, 0.207843 * 255, 0.372549 * 255, 0.388235 * 255,
         0.498039 * 255, 0.541176 * 255, 0.623529 * 255, 0.682353 * 255,
         0.749020 * 255, 0.796078 * 255, 0.874510 * 255, 0.898039 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      guint8 blue_pts[] = {
+      },
+      {
         0.0, 0.258824 * 255, 0.121569 * 255, 0.294118 * 255,
         0.247059 * 255, 0.372549 * 255, 0.372549 * 255, 0.450980 * 255,
         0.498039 * 255, 0.521569 * 255, 0.623529 * 255, 0.592157 * 255,
         0.749020 * 255, 0.654902 * 255, 0.874510 * 255, 0.717647 * 255,
         1.000000 * 255, 0.776471 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-    }
-      break;
-    case BEAUTIFY_EFFECT_YELLOWING_DARK_CORNERS:
-    {
-      guint8 red_pts[] = {
-        0.000000 * 255, 0.093137 * 255,
-        0.121569 * 255, 0.125134 * 255,
-        0.247059 * 255, 0.227000 * 255,
-        0.372549 * 255, 0.372794 * 255,
-        0.498039 * 255, 0.537491 * 255,
-        0.623529 * 255, 0.706434 * 255,
-        0.749020 * 255, 0.852155 * 255,
-        0.874510 * 255, 0.953969 * 255,
-        1.000000 * 255, 0.996078 * 255,
-      };
-      guint8 green_pts[] = {
-        0.000000 * 255, 0.092647 * 255,
-        0.121569 * 255, 0.125205 * 255,
-        0.247059 * 255, 0.227129 * 255,
-        0.372549 * 255, 0.372871 * 255,
-        0.498039 * 255, 0.537711 * 255,
-        0.623529 * 255, 0.706357 * 255,
-        0.749020 * 255, 0.851153 * 255,
-        0.874510 * 255, 0.953240 * 255,
-        1.000000 * 255, 0.996078 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.000000 * 255, 0.003922 * 255,
-        0.121569 * 255, 0.029810 * 255,
-        0.247059 * 255, 0.143778 * 255,
-        0.372549 * 255, 0.305764 * 255,
-        0.498039 * 255, 0.488796 * 255,
-        0.623529 * 255, 0.672134 * 255,
-        0.749020 * 255, 0.833704 * 255,
-        0.874510 * 255, 0.948010 * 255,
-        1.000000 * 255, 0.996078 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-
-      gint32     layer;
-      GdkPixbuf *pixbuf;
-
-      pixbuf = gdk_pixbuf_new_from_inline (-1, texture_yellowing_dark_corners, FALSE, NULL);
-      layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_MULTIPLY_MODE, 0, 0);
-      gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
-      gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
-
-      break;
-    }
-    case BEAUTIFY_EFFECT_IMPRESSION:
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_IMPRESSION,
+    { 18, 18, 18 },
     {
-      guint8 red_pts[] = {
+      {
         0.000000 * 255, 0.113725 * 255,
         0.121569 * 255, 0.213975 * 255,
         0.247059 * 255, 0.323494 * 255,
@@ -525,8 +307,8 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.766909 * 255,
         0.874510 * 255, 0.817666 * 255,
         1.000000 * 255, 0.862745 * 255,
-      };
-      guint8 green_pts[] = {
+      },
+      {
         0.000000 * 255, 0.200000 * 255,
         0.121569 * 255, 0.317329 * 255,
         0.247059 * 255, 0.407881 * 255,
@@ -536,8 +318,8 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.813005 * 255,
         0.874510 * 255, 0.852891 * 255,
         1.000000 * 255, 0.902716 * 255,
-      };
-      guint8 blue_pts[] = {
+      },
+      {
         0.000000 * 255, 0.317714 * 255,
         0.121569 * 255, 0.364205 * 255,
         0.247059 * 255, 0.417294 * 255,
@@ -547,15 +329,14 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.795937 * 255,
         0.874510 * 255, 0.845977 * 255,
         1.000000 * 255, 0.883024 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
-    }
-    case BEAUTIFY_EFFECT_DEEP_BLUE_TEAR_RAIN:
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_DEEP_BLUE_TEAR_RAIN,
+    { 18, 18, 18 },
     {
-      guint8 red_pts[] = {
+      {
         0.000000 * 255, 0.003922 * 255,
         0.121569 * 255, 0.094118 * 255,
         0.247059 * 255, 0.254902 * 255,
@@ -565,8 +346,8 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.850980 * 255,
         0.874510 * 255, 0.941176 * 255,
         1.000000 * 255, 0.992157 * 255,
-      };
-      guint8 green_pts[] = {
+      },
+      {
         0.000000 * 255, 0.019608 * 255,
         0.121569 * 255, 0.164706 * 255,
         0.247059 * 255, 0.337255 * 255,
@@ -576,8 +357,8 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.878431 * 255,
         0.874510 * 255, 0.941176 * 255,
         1.000000 * 255, 0.992157 * 255,
-      };
-      guint8 blue_pts[] = {
+      },
+      {
         0.000000 * 255, 0.133333 * 255,
         0.121569 * 255, 0.333333 * 255,
         0.247059 * 255, 0.494118 * 255,
@@ -587,15 +368,14 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.913725 * 255,
         0.874510 * 255, 0.964706 * 255,
         1.000000 * 255, 0.988235 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
-    }
-    case BEAUTIFY_EFFECT_PURPLE_SENSATION:
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_PURPLE_SENSATION,
+    { 18, 18, 18 },
     {
-      guint8 red_pts[] = {
+      {
         0.000000 * 255, 0.003922 * 255,
         0.121569 * 255, 0.003922 * 255,
         0.247059 * 255, 0.149020 * 255,
@@ -605,8 +385,8 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.870588 * 255,
         0.874510 * 255, 0.960784 * 255,
         1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 green_pts[] = {
+      },
+      {
         0.000000 * 255, 0.003922 * 255,
         0.121569 * 255, 0.003922 * 255,
         0.247059 * 255, 0.003922 * 255,
@@ -616,8 +396,8 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.862745 * 255,
         0.874510 * 255, 0.952941 * 255,
         1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 blue_pts[] = {
+      },
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.070588 * 255,
         0.247059 * 255, 0.313725 * 255,
@@ -627,15 +407,14 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.905882 * 255,
         0.874510 * 255, 0.968627 * 255,
         1.000000 * 255, 1.000000 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
-    }
-    case BEAUTIFY_EFFECT_BRONZE:
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_BRONZE,
+    { 18, 18, 18 },
     {
-      guint8 red_pts[] = {
+      {
         0.000000 * 255, 0.003922 * 255,
         0.121569 * 255, 0.078431 * 255,
         0.247059 * 255, 0.196078 * 255,
@@ -645,32 +424,1034 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
         0.749020 * 255, 0.729412 * 255,
         0.874510 * 255, 0.729412 * 255,
         1.000000 * 255, 0.729412 * 255,
+      },
+      {
+        0.000000 * 255, 0.003922 * 255,
+        0.121569 * 255, 0.078431 * 255,
+        0.247059 * 255, 0.196078 * 255,
+        0.372549 * 255, 0.341176 * 255,
+        0.498039 * 255, 0.494118 * 255,
+        0.623529 * 255, 0.650980 * 255,
+        0.749020 * 255, 0.792157 * 255,
+        0.874510 * 255, 0.913725 * 255,
+        1.000000 * 255, 0.925490 * 255,
+      },
+      {
+        0.000000 * 255, 0.450980 * 255,
+        0.121569 * 255, 0.450980 * 255,
+        0.247059 * 255, 0.450980 * 255,
+        0.372549 * 255, 0.450980 * 255,
+        0.498039 * 255, 0.494118 * 255,
+        0.623529 * 255, 0.650980 * 255,
+        0.749020 * 255, 0.792157 * 255,
+        0.874510 * 255, 0.913725 * 255,
+        1.000000 * 255, 1.000000 * 255,
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_LITTLE_FRESH,
+    { 18, 18, 18 },
+    {
+      {
+        0.0, 0.002975 * 255, 0.121569 * 255, 0.135413 * 255,
+        0.247059 * 255, 0.271797 * 255, 0.372549 * 255, 0.420642 * 255,
+        0.498039 * 255, 0.587088 * 255, 0.623529 * 255, 0.672206 * 255,
+        0.749020 * 255, 0.781208 * 255, 0.874510 * 255, 0.881668 * 255,
+        1.000000 * 255, 0.993149 * 255,
+      },
+      {
+        0.0, 0.001070 * 255, 0.121569 * 255, 0.123393 * 255,
+        0.247059 * 255, 0.254300 * 255, 0.372549 * 255, 0.377336 * 255,
+        0.498039 * 255, 0.486582 * 255, 0.623529 * 255, 0.607331 * 255,
+        0.749020 * 255, 0.722174 * 255, 0.874510 * 255, 0.858206 * 255,
+        1.000000 * 255, 0.992154 * 255,
+      },
+      {
+        0.0, 0.003917 * 255, 0.121569 * 255, 0.098807 * 255,
+        0.247059 * 255, 0.234746 * 255, 0.372549 * 255, 0.378388 * 255,
+        0.498039 * 255, 0.520273 * 255, 0.623529 * 255, 0.633239 * 255,
+        0.749020 * 255, 0.748242 * 255, 0.874510 * 255, 0.862234 * 255,
+        1.000000 * 255, 0.964176 * 255,
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_CLASSIC_STUDIO,
+    { 18, 18, 18 },
+    {
+      {
+        0.000000 * 255, 0.002941 * 255,
+        0.121569 * 255, 0.105177 * 255,
+        0.247059 * 255, 0.276869 * 255,
+        0.372549 * 255, 0.449951 * 255,
+        0.498039 * 255, 0.615011 * 255,
+        0.623529 * 255, 0.765528 * 255,
+        0.749020 * 255, 0.884498 * 255,
+        0.874510 * 255, 0.964439 * 255,
+        1.000000 * 255, 0.996641 * 255,
+      },
+      {
+        0.000000 * 255, 0.000980 * 255,
+        0.121569 * 255, 0.023976 * 255,
+        0.247059 * 255, 0.117564 * 255,
+        0.372549 * 255, 0.268570 * 255,
+        0.498039 * 255, 0.450785 * 255,
+        0.623529 * 255, 0.640827 * 255,
+        0.749020 * 255, 0.821280 * 255,
+        0.874510 * 255, 0.944143 * 255,
+        1.000000 * 255, 0.994046 * 255,
+      },
+      {
+        0.000000 * 255, 0.001705 * 255,
+        0.121569 * 255, 0.091176 * 255,
+        0.247059 * 255, 0.255272 * 255,
+        0.372549 * 255, 0.426934 * 255,
+        0.498039 * 255, 0.599930 * 255,
+        0.623529 * 255, 0.749604 * 255,
+        0.749020 * 255, 0.879809 * 255,
+        0.874510 * 255, 0.963030 * 255,
+        1.000000 * 255, 0.994565 * 255,
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_RETRO,
+    { 18, 18, 18 },
+    {
+      {
+        0.000000 * 255, 0.011765 * 255,
+        0.121569 * 255, 0.050275 * 255,
+        0.247059 * 255, 0.163976 * 255,
+        0.372549 * 255, 0.316983 * 255,
+        0.498039 * 255, 0.493141 * 255,
+        0.623529 * 255, 0.671170 * 255,
+        0.749020 * 255, 0.829955 * 255,
+        0.874510 * 255, 0.941938 * 255,
+        1.000000 * 255, 0.988797 * 255,
+      },
+      {
+        0.000000 * 255, 0.044118 * 255,
+        0.121569 * 255, 0.081048 * 255,
+        0.247059 * 255, 0.181188 * 255,
+        0.372549 * 255, 0.327417 * 255,
+        0.498039 * 255, 0.493717 * 255,
+        0.623529 * 255, 0.658936 * 255,
+        0.749020 * 255, 0.811563 * 255,
+        0.874510 * 255, 0.915557 * 255,
+        1.000000 * 255, 0.956299 * 255,
+      },
+      {
+        0.000000 * 255, 0.247630 * 255,
+        0.121569 * 255, 0.268491 * 255,
+        0.247059 * 255, 0.325230 * 255,
+        0.372549 * 255, 0.405204 * 255,
+        0.498039 * 255, 0.497829 * 255,
+        0.623529 * 255, 0.588839 * 255,
+        0.749020 * 255, 0.675181 * 255,
+        0.874510 * 255, 0.731610 * 255,
+        1.000000 * 255, 0.752075 * 255,
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_PINK_LADY,
+    { 18, 18, 18 },
+    {
+      {
+        0.000000 * 255, 0.003922 * 255,
+        0.121569 * 255, 0.196078 * 255,
+        0.247059 * 255, 0.356863 * 255,
+        0.372549 * 255, 0.509804 * 255,
+        0.498039 * 255, 0.647059 * 255,
+        0.623529 * 255, 0.760784 * 255,
+        0.749020 * 255, 0.858824 * 255,
+        0.874510 * 255, 0.937255 * 255,
+        1.000000 * 255, 1.000000 * 255,
+      },
+      {
+        0.000000 * 255, 0.003922 * 255,
+        0.121569 * 255, 0.180392 * 255,
+        0.247059 * 255, 0.329412 * 255,
+        0.372549 * 255, 0.478431 * 255,
+        0.498039 * 255, 0.611765 * 255,
+        0.623529 * 255, 0.729412 * 255,
+        0.749020 * 255, 0.831373 * 255,
+        0.874510 * 255, 0.921569 * 255,
+        1.000000 * 255, 1.000000 * 255,
+      },
+      {
+        0.000000 * 255, 0.003922 * 255,
+        0.121569 * 255, 0.168627 * 255,
+        0.247059 * 255, 0.317647 * 255,
+        0.372549 * 255, 0.458824 * 255,
+        0.498039 * 255, 0.592157 * 255,
+        0.623529 * 255, 0.709804 * 255,
+        0.749020 * 255, 0.819608 * 255,
+        0.874510 * 255, 0.913725 * 255,
+        1.000000 * 255, 1.000000 * 255,
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_ICE_SPIRIT,
+    { 18, 18, 18 },
+    {
+      {
+        0.0, 0.007843 * 255, 0.121569 * 255, 0.141176 * 255,
+        0.247059 * 255, 0.286275 * 255, 0.372549 * 255, 0.423529 * 255,
+        0.498039 * 255, 0.552941 * 255, 0.623529 * 255, 0.674510 * 255,
+        0.749020 * 255, 0.792157 * 255, 0.874510 * 255, 0.898039 * 255,
+        1.000000 * 255, 1.000000 * 255,
+      },
+      {
+        0.0, 0.007843 * 255, 0.121569 * 255, 0.184314 * 255,
+        0.247059 * 255, 0.360784 * 255, 0.372549 * 255, 0.517647 * 255,
+        0.498039 * 255, 0.654902 * 255, 0.623529 * 255, 0.768627 * 255,
+        0.749020 * 255, 0.866667 * 255, 0.874510 * 255, 0.945098 * 255,
+        1.000000 * 255, 1.000000 * 255,
+      },
+      {
+        0.0, 0.007843 * 255, 0.121569 * 255, 0.211765 * 255,
+        0.247059 * 255, 0.407843 * 255, 0.372549 * 255, 0.576471 * 255,
+        0.498039 * 255, 0.717647 * 255, 0.623529 * 255, 0.827451 * 255,
+        0.749020 * 255, 0.913725 * 255, 0.874510 * 255, 0.972549 * 255,
+        1.000000 * 255, 1.000000 * 255,
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_JAPANESE_STYLE,
+    { 18, 18, 18 },
+    {
+      {
+        0.0, 0.098039 * 255, 0.121569 * 255, 0.188479 * 255,
+        0.247059 * 255, 0.329761 * 255, 0.372549 * 255, 0.496682 * 255,
+        0.498039 * 255, 0.657383 * 255, 0.623529 * 255, 0.787002 * 255,
+        0.749020 * 255, 0.864444 * 255, 0.874510 * 255, 0.900704 * 255,
+        1.000000 * 255, 0.917552 * 255,
+      },
+      {
+        0.0, 0.103431 * 255, 0.121569 * 255, 0.224676 * 255,
+        0.247059 * 255, 0.394142 * 255, 0.372549 * 255, 0.541888 * 255,
+        0.498039 * 255, 0.675963 * 255, 0.623529 * 255, 0.785613 * 255,
+        0.749020 * 255, 0.893224 * 255, 0.874510 * 255, 0.943625 * 255,
+        1.000000 * 255, 0.972720 * 255,
+      },
+      {
+        0.0, 0.412025 * 255, 0.121569 * 255, 0.469119 * 255,
+        0.247059 * 255, 0.615777 * 255, 0.372549 * 255, 0.751174 * 255,
+        0.498039 * 255, 0.862955 * 255, 0.623529 * 255, 0.954468 * 255,
+        0.749020 * 255, 0.995760 * 255, 0.874510 * 255, 1.000000 * 255,
+        1.000000 * 255, 1.000000 * 255,
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_NEW_JAPANESE_STYLE,
+    { 10, 10, 6 },
+    {
+      {
+        0.0, 0.042969 * 255,
+        0.350610 * 255, 0.320312 * 255,
+        0.621951 * 255, 0.566406 * 255,
+        0.847561 * 255, 0.632812 * 255,
+        1.000000 * 255, 0.769531 * 255,
+      },
+      {
+        0.0, 0.031250 * 255,
+        0.125000 * 255, 0.144531 * 255,
+        0.500000 * 255, 0.523438 * 255,
+        0.881098 * 255, 0.738281 * 255,
+        1.000000 * 255, 0.882812 * 255,
+      },
+      {
+        0.0, 0.0,
+        0.121951 * 255, 0.039062 * 255,
+        1.000000 * 255, 0.972656 * 255,
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_WARM_YELLOW,
+    { 18, 18, 18 },
+    {
+      {
+        0.0, 0.000980 * 255, 0.121569 * 255, 0.065574 * 255,
+        0.247059 * 255, 0.213677 * 255, 0.372549 * 255, 0.383298 * 255,
+        0.498039 * 255, 0.556855 * 255, 0.623529 * 255, 0.726149 * 255,
+        0.749020 * 255, 0.864046 * 255, 0.874510 * 255, 0.958157 * 255,
+        1.000000 * 255, 0.996641 * 255,
+      },
+      {
+        0.0, 0.005882 * 255, 0.121569 * 255, 0.107837 * 255,
+        0.247059 * 255, 0.276792 * 255, 0.372549 * 255, 0.452811 * 255,
+        0.498039 * 255, 0.617782 * 255, 0.623529 * 255, 0.763782 * 255,
+        0.749020 * 255, 0.886822 * 255, 0.874510 * 255, 0.965223 * 255,
+        1.000000 * 255, 0.996993 * 255,
+      },
+      {
+        0.0, 0.000495 * 255, 0.121569 * 255, 0.035825 * 255,
+        0.247059 * 255, 0.149480 * 255, 0.372549 * 255, 0.305398 * 255,
+        0.498039 * 255, 0.491352 * 255, 0.623529 * 255, 0.670305 * 255,
+        0.749020 * 255, 0.838898 * 255, 0.874510 * 255, 0.951301 * 255,
+        1.000000 * 255, 0.994118 * 255,
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_BLUES,
+    { 18, 18, 18 },
+    {
+      {
+        0.000000 * 255, 0.003922 * 255,
+        0.121569 * 255, 0.321569 * 255,
+        0.247059 * 255, 0.541176 * 255,
+        0.372549 * 255, 0.713725 * 255,
+        0.498039 * 255, 0.831373 * 255,
+        0.623529 * 255, 0.905882 * 255,
+        0.749020 * 255, 0.952941 * 255,
+        0.874510 * 255, 0.980392 * 255,
+        1.000000 * 255, 1.000000 * 255,
+      },
+      {
+        0.000000 * 255, 0.003922 * 255,
+        0.121569 * 255, 0.266667 * 255,
+        0.247059 * 255, 0.466667 * 255,
+        0.372549 * 255, 0.627451 * 255,
+        0.498039 * 255, 0.756863 * 255,
+        0.623529 * 255, 0.847059 * 255,
+        0.749020 * 255, 0.917647 * 255,
+        0.874510 * 255, 0.964706 * 255,
+        1.000000 * 255, 1.000000 * 255,
+      },
+      {
+        0.000000 * 255, 0.007843 * 255,
+        0.121569 * 255, 0.286275 * 255,
+        0.247059 * 255, 0.505882 * 255,
+        0.372549 * 255, 0.682353 * 255,
+        0.498039 * 255, 0.811765 * 255,
+        0.623529 * 255, 0.901961 * 255,
+        0.749020 * 255, 0.960784 * 255,
+        0.874510 * 255, 0.988235 * 255,
+        1.000000 * 255, 0.996078 * 255,
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_COLD_BLUE,
+    { 18, 18, 18 },
+    {
+      {
+        0.000000 * 255, 0.000040 * 255,
+        0.121569 * 255, 0.008043 * 255,
+        0.247059 * 255, 0.066237 * 255,
+        0.372549 * 255, 0.184771 * 255,
+        0.498039 * 255, 0.359165 * 255,
+        0.623529 * 255, 0.568527 * 255,
+        0.749020 * 255, 0.772928 * 255,
+        0.874510 * 255, 0.927927 * 255,
+        1.000000 * 255, 0.993301 * 255,
+      },
+      {
+        0.000000 * 255, 0.001961 * 255,
+        0.121569 * 255, 0.069848 * 255,
+        0.247059 * 255, 0.214185 * 255,
+        0.372549 * 255, 0.386385 * 255,
+        0.498039 * 255, 0.560533 * 255,
+        0.623529 * 255, 0.722231 * 255,
+        0.749020 * 255, 0.865600 * 255,
+        0.874510 * 255, 0.958973 * 255,
+        1.000000 * 255, 0.996979 * 255,
+      },
+      {
+        0.000000 * 255, 0.006332 * 255,
+        0.121569 * 255, 0.225447 * 255,
+        0.247059 * 255, 0.425338 * 255,
+        0.372549 * 255, 0.585919 * 255,
+        0.498039 * 255, 0.724790 * 255,
+        0.623529 * 255, 0.833296 * 255,
+        0.749020 * 255, 0.922240 * 255,
+        0.874510 * 255, 0.975900 * 255,
+        1.000000 * 255, 0.995237 * 255,
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_COLD_GREEN,
+    { 18, 18, 18 },
+    {
+      {
+        0.000000 * 255, 0.000058 * 255,
+        0.121569 * 255, 0.013332 * 255,
+        0.247059 * 255, 0.092201 * 255,
+        0.372549 * 255, 0.228389 * 255,
+        0.498039 * 255, 0.407339 * 255,
+        0.623529 * 255, 0.610095 * 255,
+        0.749020 * 255, 0.797573 * 255,
+        0.874510 * 255, 0.937331 * 255,
+        1.000000 * 255, 0.993303 * 255,
+      },
+      {
+        0.000000 * 255, 0.008824 * 255,
+        0.121569 * 255, 0.140109 * 255,
+        0.247059 * 255, 0.324052 * 255,
+        0.372549 * 255, 0.497982 * 255,
+        0.498039 * 255, 0.655209 * 255,
+        0.623529 * 255, 0.789734 * 255,
+        0.749020 * 255, 0.900202 * 255,
+        0.874510 * 255, 0.969304 * 255,
+        1.000000 * 255, 0.997007 * 255,
+      },
+      {
+        0.000000 * 255, 0.000495 * 255,
+        0.121569 * 255, 0.035825 * 255,
+        0.247059 * 255, 0.149480 * 255,
+        0.372549 * 255, 0.305398 * 255,
+        0.498039 * 255, 0.491352 * 255,
+        0.623529 * 255, 0.670305 * 255,
+        0.749020 * 255, 0.838898 * 255,
+        0.874510 * 255, 0.951301 * 255,
+        1.000000 * 255, 0.994118 * 255,
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_PURPLE_FANTASY,
+    { 18, 18, 18 },
+    {
+      {
+        0.000000 * 255, 0.003922 * 255,
+        0.121569 * 255, 0.184314 * 255,
+        0.247059 * 255, 0.376471 * 255,
+        0.372549 * 255, 0.533333 * 255,
+        0.498039 * 255, 0.662745 * 255,
+        0.623529 * 255, 0.788235 * 255,
+        0.749020 * 255, 0.878431 * 255,
+        0.874510 * 255, 0.941176 * 255,
+        1.000000 * 255, 1.000000 * 255,
+      },
+      {
+        0.000000 * 255, 0.003922 * 255,
+        0.121569 * 255, 0.113725 * 255,
+        0.247059 * 255, 0.243137 * 255,
+        0.372549 * 255, 0.407843 * 255,
+        0.498039 * 255, 0.623529 * 255,
+        0.623529 * 255, 0.760784 * 255,
+        0.749020 * 255, 0.847059 * 255,
+        0.874510 * 255, 0.925490 * 255,
+        1.000000 * 255, 1.000000 * 255,
+      },
+      {
+        0.000000 * 255, 0.007843 * 255,
+        0.121569 * 255, 0.309804 * 255,
+        0.247059 * 255, 0.505882 * 255,
+        0.372549 * 255, 0.603922 * 255,
+        0.498039 * 255, 0.709804 * 255,
+        0.623529 * 255, 0.784314 * 255,
+        0.749020 * 255, 0.854902 * 255,
+        0.874510 * 255, 0.929412 * 255,
+        1.000000 * 255, 1.000000 * 255,
+      },
+    },
+  },
+  {
+    BEAUTIFY_EFFECT_COLD_PURPLE,
+    { 18, 18, 18 },
+    {
+      {
+        0.000000 * 255, 0.004412 * 255,
+        0.121569 * 255, 0.137411 * 255,
+        0.247059 * 255, 0.308078 * 255,
+        0.372549 * 255, 0.470911 * 255,
+        0.498039 * 255, 0.617224 * 255,
+        0.623529 * 255, 0.745202 * 255,
+        0.749020 * 255, 0.851077 * 255,
+        0.874510 * 255, 0.936608 * 255,
+        1.000000 * 255, 0.991056 * 255,
+      },
+      {
+        0.000000 * 255, 0.033824 * 255,
+        0.121569 * 255, 0.044738 * 255,
+        0.247059 * 255, 0.161690 * 255,
+        0.372549 * 255, 0.319742 * 255,
+        0.498039 * 255, 0.492767 * 255,
+        0.623529 * 255, 0.662258 * 255,
+        0.749020 * 255, 0.830133 * 255,
+        0.874510 * 255, 0.940380 * 255,
+        1.000000 * 255, 0.996802 * 255,
+      },
+      {
+        0.000000 * 255, 0.140723 * 255,
+        0.121569 * 255, 0.295178 * 255,
+        0.247059 * 255, 0.504249 * 255,
+        0.372549 * 255, 0.648502 * 255,
+        0.498039 * 255, 0.757808 * 255,
+        0.623529 * 255, 0.853601 * 255,
+        0.749020 * 255, 0.928529 * 255,
+        0.874510 * 255, 0.975401 * 255,
+        1.000000 * 255, 0.992089 * 255,
+      },
+    },
+  },
+};
+
+/* look at no more pixels than this to fit Smart Color to an image */
+#define SMART_COLOR_SAMPLES (256 * 256)
+
+/* the curves handed in for the Smart Colors run on regions, in order */
+static const ColorLut *region_smart_colors = NULL;
+static gint            n_region_smart_colors = 0;
+static gint            next_region_smart_color = 0;
+
+/* the Smart Color curves, fitted to the image: black and white points
+ * and a midtone gamma from the luminance, a gray world correction of
+ * the cast, then the fixed curves of the look
+ */
+static void
+smart_color (gint32 drawable_ID, ColorLut *lut)
+{
+  ImageStats stats;
+  guchar     map[256];
+  gint       c, i;
+
+  const guint8 red_pts[] = {
+    0.0, 0.001012 * 255, 0.121569 * 255, 0.126695 * 255,
+    0.247059 * 255, 0.279821 * 255, 0.372549 * 255, 0.428038 * 255,
+    0.498039 * 255, 0.567700 * 255, 0.623529 * 255, 0.699439 * 255,
+    0.749020 * 255, 0.821423 * 255, 0.874510 * 255, 0.953474 * 255,
+    1.000000 * 255, 0.997988 * 255,
+  };
+  const guint8 green_pts[] = {
+    0.0, 0.004278 * 255, 0.121569 * 255, 0.107139 * 255,
+    0.247059 * 255, 0.225961 * 255, 0.372549 * 255, 0.346578 * 255,
+    0.498039 * 255, 0.472647 * 255, 0.623529 * 255, 0.602136 * 255,
+    0.749020 * 255, 0.730046 * 255, 0.874510 * 255, 0.873495 * 255,
+    1.000000 * 255, 0.996787 * 255,
+  };
+  const guint8 blue_pts[] = {
+    0.0, 0.000105 * 255, 0.121569 * 255, 0.060601 * 255,
+    0.247059 * 255, 0.146772 * 255, 0.372549 * 255, 0.262680 * 255,
+    0.498039 * 255, 0.408053 * 255, 0.623529 * 255, 0.566459 * 255,
+    0.749020 * 255, 0.691468 * 255, 0.874510 * 255, 0.847356 * 255,
+    1.000000 * 255, 0.999226 * 255,
+  };
+
+  color_lut_init (lut);
+
+  image_stats_collect (&stats, drawable_ID, SMART_COLOR_SAMPLES);
+
+  if (stats.count > 0)
+  {
+    /* stretch, but not much more than the fixed curves already do */
+    gint black = MIN (image_stats_percentile (&stats, IMAGE_STATS_LUMINANCE, 0.005), 32);
+    gint white = MAX (image_stats_percentile (&stats, IMAGE_STATS_LUMINANCE, 0.995), 223);
+
+    /* move the median half way to the middle */
+    gdouble median = (image_stats_percentile (&stats, IMAGE_STATS_LUMINANCE, 0.5) - black) /
+                     (gdouble) (white - black);
+    gdouble gamma = log (0.5) / log (CLAMP (median, 0.05, 0.95));
+
+    gamma = CLAMP (sqrt (gamma), 0.7, 1.4);
+
+    for (i = 0; i < 256; i++)
+      map[i] = ROUND (pow (CLAMP ((i - black) / (gdouble) (white - black), 0.0, 1.0), gamma) * 255);
+    color_lut_map (lut, COLOR_LUT_VALUE, map);
+
+    if (stats.has_color)
+    {
+      gdouble mean[3];
+
+      mean[0] = image_stats_mean (&stats, IMAGE_STATS_RED);
+      mean[1] = image_stats_mean (&stats, IMAGE_STATS_GREEN);
+      mean[2] = image_stats_mean (&stats, IMAGE_STATS_BLUE);
+
+      gdouble gray = (mean[0] + mean[1] + mean[2]) / 3;
+
+      for (c = 0; c < 3; c++)
+      {
+        if (mean[c] < 1)
+          continue;
+
+        gdouble gain = CLAMP (1 + (gray / mean[c] - 1) / 2, 0.9, 1.1);
+
+        for (i = 0; i < 256; i++)
+          map[i] = CLAMP (ROUND (i * gain), 0, 255);
+        color_lut_map (lut, COLOR_LUT_RED + c, map);
+      }
+    }
+  }
+
+  color_lut_spline (lut, COLOR_LUT_RED, 18, red_pts);
+  color_lut_spline (lut, COLOR_LUT_GREEN, 18, green_pts);
+  color_lut_spline (lut, COLOR_LUT_BLUE, 18, blue_pts);
+}
+
+/* chain the curves of an effect into lut, FALSE if the effect
+ * is more than a mapping of each channel
+ */
+static gboolean
+effect_lut (gint32 drawable_ID, BeautifyEffectType effect, ColorLut *lut)
+{
+  guchar map[256];
+  gint   c, i;
+
+  switch (effect)
+  {
+    case BEAUTIFY_EFFECT_SMART_COLOR:
+    {
+      ColorLut        fitted;
+      const ColorLut *curves = &fitted;
+
+      /* a region uses the curves fitted on its whole image,
+       * so the tiles of the inspector match the preview
+       */
+      if ((gimp_drawable_width (drawable_ID) != full_width ||
+           gimp_drawable_height (drawable_ID) != full_height) &&
+          next_region_smart_color < n_region_smart_colors)
+        curves = &region_smart_colors[next_region_smart_color++];
+      else
+        smart_color (drawable_ID, &fitted);
+
+      for (c = 0; c < 4; c++)
+        color_lut_map (lut, c, curves->lut[c]);
+      return TRUE;
+    }
+    case BEAUTIFY_EFFECT_INVERT:
+      for (i = 0; i < 256; i++)
+        map[i] = 255 - i;
+      color_lut_map (lut, COLOR_LUT_VALUE, map);
+      return TRUE;
+    default:
+      break;
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (curves_effects); i++)
+  {
+    const CurvesEffect *curves = &curves_effects[i];
+
+    if (curves->effect != effect)
+      continue;
+
+    for (c = 0; c < 3; c++)
+      if (curves->num_points[c] > 0)
+        color_lut_spline (lut, COLOR_LUT_RED + c,
+                          curves->num_points[c], curves->control_pts[c]);
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+void
+effect_set_region_smart_colors (const ColorLut *luts, gint n_luts)
+{
+  region_smart_colors = luts;
+  n_region_smart_colors = luts ? n_luts : 0;
+  next_region_smart_color = 0;
+}
+
+gboolean
+effect_color_lut (gint32 drawable_ID, BeautifyEffectType effect, ColorLut *lut)
+{
+  full_width = gimp_drawable_width (drawable_ID);
+  full_height = gimp_drawable_height (drawable_ID);
+  region_x = 0;
+  region_y = 0;
+
+  return effect_lut (drawable_ID, effect, lut);
+}
+
+gboolean
+effect_stack_color_lut (const BeautifyEffectEntry *entries,
+                        gint                       n_entries,
+                        ColorLut                  *lut)
+{
+  gint i;
+
+  color_lut_init (lut);
+
+  for (i = 0; i < n_entries; i++)
+  {
+    ColorLut effect;
+
+    if (entries[i].effect == BEAUTIFY_EFFECT_NONE || entries[i].opacity <= 0)
+      continue;
+
+    /* Smart Color is fitted to each image */
+    if (entries[i].effect == BEAUTIFY_EFFECT_SMART_COLOR)
+      return FALSE;
+
+    color_lut_init (&effect);
+    if (!effect_lut (-1, entries[i].effect, &effect))
+      return FALSE;
+
+    color_lut_mix (lut, &effect, entries[i].opacity / 100.0);
+  }
+
+  return TRUE;
+}
+
+gint
+effect_halo (BeautifyEffectType effect)
+{
+  /* pixels of context an effect reads around each pixel,
+   * follows the radius of the filters used in run_effect_region ()
+   */
+  switch (effect)
+  {
+    case BEAUTIFY_EFFECT_SOFT_LIGHT:
+      return 16;
+    case BEAUTIFY_EFFECT_SOFT:
+      return 3;
+    case BEAUTIFY_EFFECT_SKETCH:
+      return 21;
+    case BEAUTIFY_EFFECT_SHARPEN:
+      return 1;
+    case BEAUTIFY_EFFECT_RELIEF:
+      return 2;
+    default:
+      return 0;
+  }
+}
+
+void
+run_effect_stack (gint32                     image_ID,
+                  const BeautifyEffectEntry *entries,
+                  gint                       n_entries,
+                  gint                       image_width,
+                  gint                       image_height,
+                  gint                       offset_x,
+                  gint                       offset_y,
+                  ColorLut                  *rest)
+{
+  ColorLut stack;
+  gboolean pending = FALSE;
+  gint     i;
+
+  full_width = image_width;
+  full_height = image_height;
+  region_x = offset_x;
+  region_y = offset_y;
+
+  color_lut_init (&stack);
+
+  for (i = 0; i < n_entries; i++)
+  {
+    const BeautifyEffectEntry *entry = &entries[i];
+    gint32                     layer = gimp_image_get_active_layer (image_ID);
+    ColorLut                   lut;
+
+    if (entry->effect == BEAUTIFY_EFFECT_NONE || entry->opacity <= 0)
+      continue;
+
+    /* Smart Color looks at the pixels, which have to be up to date */
+    if (pending && entry->effect == BEAUTIFY_EFFECT_SMART_COLOR)
+    {
+      color_lut_run (layer, &stack);
+      color_lut_init (&stack);
+      pending = FALSE;
+    }
+
+    /* gray layers only have the value table, which is not mixed */
+    color_lut_init (&lut);
+    if (gimp_drawable_is_rgb (layer) && effect_lut (layer, entry->effect, &lut))
+    {
+      color_lut_mix (&stack, &lut, entry->opacity / 100.0);
+      pending = TRUE;
+      continue;
+    }
+
+    if (pending)
+    {
+      color_lut_run (layer, &stack);
+      color_lut_init (&stack);
+      pending = FALSE;
+    }
+
+    run_effect_region (image_ID, entry->effect,
+                       image_width, image_height, offset_x, offset_y);
+
+    layer = gimp_image_get_active_layer (image_ID);
+    if (entry->opacity < 100)
+      gimp_layer_set_opacity (layer, entry->opacity);
+
+    gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_IMAGE);
+  }
+
+  if (rest)
+    *rest = stack;
+  else if (pending)
+    color_lut_run (gimp_image_get_active_layer (image_ID), &stack);
+}
+
+void
+run_effect (gint32 image_ID, BeautifyEffectType effect)
+{
+  run_effect_region (image_ID, effect,
+                     gimp_image_width (image_ID), gimp_image_height (image_ID),
+                     0, 0);
+}
+
+void
+run_effect_region (gint32             image_ID,
+                   BeautifyEffectType effect,
+                   gint               image_width,
+                   gint               image_height,
+                   gint               offset_x,
+                   gint               offset_y)
+{
+  full_width = image_width;
+  full_height = image_height;
+  region_x = offset_x;
+  region_y = offset_y;
+
+  gimp_context_push ();
+
+  /* some effects select areas of their own */
+  gint32 selection = -1;
+  if (!gimp_selection_is_empty (image_ID))
+    selection = gimp_selection_save (image_ID);
+
+  gint32 layer = gimp_image_get_active_layer (image_ID);
+  gint32 effect_layer = gimp_layer_copy (layer);
+  gimp_image_add_layer (image_ID, effect_layer, -1);
+  //gimp_layer_set_lock_alpha (effect_layer, TRUE);
+
+  gint width = gimp_image_width (image_ID);
+  gint height = gimp_image_height (image_ID);
+
+  ColorLut lut;
+
+  color_lut_init (&lut);
+  if (effect_lut (effect_layer, effect, &lut))
+    color_lut_run (effect_layer, &lut);
+
+  switch (effect)
+  {
+    case BEAUTIFY_EFFECT_SOFT_LIGHT:
+    {
+      gint32     layer;
+
+      layer = gimp_layer_copy (effect_layer);
+      gimp_image_add_layer (image_ID, layer, -1);
+      gimp_levels (layer, GIMP_HISTOGRAM_VALUE, 20, 255, 1, 0, 255);
+
+      GimpParam *return_vals;
+      gint nreturn_vals;
+      return_vals = gimp_run_procedure ("plug-in-gauss",
+                                        &nreturn_vals,
+                                        GIMP_PDB_INT32, GIMP_RUN_NONINTERACTIVE,
+                                        GIMP_PDB_IMAGE, image_ID,
+                                        GIMP_PDB_DRAWABLE, layer,
+                                        GIMP_PDB_FLOAT, 15.0,
+                                        GIMP_PDB_FLOAT, 15.0,
+                                        GIMP_PDB_INT32, 1,
+                                        GIMP_PDB_END);
+      gimp_destroy_params (return_vals, nreturn_vals);
+
+      gimp_layer_set_mode (layer, GIMP_SCREEN_MODE);
+      gimp_layer_set_opacity (layer, 35);
+      gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_IMAGE);
+
+      break;
+    }
+    case BEAUTIFY_EFFECT_SHARPEN:
+    {
+      gint nreturn_vals;
+      GimpParam *return_vals = gimp_run_procedure ("plug-in-sharpen",
+                                                   &nreturn_vals,
+                                                   GIMP_PDB_INT32, 1,
+                                                   GIMP_PDB_IMAGE, image_ID,
+                                                   GIMP_PDB_DRAWABLE, effect_layer,
+                                                   GIMP_PDB_INT32, 50,
+                                                   GIMP_PDB_END);
+      gimp_destroy_params (return_vals, nreturn_vals);
+      break;
+    }
+    case BEAUTIFY_EFFECT_SOFT:
+    {
+      gint nreturn_vals;
+      GimpParam *return_vals = gimp_run_procedure ("plug-in-gauss",
+                                                   &nreturn_vals,
+                                                   GIMP_PDB_INT32, 1,
+                                                   GIMP_PDB_IMAGE, image_ID,
+                                                   GIMP_PDB_DRAWABLE, effect_layer,
+                                                   GIMP_PDB_FLOAT, 1.2,
+                                                   GIMP_PDB_FLOAT, 1.2,
+                                                   GIMP_PDB_INT32, 1,
+                                                   GIMP_PDB_END);
+      gimp_destroy_params (return_vals, nreturn_vals);
+      break;
+    }
+    case BEAUTIFY_EFFECT_BLACK_AND_WHITE:
+    {
+      black_and_white (image_ID, effect_layer);
+      break;
+    }
+    case BEAUTIFY_EFFECT_CLASSIC_LOMO:
+    {
+      gint32     layer;
+      GdkPixbuf *pixbuf;
+
+      pixbuf = gdk_pixbuf_new_from_inline (-1, texture_classic_LOMO_1, FALSE, NULL);
+      layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_OVERLAY_MODE, 0, 0);
+      gimp_image_add_layer (image_ID, layer, -1);
+      texture_fit (image_ID, layer);
+      gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
+
+      guint8 red_pts[] = {
+        0.000000 * 255, 0.000430 * 255,
+        0.121569 * 255, 0.034226 * 255,
+        0.247059 * 255, 0.156268 * 255,
+        0.372549 * 255, 0.337497 * 255,
+        0.498039 * 255, 0.542195 * 255,
+        0.623529 * 255, 0.728355 * 255,
+        0.749020 * 255, 0.862534 * 255,
+        0.874510 * 255, 0.942754 * 255,
+        1.000000 * 255, 0.994413 * 255,
+      };
+      guint8 green_pts[] = {
+        0.000000 * 255, 0.000167 * 255,
+        0.121569 * 255, 0.023472 * 255,
+        0.247059 * 255, 0.139498 * 255,
+        0.372549 * 255, 0.318074 * 255,
+        0.498039 * 255, 0.520901 * 255,
+        0.623529 * 255, 0.705862 * 255,
+        0.749020 * 255, 0.849380 * 255,
+        0.874510 * 255, 0.952092 * 255,
+        1.000000 * 255, 0.994484 * 255,
+      };
+      guint8 blue_pts[] = {
+        0.000000 * 255, 0.000377 * 255,
+        0.121569 * 255, 0.030137 * 255,
+        0.247059 * 255, 0.160170 * 255,
+        0.372549 * 255, 0.335944 * 255,
+        0.498039 * 255, 0.545279 * 255,
+        0.623529 * 255, 0.719690 * 255,
+        0.749020 * 255, 0.867722 * 255,
+        0.874510 * 255, 0.965811 * 255,
+        1.000000 * 255, 0.995110 * 255,
+      };
+      layer = gimp_image_get_active_layer (image_ID);
+      gimp_curves_spline (layer, GIMP_HISTOGRAM_RED, 18, red_pts);
+      gimp_curves_spline (layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
+      gimp_curves_spline (layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
+
+      pixbuf = gdk_pixbuf_new_from_inline (-1, texture_classic_LOMO_2, FALSE, NULL);
+      layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_MULTIPLY_MODE, 0, 0);
+      gimp_image_add_layer (image_ID, layer, -1);
+      texture_fit (image_ID, layer);
+      gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
+
+      break;
+    }
+    case BEAUTIFY_EFFECT_RETRO_LOMO:
+    {
+      guint8 red_pts[] = {
+        0.000000 * 255, 0.009477 * 255,
+        0.121569 * 255, 0.066342 * 255,
+        0.247059 * 255, 0.211570 * 255,
+        0.372549 * 255, 0.391796 * 255,
+        0.498039 * 255, 0.576389 * 255,
+        0.623529 * 255, 0.745091 * 255,
+        0.749020 * 255, 0.875015 * 255,
+        0.874510 * 255, 0.959604 * 255,
+        1.000000 * 255, 0.989234 * 255,
+      };
+      guint8 green_pts[] = {
+        0.000000 * 255, 0.075980 * 255,
+        0.121569 * 255, 0.176692 * 255,
+        0.247059 * 255, 0.294329 * 255,
+        0.372549 * 255, 0.415297 * 255,
+        0.498039 * 255, 0.536491 * 255,
+        0.623529 * 255, 0.651230 * 255,
+        0.749020 * 255, 0.751355 * 255,
+        0.874510 * 255, 0.843675 * 255,
+        1.000000 * 255, 0.921772 * 255,
+      };
+      guint8 blue_pts[] = {
+        0.000000 * 255, 0.246068 * 255,
+        0.121569 * 255, 0.310134 * 255,
+        0.247059 * 255, 0.373558 * 255,
+        0.372549 * 255, 0.435251 * 255,
+        0.498039 * 255, 0.503361 * 255,
+        0.623529 * 255, 0.565592 * 255,
+        0.749020 * 255, 0.629995 * 255,
+        0.874510 * 255, 0.690267 * 255,
+        1.000000 * 255, 0.751997 * 255,
+      };
+      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
+      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
+      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
+
+      gint       nreturn_vals;
+      GimpParam *return_vals;
+
+      return_vals = gimp_run_procedure ("plug-in-rgb-noise",
+                                        &nreturn_vals,
+                                        GIMP_PDB_INT32, 1,
+                                        GIMP_PDB_IMAGE, image_ID,
+                                        GIMP_PDB_DRAWABLE, effect_layer,
+                                        GIMP_PDB_INT32, 0,
+                                        GIMP_PDB_INT32, 0,
+                                        GIMP_PDB_FLOAT, 0.03,
+                                        GIMP_PDB_FLOAT, 0.03,
+                                        GIMP_PDB_FLOAT, 0.03,
+                                        GIMP_PDB_FLOAT, 0.03,
+                                        GIMP_PDB_END);
+      gimp_destroy_params (return_vals, nreturn_vals);
+
+      break;
+    }
+    case BEAUTIFY_EFFECT_YELLOWING_DARK_CORNERS:
+    {
+      guint8 red_pts[] = {
+        0.000000 * 255, 0.093137 * 255,
+        0.121569 * 255, 0.125134 * 255,
+        0.247059 * 255, 0.227000 * 255,
+        0.372549 * 255, 0.372794 * 255,
+        0.498039 * 255, 0.537491 * 255,
+        0.623529 * 255, 0.706434 * 255,
+        0.749020 * 255, 0.852155 * 255,
+        0.874510 * 255, 0.953969 * 255,
+        1.000000 * 255, 0.996078 * 255,
       };
       guint8 green_pts[] = {
-        0.000000 * 255, 0.003922 * 255,
-        0.121569 * 255, 0.078431 * 255,
-        0.247059 * 255, 0.196078 * 255,
-        0.372549 * 255, 0.341176 * 255,
-        0.498039 * 255, 0.494118 * 255,
-        0.623529 * 255, 0.650980 * 255,
-        0.749020 * 255, 0.792157 * 255,
-        0.874510 * 255, 0.913725 * 255,
-        1.000000 * 255, 0.925490 * 255,
+        0.000000 * 255, 0.092647 * 255,
+        0.121569 * 255, 0.125205 * 255,
+        0.247059 * 255, 0.227129 * 255,
+        0.372549 * 255, 0.372871 * 255,
+        0.498039 * 255, 0.537711 * 255,
+        0.623529 * 255, 0.706357 * 255,
+        0.749020 * 255, 0.851153 * 255,
+        0.874510 * 255, 0.953240 * 255,
+        1.000000 * 255, 0.996078 * 255,
       };
       guint8 blue_pts[] = {
-        0.000000 * 255, 0.450980 * 255,
-        0.121569 * 255, 0.450980 * 255,
-        0.247059 * 255, 0.450980 * 255,
-        0.372549 * 255, 0.450980 * 255,
-        0.498039 * 255, 0.494118 * 255,
-        0.623529 * 255, 0.650980 * 255,
-        0.749020 * 255, 0.792157 * 255,
-        0.874510 * 255, 0.913725 * 255,
-        1.000000 * 255, 1.000000 * 255,
+        0.000000 * 255, 0.003922 * 255,
+        0.121569 * 255, 0.029810 * 255,
+        0.247059 * 255, 0.143778 * 255,
+        0.372549 * 255, 0.305764 * 255,
+        0.498039 * 255, 0.488796 * 255,
+        0.623529 * 255, 0.672134 * 255,
+        0.749020 * 255, 0.833704 * 255,
+        0.874510 * 255, 0.948010 * 255,
+        1.000000 * 255, 0.996078 * 255,
       };
       gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
       gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
       gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
+
+      gint32     layer;
+      GdkPixbuf *pixbuf;
+
+      pixbuf = gdk_pixbuf_new_from_inline (-1, texture_yellowing_dark_corners, FALSE, NULL);
+      layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_MULTIPLY_MODE, 0, 0);
+      gimp_image_add_layer (image_ID, layer, -1);
+      texture_fit (image_ID, layer);
+      gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
+
       break;
     }
     case BEAUTIFY_EFFECT_RECALL:
@@ -681,7 +1462,7 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_recall, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_MULTIPLY_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
       break;
     }
@@ -728,154 +1509,6 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
 
       break;
     }
-    case BEAUTIFY_EFFECT_LITTLE_FRESH:
-    {
-      guint8 red_pts[] = {
-        0.0, 0.002975 * 255, 0.121569 * 255, 0.135413 * 255,
-        0.247059 * 255, 0.271797 * 255, 0.372549 * 255, 0.420642 * 255,
-        0.498039 * 255, 0.587088 * 255, 0.623529 * 255, 0.672206 * 255,
-        0.749020 * 255, 0.781208 * 255, 0.874510 * 255, 0.881668 * 255,
-        1.000000 * 255, 0.993149 * 255,
-      };
-      guint8 green_pts[] = {
-        0.0, 0.001070 * 255, 0.121569 * 255, 0.123393 * 255,
-        0.247059 * 255, 0.254300 * 255, 0.372549 * 255, 0.377336 * 255,
-        0.498039 * 255, 0.486582 * 255, 0.623529 * 255, 0.607331 * 255,
-        0.749020 * 255, 0.722174 * 255, 0.874510 * 255, 0.858206 * 255,
-        1.000000 * 255, 0.992154 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.0, 0.003917 * 255, 0.121569 * 255, 0.098807 * 255,
-        0.247059 * 255, 0.234746 * 255, 0.372549 * 255, 0.378388 * 255,
-        0.498039 * 255, 0.520273 * 255, 0.623529 * 255, 0.633239 * 255,
-        0.749020 * 255, 0.748242 * 255, 0.874510 * 255, 0.862234 * 255,
-        1.000000 * 255, 0.964176 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-    }
-      break;
-    case BEAUTIFY_EFFECT_CLASSIC_STUDIO:
-    {
-      guint8 red_pts[] = {
-        0.000000 * 255, 0.002941 * 255,
-        0.121569 * 255, 0.105177 * 255,
-        0.247059 * 255, 0.276869 * 255,
-        0.372549 * 255, 0.449951 * 255,
-        0.498039 * 255, 0.615011 * 255,
-        0.623529 * 255, 0.765528 * 255,
-        0.749020 * 255, 0.884498 * 255,
-        0.874510 * 255, 0.964439 * 255,
-        1.000000 * 255, 0.996641 * 255,
-      };
-      guint8 green_pts[] = {
-        0.000000 * 255, 0.000980 * 255,
-        0.121569 * 255, 0.023976 * 255,
-        0.247059 * 255, 0.117564 * 255,
-        0.372549 * 255, 0.268570 * 255,
-        0.498039 * 255, 0.450785 * 255,
-        0.623529 * 255, 0.640827 * 255,
-        0.749020 * 255, 0.821280 * 255,
-        0.874510 * 255, 0.944143 * 255,
-        1.000000 * 255, 0.994046 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.000000 * 255, 0.001705 * 255,
-        0.121569 * 255, 0.091176 * 255,
-        0.247059 * 255, 0.255272 * 255,
-        0.372549 * 255, 0.426934 * 255,
-        0.498039 * 255, 0.599930 * 255,
-        0.623529 * 255, 0.749604 * 255,
-        0.749020 * 255, 0.879809 * 255,
-        0.874510 * 255, 0.963030 * 255,
-        1.000000 * 255, 0.994565 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
-    }
-    case BEAUTIFY_EFFECT_RETRO:
-    {
-      guint8 red_pts[] = {
-        0.000000 * 255, 0.011765 * 255,
-        0.121569 * 255, 0.050275 * 255,
-        0.247059 * 255, 0.163976 * 255,
-        0.372549 * 255, 0.316983 * 255,
-        0.498039 * 255, 0.493141 * 255,
-        0.623529 * 255, 0.671170 * 255,
-        0.749020 * 255, 0.829955 * 255,
-        0.874510 * 255, 0.941938 * 255,
-        1.000000 * 255, 0.988797 * 255,
-      };
-      guint8 green_pts[] = {
-        0.000000 * 255, 0.044118 * 255,
-        0.121569 * 255, 0.081048 * 255,
-        0.247059 * 255, 0.181188 * 255,
-        0.372549 * 255, 0.327417 * 255,
-        0.498039 * 255, 0.493717 * 255,
-        0.623529 * 255, 0.658936 * 255,
-        0.749020 * 255, 0.811563 * 255,
-        0.874510 * 255, 0.915557 * 255,
-        1.000000 * 255, 0.956299 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.000000 * 255, 0.247630 * 255,
-        0.121569 * 255, 0.268491 * 255,
-        0.247059 * 255, 0.325230 * 255,
-        0.372549 * 255, 0.405204 * 255,
-        0.498039 * 255, 0.497829 * 255,
-        0.623529 * 255, 0.588839 * 255,
-        0.749020 * 255, 0.675181 * 255,
-        0.874510 * 255, 0.731610 * 255,
-        1.000000 * 255, 0.752075 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
-    }
-    case BEAUTIFY_EFFECT_PINK_LADY:
-    {
-      guint8 red_pts[] = {
-        0.000000 * 255, 0.003922 * 255,
-        0.121569 * 255, 0.196078 * 255,
-        0.247059 * 255, 0.356863 * 255,
-        0.372549 * 255, 0.509804 * 255,
-        0.498039 * 255, 0.647059 * 255,
-        0.623529 * 255, 0.760784 * 255,
-        0.749020 * 255, 0.858824 * 255,
-        0.874510 * 255, 0.937255 * 255,
-        1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 green_pts[] = {
-        0.000000 * 255, 0.003922 * 255,
-        0.121569 * 255, 0.180392 * 255,
-        0.247059 * 255, 0.329412 * 255,
-        0.372549 * 255, 0.478431 * 255,
-        0.498039 * 255, 0.611765 * 255,
-        0.623529 * 255, 0.729412 * 255,
-        0.749020 * 255, 0.831373 * 255,
-        0.874510 * 255, 0.921569 * 255,
-        1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.000000 * 255, 0.003922 * 255,
-        0.121569 * 255, 0.168627 * 255,
-        0.247059 * 255, 0.317647 * 255,
-        0.372549 * 255, 0.458824 * 255,
-        0.498039 * 255, 0.592157 * 255,
-        0.623529 * 255, 0.709804 * 255,
-        0.749020 * 255, 0.819608 * 255,
-        0.874510 * 255, 0.913725 * 255,
-        1.000000 * 255, 1.000000 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
-    }
     case BEAUTIFY_EFFECT_ABAO_COLOR:
     {
       gint       nreturn_vals;
@@ -1048,88 +1681,6 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
 
       break;
     }
-    case BEAUTIFY_EFFECT_ICE_SPIRIT:
-    {
-      guint8 red_pts[] = {
-        0.0, 0.007843 * 255, 0.121569 * 255, 0.141176 * 255,
-        0.247059 * 255, 0.286275 * 255, 0.372549 * 255, 0.423529 * 255,
-        0.498039 * 255, 0.552941 * 255, 0.623529 * 255, 0.674510 * 255,
-        0.749020 * 255, 0.792157 * 255, 0.874510 * 255, 0.898039 * 255,
-        1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 green_pts[] = {
-        0.0, 0.007843 * 255, 0.121569 * 255, 0.184314 * 255,
-        0.247059 * 255, 0.360784 * 255, 0.372549 * 255, 0.517647 * 255,
-        0.498039 * 255, 0.654902 * 255, 0.623529 * 255, 0.768627 * 255,
-        0.749020 * 255, 0.866667 * 255, 0.874510 * 255, 0.945098 * 255,
-        1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.0, 0.007843 * 255, 0.121569 * 255, 0.211765 * 255,
-        0.247059 * 255, 0.407843 * 255, 0.372549 * 255, 0.576471 * 255,
-        0.498039 * 255, 0.717647 * 255, 0.623529 * 255, 0.827451 * 255,
-        0.749020 * 255, 0.913725 * 255, 0.874510 * 255, 0.972549 * 255,
-        1.000000 * 255, 1.000000 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-    }
-      break;
-    case BEAUTIFY_EFFECT_JAPANESE_STYLE:
-    {
-      guint8 red_pts[] = {
-        0.0, 0.098039 * 255, 0.121569 * 255, 0.188479 * 255,
-        0.247059 * 255, 0.329761 * 255, 0.372549 * 255, 0.496682 * 255,
-        0.498039 * 255, 0.657383 * 255, 0.623529 * 255, 0.787002 * 255,
-        0.749020 * 255, 0.864444 * 255, 0.874510 * 255, 0.900704 * 255,
-        1.000000 * 255, 0.917552 * 255,
-      };
-      guint8 green_pts[] = {
-        0.0, 0.103431 * 255, 0.121569 * 255, 0.224676 * 255,
-        0.247059 * 255, 0.394142 * 255, 0.372549 * 255, 0.541888 * 255,
-        0.498039 * 255, 0.675963 * 255, 0.623529 * 255, 0.785613 * 255,
-        0.749020 * 255, 0.893224 * 255, 0.874510 * 255, 0.943625 * 255,
-        1.000000 * 255, 0.972720 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.0, 0.412025 * 255, 0.121569 * 255, 0.469119 * 255,
-        0.247059 * 255, 0.615777 * 255, 0.372549 * 255, 0.751174 * 255,
-        0.498039 * 255, 0.862955 * 255, 0.623529 * 255, 0.954468 * 255,
-        0.749020 * 255, 0.995760 * 255, 0.874510 * 255, 1.000000 * 255,
-        1.000000 * 255, 1.000000 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-    }
-      break;
-    case BEAUTIFY_EFFECT_NEW_JAPANESE_STYLE:
-    {
-      guint8 red_pts[] = {
-        0.0, 0.042969 * 255,
-        0.350610 * 255, 0.320312 * 255,
-        0.621951 * 255, 0.566406 * 255,
-        0.847561 * 255, 0.632812 * 255,
-        1.000000 * 255, 0.769531 * 255,
-      };
-      guint8 green_pts[] = {
-        0.0, 0.031250 * 255,
-        0.125000 * 255, 0.144531 * 255,
-        0.500000 * 255, 0.523438 * 255,
-        0.881098 * 255, 0.738281 * 255,
-        1.000000 * 255, 0.882812 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.0, 0.0,
-        0.121951 * 255, 0.039062 * 255,
-        1.000000 * 255, 0.972656 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 10, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 10, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 6, blue_pts);
-    }
-      break;
     case BEAUTIFY_EFFECT_MILK:
     {
       gint32     layer;
@@ -1138,7 +1689,7 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_milk, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 20, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       guint8 red_pts[] = {
@@ -1225,239 +1776,11 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_old_photos, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       break;
     }
-    case BEAUTIFY_EFFECT_WARM_YELLOW:
-    {
-      guint8 red_pts[] = {
-        0.0, 0.000980 * 255, 0.121569 * 255, 0.065574 * 255,
-        0.247059 * 255, 0.213677 * 255, 0.372549 * 255, 0.383298 * 255,
-        0.498039 * 255, 0.556855 * 255, 0.623529 * 255, 0.726149 * 255,
-        0.749020 * 255, 0.864046 * 255, 0.874510 * 255, 0.958157 * 255,
-        1.000000 * 255, 0.996641 * 255,
-      };
-      guint8 green_pts[] = {
-        0.0, 0.005882 * 255, 0.121569 * 255, 0.107837 * 255,
-        0.247059 * 255, 0.276792 * 255, 0.372549 * 255, 0.452811 * 255,
-        0.498039 * 255, 0.617782 * 255, 0.623529 * 255, 0.763782 * 255,
-        0.749020 * 255, 0.886822 * 255, 0.874510 * 255, 0.965223 * 255,
-        1.000000 * 255, 0.996993 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.0, 0.000495 * 255, 0.121569 * 255, 0.035825 * 255,
-        0.247059 * 255, 0.149480 * 255, 0.372549 * 255, 0.305398 * 255,
-        0.498039 * 255, 0.491352 * 255, 0.623529 * 255, 0.670305 * 255,
-        0.749020 * 255, 0.838898 * 255, 0.874510 * 255, 0.951301 * 255,
-        1.000000 * 255, 0.994118 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-    }
-      break;
-    case BEAUTIFY_EFFECT_BLUES:
-    {
-      guint8 red_pts[] = {
-        0.000000 * 255, 0.003922 * 255,
-        0.121569 * 255, 0.321569 * 255,
-        0.247059 * 255, 0.541176 * 255,
-        0.372549 * 255, 0.713725 * 255,
-        0.498039 * 255, 0.831373 * 255,
-        0.623529 * 255, 0.905882 * 255,
-        0.749020 * 255, 0.952941 * 255,
-        0.874510 * 255, 0.980392 * 255,
-        1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 green_pts[] = {
-        0.000000 * 255, 0.003922 * 255,
-        0.121569 * 255, 0.266667 * 255,
-        0.247059 * 255, 0.466667 * 255,
-        0.372549 * 255, 0.627451 * 255,
-        0.498039 * 255, 0.756863 * 255,
-        0.623529 * 255, 0.847059 * 255,
-        0.749020 * 255, 0.917647 * 255,
-        0.874510 * 255, 0.964706 * 255,
-        1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.000000 * 255, 0.007843 * 255,
-        0.121569 * 255, 0.286275 * 255,
-        0.247059 * 255, 0.505882 * 255,
-        0.372549 * 255, 0.682353 * 255,
-        0.498039 * 255, 0.811765 * 255,
-        0.623529 * 255, 0.901961 * 255,
-        0.749020 * 255, 0.960784 * 255,
-        0.874510 * 255, 0.988235 * 255,
-        1.000000 * 255, 0.996078 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
-    }
-    case BEAUTIFY_EFFECT_COLD_BLUE:
-    {
-      guint8 red_pts[] = {
-        0.000000 * 255, 0.000040 * 255,
-        0.121569 * 255, 0.008043 * 255,
-        0.247059 * 255, 0.066237 * 255,
-        0.372549 * 255, 0.184771 * 255,
-        0.498039 * 255, 0.359165 * 255,
-        0.623529 * 255, 0.568527 * 255,
-        0.749020 * 255, 0.772928 * 255,
-        0.874510 * 255, 0.927927 * 255,
-        1.000000 * 255, 0.993301 * 255,
-      };
-      guint8 green_pts[] = {
-        0.000000 * 255, 0.001961 * 255,
-        0.121569 * 255, 0.069848 * 255,
-        0.247059 * 255, 0.214185 * 255,
-        0.372549 * 255, 0.386385 * 255,
-        0.498039 * 255, 0.560533 * 255,
-        0.623529 * 255, 0.722231 * 255,
-        0.749020 * 255, 0.865600 * 255,
-        0.874510 * 255, 0.958973 * 255,
-        1.000000 * 255, 0.996979 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.000000 * 255, 0.006332 * 255,
-        0.121569 * 255, 0.225447 * 255,
-        0.247059 * 255, 0.425338 * 255,
-        0.372549 * 255, 0.585919 * 255,
-        0.498039 * 255, 0.724790 * 255,
-        0.623529 * 255, 0.833296 * 255,
-        0.749020 * 255, 0.922240 * 255,
-        0.874510 * 255, 0.975900 * 255,
-        1.000000 * 255, 0.995237 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
-    }
-    case BEAUTIFY_EFFECT_COLD_GREEN:
-    {
-      guint8 red_pts[] = {
-        0.000000 * 255, 0.000058 * 255,
-        0.121569 * 255, 0.013332 * 255,
-        0.247059 * 255, 0.092201 * 255,
-        0.372549 * 255, 0.228389 * 255,
-        0.498039 * 255, 0.407339 * 255,
-        0.623529 * 255, 0.610095 * 255,
-        0.749020 * 255, 0.797573 * 255,
-        0.874510 * 255, 0.937331 * 255,
-        1.000000 * 255, 0.993303 * 255,
-      };
-      guint8 green_pts[] = {
-        0.000000 * 255, 0.008824 * 255,
-        0.121569 * 255, 0.140109 * 255,
-        0.247059 * 255, 0.324052 * 255,
-        0.372549 * 255, 0.497982 * 255,
-        0.498039 * 255, 0.655209 * 255,
-        0.623529 * 255, 0.789734 * 255,
-        0.749020 * 255, 0.900202 * 255,
-        0.874510 * 255, 0.969304 * 255,
-        1.000000 * 255, 0.997007 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.000000 * 255, 0.000495 * 255,
-        0.121569 * 255, 0.035825 * 255,
-        0.247059 * 255, 0.149480 * 255,
-        0.372549 * 255, 0.305398 * 255,
-        0.498039 * 255, 0.491352 * 255,
-        0.623529 * 255, 0.670305 * 255,
-        0.749020 * 255, 0.838898 * 255,
-        0.874510 * 255, 0.951301 * 255,
-        1.000000 * 255, 0.994118 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
-    }
-    case BEAUTIFY_EFFECT_PURPLE_FANTASY:
-    {
-      guint8 red_pts[] = {
-        0.000000 * 255, 0.003922 * 255,
-        0.121569 * 255, 0.184314 * 255,
-        0.247059 * 255, 0.376471 * 255,
-        0.372549 * 255, 0.533333 * 255,
-        0.498039 * 255, 0.662745 * 255,
-        0.623529 * 255, 0.788235 * 255,
-        0.749020 * 255, 0.878431 * 255,
-        0.874510 * 255, 0.941176 * 255,
-        1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 green_pts[] = {
-        0.000000 * 255, 0.003922 * 255,
-        0.121569 * 255, 0.113725 * 255,
-        0.247059 * 255, 0.243137 * 255,
-        0.372549 * 255, 0.407843 * 255,
-        0.498039 * 255, 0.623529 * 255,
-        0.623529 * 255, 0.760784 * 255,
-        0.749020 * 255, 0.847059 * 255,
-        0.874510 * 255, 0.925490 * 255,
-        1.000000 * 255, 1.000000 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.000000 * 255, 0.007843 * 255,
-        0.121569 * 255, 0.309804 * 255,
-        0.247059 * 255, 0.505882 * 255,
-        0.372549 * 255, 0.603922 * 255,
-        0.498039 * 255, 0.709804 * 255,
-        0.623529 * 255, 0.784314 * 255,
-        0.749020 * 255, 0.854902 * 255,
-        0.874510 * 255, 0.929412 * 255,
-        1.000000 * 255, 1.000000 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
-    }
-    case BEAUTIFY_EFFECT_COLD_PURPLE:
-    {
-      guint8 red_pts[] = {
-        0.000000 * 255, 0.004412 * 255,
-        0.121569 * 255, 0.137411 * 255,
-        0.247059 * 255, 0.308078 * 255,
-        0.372549 * 255, 0.470911 * 255,
-        0.498039 * 255, 0.617224 * 255,
-        0.623529 * 255, 0.745202 * 255,
-        0.749020 * 255, 0.851077 * 255,
-        0.874510 * 255, 0.936608 * 255,
-        1.000000 * 255, 0.991056 * 255,
-      };
-      guint8 green_pts[] = {
-        0.000000 * 255, 0.033824 * 255,
-        0.121569 * 255, 0.044738 * 255,
-        0.247059 * 255, 0.161690 * 255,
-        0.372549 * 255, 0.319742 * 255,
-        0.498039 * 255, 0.492767 * 255,
-        0.623529 * 255, 0.662258 * 255,
-        0.749020 * 255, 0.830133 * 255,
-        0.874510 * 255, 0.940380 * 255,
-        1.000000 * 255, 0.996802 * 255,
-      };
-      guint8 blue_pts[] = {
-        0.000000 * 255, 0.140723 * 255,
-        0.121569 * 255, 0.295178 * 255,
-        0.247059 * 255, 0.504249 * 255,
-        0.372549 * 255, 0.648502 * 255,
-        0.498039 * 255, 0.757808 * 255,
-        0.623529 * 255, 0.853601 * 255,
-        0.749020 * 255, 0.928529 * 255,
-        0.874510 * 255, 0.975401 * 255,
-        1.000000 * 255, 0.992089 * 255,
-      };
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (effect_layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
-    }
     case BEAUTIFY_EFFECT_BRIGHT_RED:
     {
       gint32     layer;
@@ -1466,7 +1789,7 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_bright_red, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       guint8 red_pts[] = {
@@ -1526,7 +1849,7 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       GdkPixbuf *pixbuf = gdk_pixbuf_new_from_inline (-1, texture_christmas_eve, FALSE, NULL);
       gint32 texture_layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, texture_layer, -1);
-      gimp_layer_scale (texture_layer, width, height, FALSE);
+      texture_fit (image_ID, texture_layer);
       gimp_image_merge_down (image_ID, texture_layer, GIMP_CLIP_TO_BOTTOM_LAYER);
       break;
     }
@@ -1575,7 +1898,7 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_night_view, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       break;
@@ -1585,7 +1908,7 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       GdkPixbuf *pixbuf = gdk_pixbuf_new_from_inline (-1, texture_astral, FALSE, NULL);
       gint32 texture_layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_SOFTLIGHT_MODE, 0, 0);
       gimp_image_add_layer (image_ID, texture_layer, -1);
-      gimp_layer_scale (texture_layer, width, height, FALSE);
+      texture_fit (image_ID, texture_layer);
       gimp_image_merge_down (image_ID, texture_layer, GIMP_CLIP_TO_BOTTOM_LAYER);
     }
       break;
@@ -1634,7 +1957,7 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_colorful_glow, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       break;
@@ -1660,13 +1983,13 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_pick_light_1, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture 1", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_pick_light_2, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture 2", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
       break;
     }
@@ -1678,7 +2001,7 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_glass_drops, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       break;
@@ -1723,13 +2046,13 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_life_sketch_1, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 60, GIMP_OVERLAY_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_life_sketch_2, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       guint8 red_pts[] = {
@@ -1782,13 +2105,13 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_classic_sketch_1, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_classic_sketch_2, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       guint8 red_pts[] = {
@@ -1832,7 +2155,7 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_classic_sketch_3, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_MULTIPLY_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       break;
@@ -1846,12 +2169,12 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
 
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_OVERLAY_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_IMAGE);
 
       break;
@@ -1860,8 +2183,19 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
     {
       gint32     layer;
 
-      layer = gimp_layer_new (image_ID, "texture", width, height, GIMP_RGBA_IMAGE, 60, GIMP_MULTIPLY_MODE);
+      gint       pattern_width, pattern_height, pattern_bpp;
+      gint       dx = 0, dy = 0;
+
+      /* keep the stripes in phase with the full image */
+      if (gimp_pattern_get_info ("Stripes Fine", &pattern_width, &pattern_height, &pattern_bpp))
+      {
+        dx = region_x % pattern_width;
+        dy = region_y % pattern_height;
+      }
+
+      layer = gimp_layer_new (image_ID, "texture", width + dx, height + dy, GIMP_RGBA_IMAGE, 60, GIMP_MULTIPLY_MODE);
       gimp_image_add_layer (image_ID, layer, -1);
+      gimp_layer_set_offsets (layer, -dx, -dy);
       gimp_drawable_fill (layer, GIMP_TRANSPARENT_FILL);
       gimp_context_set_pattern ("Stripes Fine");
       gimp_edit_fill (layer, GIMP_PATTERN_FILL);
@@ -1883,13 +2217,17 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_IMAGE);
 
       //gimp_image_select_rectangle (image_ID, GIMP_CHANNEL_OP_REPLACE, 1, 1, width - 2, height - 2);
-      gimp_rect_select (image_ID, 1, 1, width - 2, height - 2, GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
+      gimp_rect_select (image_ID, 1 - region_x, 1 - region_y, full_width - 2, full_height - 2, GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
       gimp_selection_invert (image_ID);
 
-      layer = gimp_image_get_active_layer (image_ID);
-      GimpRGB color = { 0.5, 0.5, 0.5, 1.0 };
-      gimp_context_set_foreground (&color);
-      gimp_edit_fill (layer, GIMP_FOREGROUND_FILL);
+      /* a region inside the image has no border to fill */
+      if (!gimp_selection_is_empty (image_ID))
+      {
+        layer = gimp_image_get_active_layer (image_ID);
+        GimpRGB color = { 0.5, 0.5, 0.5, 1.0 };
+        gimp_context_set_foreground (&color);
+        gimp_edit_fill (layer, GIMP_FOREGROUND_FILL);
+      }
 
       gimp_selection_none (image_ID);
 
@@ -1940,7 +2278,7 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_beam_gradient, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       break;
@@ -1953,7 +2291,7 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_sunset_gradient, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       break;
@@ -2003,7 +2341,7 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_rainbow_gradient, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       break;
@@ -2016,7 +2354,7 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_pink_purple_gradient, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       break;
@@ -2029,7 +2367,7 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
       pixbuf = gdk_pixbuf_new_from_inline (-1, texture_pink_blue_gradient, FALSE, NULL);
       layer = gimp_layer_new_from_pixbuf (image_ID, "texture", pixbuf, 100, GIMP_SCREEN_MODE, 0, 0);
       gimp_image_add_layer (image_ID, layer, -1);
-      gimp_layer_scale (layer, width, height, FALSE);
+      texture_fit (image_ID, layer);
       gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_BOTTOM_LAYER);
 
       guint8 red_pts[] = {
@@ -2073,6 +2411,17 @@ run_effect (gint32 image_ID, BeautifyEffectType effect)
     }
   }
 
+  /* only the selected part of the effect layer is merged down */
+  if (selection != -1)
+  {
+    gimp_selection_load (selection);
+    gimp_image_remove_channel (image_ID, selection);
+
+    layer = gimp_image_get_active_layer (image_ID);
+    if (gimp_layer_get_mask (layer) == -1)
+      gimp_layer_add_mask (layer, gimp_layer_create_mask (layer, GIMP_ADD_SELECTION_MASK));
+  }
+
   gimp_context_pop ();
 }
 
@@ -108,3 +108,65 @@ typedef enum
 
 void run_effect (gint32 image_ID, BeautifyEffectType effect);
 
+/* run an effect on an image holding only the region at (offset_x, offset_y)
+ * of an image_width x image_height image, textures and borders are placed
+ * as they would be on the whole image. Under a selection the new layer
+ * gets the selection as its mask, so merging it down changes only the
+ * selected part.
+ */
+void run_effect_region (gint32             image_ID,
+                        BeautifyEffectType effect,
+                        gint               image_width,
+                        gint               image_height,
+                        gint               offset_x,
+                        gint               offset_y);
+
+/* run a list of effects on the active layer of an image, each mixed in
+ * at its opacity. Effects which only map colors are chained into one
+ * table and applied together in one pass, the others are run as
+ * run_effect_region () does and merged down. If rest is not NULL, the
+ * colors mapping left at the end is returned in it instead of applied,
+ * so the caller can fold it into its own pass.
+ */
+typedef struct
+{
+  BeautifyEffectType effect;
+  gdouble            opacity;  /* 0 .. 100 */
+} BeautifyEffectEntry;
+
+void run_effect_stack (gint32                     image_ID,
+                       const BeautifyEffectEntry *entries,
+                       gint                       n_entries,
+                       gint                       image_width,
+                       gint                       image_height,
+                       gint                       offset_x,
+                       gint                       offset_y,
+                       ColorLut                  *rest);
+
+/* the colors mapping of a whole list of effects, for applying it to
+ * many images. FALSE if an effect does more than map each channel or
+ * depends on the image.
+ */
+gboolean effect_stack_color_lut (const BeautifyEffectEntry *entries,
+                                 gint                       n_entries,
+                                 ColorLut                  *lut);
+
+/* chain the curves of an effect run on the whole drawable into lut,
+ * FALSE if the effect does more than map each channel
+ */
+gboolean effect_color_lut (gint32              drawable_ID,
+                           BeautifyEffectType  effect,
+                           ColorLut           *lut);
+
+/* Smart Color fits its curves to the whole image, a region has too
+ * little of it for that. The Smart Colors run on regions from now on
+ * take their curves from luts instead, one each in order, as fitted by
+ * effect_color_lut () on the whole image at that step, or on a smaller
+ * copy of it standing in for it. luts is not copied, NULL or running out
+ * of them fits on the region itself.
+ */
+void effect_set_region_smart_colors (const ColorLut *luts,
+                                     gint            n_luts);
+
+gint effect_halo (BeautifyEffectType effect);
+
@@ -0,0 +1,154 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libgimp/gimp.h>
+
+#include "color-lut.h"
+#include "beautify-effect.h"
+#include "beautify-recipe.h"
+
+#define RECIPE_GROUP "Beautify"
+
+static void
+set_double (GKeyFile    *key_file,
+            const gchar *group,
+            const gchar *key,
+            gdouble      value,
+            gdouble      default_value)
+{
+  if (value != default_value)
+    g_key_file_set_double (key_file, group, key, value);
+}
+
+static gdouble
+get_double (GKeyFile    *key_file,
+            const gchar *group,
+            const gchar *key,
+            gdouble      default_value)
+{
+  if (!g_key_file_has_key (key_file, group, key, NULL))
+    return default_value;
+
+  return g_key_file_get_double (key_file, group, key, NULL);
+}
+
+gboolean
+beautify_recipe_save (const gchar          *filename,
+                      const BeautifyValues *steps,
+                      gint                  n_steps,
+                      const gchar          *border,
+                      GError              **error)
+{
+  GKeyFile *key_file = g_key_file_new ();
+  gchar    *data;
+  gsize     length;
+  gboolean  success;
+  gint      i;
+
+  g_key_file_set_integer (key_file, RECIPE_GROUP, "steps", n_steps);
+  if (border)
+    g_key_file_set_string (key_file, RECIPE_GROUP, "border", border);
+
+  for (i = 0; i < n_steps; i++)
+  {
+    const BeautifyValues *step = &steps[i];
+    gchar                *group = g_strdup_printf ("Step %d", i + 1);
+
+    if (step->effect != BEAUTIFY_EFFECT_NONE)
+    {
+      g_key_file_set_integer (key_file, group, "effect", step->effect);
+      set_double (key_file, group, "opacity", step->opacity, 100);
+    }
+
+    set_double (key_file, group, "brightness", step->brightness, 0);
+    set_double (key_file, group, "contrast", step->contrast, 0);
+    set_double (key_file, group, "saturation", step->saturation, 0);
+    set_double (key_file, group, "definition", step->definition, 0);
+    set_double (key_file, group, "hue", step->hue, 0);
+    set_double (key_file, group, "cyan-red", step->cyan_red, 0);
+    set_double (key_file, group, "magenta-green", step->magenta_green, 0);
+    set_double (key_file, group, "yellow-blue", step->yellow_blue, 0);
+
+    g_free (group);
+  }
+
+  data = g_key_file_to_data (key_file, &length, NULL);
+  success = g_file_set_contents (filename, data, length, error);
+
+  g_free (data);
+  g_key_file_free (key_file);
+
+  return success;
+}
+
+GArray *
+beautify_recipe_load (const gchar  *filename,
+                      gchar       **border,
+                      GError      **error)
+{
+  GKeyFile *key_file = g_key_file_new ();
+  GArray   *steps;
+  gint      n_steps;
+  gint      i;
+
+  *border = NULL;
+
+  if (!g_key_file_load_from_file (key_file, filename, G_KEY_FILE_NONE, error))
+  {
+    g_key_file_free (key_file);
+    return NULL;
+  }
+
+  n_steps = MAX (g_key_file_get_integer (key_file, RECIPE_GROUP, "steps", NULL), 0);
+  if (g_key_file_has_key (key_file, RECIPE_GROUP, "border", NULL))
+    *border = g_key_file_get_string (key_file, RECIPE_GROUP, "border", NULL);
+
+  steps = g_array_new (FALSE, TRUE, sizeof (BeautifyValues));
+
+  for (i = 0; i < n_steps; i++)
+  {
+    BeautifyValues step;
+    gchar         *group = g_strdup_printf ("Step %d", i + 1);
+
+    /* a count larger than the steps written stops at the last one */
+    if (!g_key_file_has_group (key_file, group))
+    {
+      g_free (group);
+      break;
+    }
+
+    /* values out of range are clamped to the ranges of the sliders */
+    step.effect = CLAMP (g_key_file_get_integer (key_file, group, "effect", NULL),
+                         BEAUTIFY_EFFECT_NONE, BEAUTIFY_EFFECT_PINK_BLUE_GRADIENT);
+    step.opacity = CLAMP (get_double (key_file, group, "opacity", 100), 0, 100);
+    step.brightness = CLAMP (get_double (key_file, group, "brightness", 0), -127, 127);
+    step.contrast = CLAMP (get_double (key_file, group, "contrast", 0), -50, 50);
+    step.saturation = CLAMP (get_double (key_file, group, "saturation", 0), -50, 50);
+    step.definition = CLAMP (get_double (key_file, group, "definition", 0), -50, 50);
+    step.hue = CLAMP (get_double (key_file, group, "hue", 0), -180, 180);
+    step.cyan_red = CLAMP (get_double (key_file, group, "cyan-red", 0), -50, 50);
+    step.magenta_green = CLAMP (get_double (key_file, group, "magenta-green", 0), -50, 50);
+    step.yellow_blue = CLAMP (get_double (key_file, group, "yellow-blue", 0), -50, 50);
+
+    g_array_append_val (steps, step);
+    g_free (group);
+  }
+
+  g_key_file_free (key_file);
+
+  return steps;
+}
@@ -0,0 +1,59 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A recipe is what the Beautify dialog records on OK: a list of steps,
+ * each an effect at an opacity followed by the adjustments, and the id
+ * of a Simple Border texture to put around the result. It is kept in a
+ * key file, values which change nothing are left out:
+ *
+ *   [Beautify]
+ *   border=15327
+ *
+ *   [Step 1]
+ *   effect=7
+ *   opacity=80
+ *   contrast=10
+ */
+
+typedef struct
+{
+  gint brightness;
+  gint contrast;
+  gdouble saturation;
+  gdouble definition;
+  gdouble hue;
+  gdouble cyan_red;
+  gdouble magenta_green;
+  gdouble yellow_blue;
+
+  BeautifyEffectType effect;
+  gdouble opacity;
+} BeautifyValues;
+
+/* border may be NULL */
+gboolean beautify_recipe_save (const gchar          *filename,
+                               const BeautifyValues *steps,
+                               gint                  n_steps,
+                               const gchar          *border,
+                               GError              **error);
+
+/* returns an array of BeautifyValues, border is set to a newly
+ * allocated string or NULL
+ */
+GArray  *beautify_recipe_load (const gchar          *filename,
+                               gchar               **border,
+                               GError              **error);
@@ -15,32 +15,64 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+
 #include <libgimp/gimp.h>
 #include <libgimp/gimpui.h>
 
+#include "color-lut.h"
 #include "beautify-effect.h"
+#include "beautify-adjust.h"
+#include "beautify-recipe.h"
+#include "guided-filter.h"
+#include "image-stats.h"
+#include "preview-surface.h"
+#include "preview-inspector.h"
+#include "border-render.h"
+#include "simple-border-apply.h"
 
 #define PLUG_IN_PROC   "plug-in-beautify"
+#define PLUG_IN_PIPELINE_PROC "plug-in-beautify-pipeline"
+#define PLUG_IN_RECIPE_PROC "plug-in-beautify-recipe"
+#define PLUG_IN_RECIPE_BATCH_PROC "plug-in-beautify-recipe-batch"
 #define PLUG_IN_BINARY "beautify"
 #define PLUG_IN_ROLE   "gimp-beautify"
 
 #define PREVIEW_SIZE  480
 #define THUMBNAIL_SIZE  80
+/* rendered previews kept for effects the user may click again */
+#define MEMO_SIZE  8
+
+typedef struct
+{
+  BeautifyValues key;
+  gint           version;
+  guchar        *pixels;
+} PreviewMemo;
+
+/* a recipe prepared once for many images: the steps are grouped into
+ * the effects up to the next adjustments
+ */
+typedef struct
+{
+  GArray         *entries;  /* BeautifyEffectEntry */
+  BeautifyValues  vals;     /* the adjustments after the effects */
+
+  /* the effects only map colors and are put in front of the point
+   * operations of vals, so the group is one pass
+   */
+  gboolean        fused;
+  BeautifyAdjust  adjust;
+} RecipeGroup;
 
 typedef struct
 {
-  gint brightness;
-  gint contrast;
-  gdouble saturation;
-  gdouble definition;
-  gdouble hue;
-  gdouble cyan_red;
-  gdouble magenta_green;
-  gdouble yellow_blue;
-
-  BeautifyEffectType effect;
-  gdouble opacity;
-} BeautifyValues;
+  GArray        *groups;         /* RecipeGroup */
+
+  /* the border texture decoded once, border_pixbuf is NULL without one */
+  GdkPixbuf     *border_pixbuf;
+  BorderTexture  border;
+} Recipe;
 
 static const BeautifyEffectType basic_effects[] =
 {
@@ -130,6 +162,15 @@ static void     run      (const gchar      *name,
 
 static void     beautify        (GimpDrawable *drawable);
 static void     beautify_effect (GimpDrawable *drawable);
+static GimpPDBStatusType beautify_pipeline (GimpDrawable    *drawable,
+                                            gint             nparams,
+                                            const GimpParam *param);
+
+static Recipe  *recipe_compile (const GArray *steps, const gchar *border);
+static gboolean recipe_apply   (const Recipe *recipe, gint32 image, gint32 drawable_ID);
+static void     recipe_free    (Recipe *recipe);
+static Recipe  *recipe_load    (const gchar *filename);
+static gboolean run_border     (gint32 image, const gchar *border);
 
 static gboolean beautify_dialog (gint32        image_ID,
                                  GimpDrawable *drawable);
@@ -146,9 +187,15 @@ static void     cyan_red_update      (GtkRange *range, gpointer data);
 static void     magenta_green_update (GtkRange *range, gpointer data);
 static void     yellow_blue_update   (GtkRange *range, gpointer data);
 
-static void     adjustment(gint32 image);
+static gboolean  has_adjustment (const BeautifyValues *vals);
+static gint     definition_radius (gint size);
+static void     adjustment     (gint32 image, const BeautifyValues *vals);
 
 static void     reset_pressed (GtkButton *button, gpointer user_date);
+static void     save_recipe_pressed (GtkButton *button, gpointer user_data);
+static void     load_recipe_pressed (GtkButton *button, gpointer user_data);
+static void     auto_levels_pressed (GtkButton *button, gpointer user_data);
+static void     auto_white_balance_pressed (GtkButton *button, gpointer user_data);
 
 static void     preview_update (GtkWidget *preview);
 
@@ -158,6 +205,7 @@ static void       effect_opacity_update (GtkRange *range, gpointer data);
 static void create_effect_pages (GtkNotebook *notebook);
 static void create_effect_page  (GtkNotebook *notebook, gchar *str);
 static void effects_switch_page (GtkNotebook *notebook, GtkWidget *page, guint page_num, gpointer user_data);
+static gboolean prefetch_effects (gpointer data);
 
 static GtkWidget* effect_icon_new (BeautifyEffectType effect);
 
@@ -167,6 +215,25 @@ static void reset_adjustment ();
 
 static void apply_effect ();
 static void cancel_effect ();
+static void current_op (BeautifyValues *op);
+static void run_op (gint32 image, const BeautifyValues *op, gint offset_x, gint offset_y);
+static void run_ops (gint32 image, gint offset_x, gint offset_y);
+static void run_adjustment (gint32 image, const BeautifyValues *vals, const ColorLut *curves);
+static void adjust_from_values (BeautifyAdjust *adjust, const BeautifyValues *vals, const ColorLut *curves);
+static void run_definition (gint32 image, gint32 layer, const BeautifyValues *vals);
+
+static void sync_preview_image ();
+static gboolean effect_base_prepare ();
+static void     effect_base_drop ();
+
+static PreviewMemo *memo_lookup (const BeautifyValues *key);
+static void         memo_store  (const BeautifyValues *key);
+static void         memo_evict  ();
+
+static void inspector_refresh ();
+static void inspector_fit_smart_colors ();
+static void inspector_render (gint32 image, gint offset_x, gint offset_y, gpointer data);
+static void inspector_toggled (GtkToggleButton *button, gpointer data);
 
 const GimpPlugInInfo PLUG_IN_INFO =
 {
@@ -205,7 +272,14 @@ static GtkWidget *magenta_green = NULL;
 static GtkWidget *yellow_blue = NULL;
 
 static GtkWidget *preview          = NULL;
-static gint32     real_image       = 0;
+static PreviewSurface *preview_surface = NULL;
+static PreviewInspector *inspector = NULL;
+
+/* the curves of the Smart Colors in the ops, fitted on the preview at
+ * their steps, for the regions the inspector renders
+ */
+static GArray   *inspector_smart_colors = NULL;
+static gboolean  inspector_smart_colors_valid = FALSE;
 static gint32     preview_image    = 0;
 static gint32     saved_image      = 0;
 static gint32     thumbnail        = 0;
@@ -216,6 +290,35 @@ static GtkWidget *effect_option    = NULL;
 static GtkWidget *effect_opacity   = NULL;
 
 static BeautifyEffectType current_effect = BEAUTIFY_EFFECT_NONE;
+
+/* effects and adjustments chosen in the dialog, each entry is a
+ * BeautifyValues snapshot. They only run on the real image on OK.
+ */
+static GArray    *ops              = NULL;
+/* the border of a loaded recipe, put around the image on OK */
+static gchar     *recipe_border    = NULL;
+
+/* what preview_image holds below the current effect: 0 is the image
+ * itself, every recorded entry gives a new version
+ */
+static gint       source_version   = 0;
+static gint       last_version     = 0;
+/* the preview shows an effect from the memo, it is only run on
+ * preview_image when something needs it
+ */
+static BeautifyEffectType pending_effect = BEAUTIFY_EFFECT_NONE;
+static GList     *memo             = NULL;
+/* for an effect which only maps colors: the preview below it, not
+ * flattened, and its curves, so the opacity slider maps these pixels
+ * again instead of compositing the effect layer
+ */
+static guchar    *effect_base      = NULL;
+static ColorLut   effect_base_lut;
+
+/* effect pages are filled lazily, icons done so far for each page */
+static GtkWidget *effect_tables[6];
+static guint      effect_icons[6];
+static guint      prefetch_id      = 0;
 gint32 preview_effect_layer = 0;
 
 /* compatable with gtk2 */
@@ -258,6 +361,77 @@ query (void)
                           args, NULL);
 
   gimp_plugin_menu_register (PLUG_IN_PROC, "<Image>/Filters/Beautify");
+
+  static const GimpParamDef pipeline_args[] =
+  {
+    { GIMP_PDB_INT32,      "run-mode",      "The run mode { RUN-NONINTERACTIVE (1) }" },
+    { GIMP_PDB_IMAGE,      "image",         "Input image" },
+    { GIMP_PDB_DRAWABLE,   "drawable",      "Input drawable" },
+    { GIMP_PDB_INT32,      "brightness",    "Brightness (-127 <= brightness <= 127)" },
+    { GIMP_PDB_INT32,      "contrast",      "Contrast (-50 <= contrast <= 50)" },
+    { GIMP_PDB_FLOAT,      "saturation",    "Saturation (-50 <= saturation <= 50)" },
+    { GIMP_PDB_FLOAT,      "definition",    "Definition (-50 <= definition <= 50)" },
+    { GIMP_PDB_FLOAT,      "hue",           "Hue (-180 <= hue <= 180)" },
+    { GIMP_PDB_FLOAT,      "cyan-red",      "Cyan-Red color balance (-50 <= cyan-red <= 50)" },
+    { GIMP_PDB_FLOAT,      "magenta-green", "Magenta-Green color balance (-50 <= magenta-green <= 50)" },
+    { GIMP_PDB_FLOAT,      "yellow-blue",   "Yellow-Blue color balance (-50 <= yellow-blue <= 50)" },
+    { GIMP_PDB_INT32,      "num-effects",   "The number of effects" },
+    { GIMP_PDB_INT32ARRAY, "effects",       "The effects to apply in order, see plug-in-beautify" },
+    { GIMP_PDB_INT32,      "num-opacities", "The number of opacities, the same as num-effects" },
+    { GIMP_PDB_FLOATARRAY, "opacities",     "The opacity of each effect (0 <= opacity <= 100)" }
+  };
+
+  gimp_install_procedure (PLUG_IN_PIPELINE_PROC,
+                          "Apply effects and adjustments in one call.",
+                          "Apply a list of effects, then the adjustments of the Beautify dialog, as the dialog would on OK. Effects which only map colors and the adjustments are evaluated together in one pass over the pixels.",
+                          "Hejian <hejian.he@gmail.com>",
+                          "Hejian <hejian.he@gmail.com>",
+                          "2012",
+                          NULL,
+                          "RGB*, GRAY*",
+                          GIMP_PLUGIN,
+                          G_N_ELEMENTS (pipeline_args), 0,
+                          pipeline_args, NULL);
+
+  static const GimpParamDef recipe_args[] =
+  {
+    { GIMP_PDB_INT32,    "run-mode", "The run mode { RUN-NONINTERACTIVE (1) }" },
+    { GIMP_PDB_IMAGE,    "image",    "Input image" },
+    { GIMP_PDB_DRAWABLE, "drawable", "Input drawable" },
+    { GIMP_PDB_STRING,   "filename", "The recipe saved from the Beautify dialog" }
+  };
+
+  gimp_install_procedure (PLUG_IN_RECIPE_PROC,
+                          "Apply a saved Beautify recipe.",
+                          "Apply the effects, adjustments and border of a recipe saved from the Beautify dialog.",
+                          "Hejian <hejian.he@gmail.com>",
+                          "Hejian <hejian.he@gmail.com>",
+                          "2012",
+                          NULL,
+                          "RGB*, GRAY*",
+                          GIMP_PLUGIN,
+                          G_N_ELEMENTS (recipe_args), 0,
+                          recipe_args, NULL);
+
+  static const GimpParamDef recipe_batch_args[] =
+  {
+    { GIMP_PDB_INT32,      "run-mode",   "The run mode { RUN-NONINTERACTIVE (1) }" },
+    { GIMP_PDB_STRING,     "filename",   "The recipe saved from the Beautify dialog" },
+    { GIMP_PDB_INT32,      "num-images", "The number of images" },
+    { GIMP_PDB_INT32ARRAY, "images",     "The images, the recipe is applied to the active layer of each" }
+  };
+
+  gimp_install_procedure (PLUG_IN_RECIPE_BATCH_PROC,
+                          "Apply a saved Beautify recipe to many images.",
+                          "Apply a recipe saved from the Beautify dialog to the active layer of each image. The recipe is read and prepared once for all of them.",
+                          "Hejian <hejian.he@gmail.com>",
+                          "Hejian <hejian.he@gmail.com>",
+                          "2012",
+                          NULL,
+                          NULL,
+                          GIMP_PLUGIN,
+                          G_N_ELEMENTS (recipe_batch_args), 0,
+                          recipe_batch_args, NULL);
 }
 
 static void
@@ -280,12 +454,74 @@ run (const gchar      *name,
   values[0].type          = GIMP_PDB_STATUS;
   values[0].data.d_status = status;
 
+  if (strcmp (name, PLUG_IN_RECIPE_BATCH_PROC) == 0)
+  {
+    Recipe *recipe = NULL;
+    gint    i;
+
+    if (nparams == 4)
+      recipe = recipe_load (param[1].data.d_string);
+    if (!recipe)
+    {
+      values[0].data.d_status = GIMP_PDB_CALLING_ERROR;
+      return;
+    }
+
+    for (i = 0; i < param[2].data.d_int32; i++)
+    {
+      gint32 image = param[3].data.d_int32array[i];
+      gint32 layer;
+
+      /* images which are gone or have no active layer are skipped,
+       * recipe_apply () skips indexed layers
+       */
+      if (!gimp_image_is_valid (image))
+        continue;
+
+      layer = gimp_image_get_active_layer (image);
+      if (layer != -1)
+        recipe_apply (recipe, image, layer);
+    }
+
+    recipe_free (recipe);
+    return;
+  }
+
   image_ID = param[1].data.d_image;
   drawable = gimp_drawable_get (param[2].data.d_drawable);
 
   width = gimp_image_width (image_ID);
   height = gimp_image_height (image_ID);
 
+  if (strcmp (name, PLUG_IN_RECIPE_PROC) == 0)
+  {
+    Recipe *recipe = NULL;
+
+    if (nparams == 4)
+      recipe = recipe_load (param[3].data.d_string);
+
+    if (recipe)
+    {
+      if (!recipe_apply (recipe, image_ID, drawable->drawable_id))
+        values[0].data.d_status = GIMP_PDB_EXECUTION_ERROR;
+      recipe_free (recipe);
+    }
+    else
+    {
+      values[0].data.d_status = GIMP_PDB_CALLING_ERROR;
+    }
+
+    gimp_drawable_detach (drawable);
+    return;
+  }
+
+  if (strcmp (name, PLUG_IN_PIPELINE_PROC) == 0)
+  {
+    values[0].data.d_status = beautify_pipeline (drawable, nparams, param);
+    gimp_drawable_detach (drawable);
+    return;
+  }
+
   switch (run_mode)
   {
     case GIMP_RUN_INTERACTIVE:
@@ -342,22 +578,298 @@ run (const gchar      *name,
 static void
 beautify (GimpDrawable *drawable)
 {
-  apply_effect ();
-  gint32 source = gimp_image_get_active_layer (real_image);
-  gimp_edit_copy (source);
-  gint32 floating_sel = gimp_edit_paste (drawable->drawable_id, FALSE);
-  gimp_floating_sel_anchor (floating_sel);
+  gimp_image_set_active_layer (image_ID, drawable->drawable_id);
+
+  run_ops (image_ID, 0, 0);
+
+  if (recipe_border)
+  {
+    if (!run_border (image_ID, recipe_border))
+      g_message ("Unknown border '%s'", recipe_border);
+    g_free (recipe_border);
+    recipe_border = NULL;
+  }
+
+  g_array_free (ops, TRUE);
+  ops = NULL;
+}
+
+/* run one recorded entry: the effect is merged down into the active
+ * layer right away, so the adjustments of the entry apply to the result
+ * and the next effect starts from it. image is the part of the real image
+ * at (offset_x, offset_y).
+ */
+static void
+run_op (gint32 image, const BeautifyValues *op, gint offset_x, gint offset_y)
+{
+  BeautifyEffectEntry entry = { op->effect, op->opacity };
+  ColorLut            rest;
+
+  run_effect_stack (image, &entry, 1, width, height, offset_x, offset_y, &rest);
+  run_adjustment (image, op, &rest);
+}
+
+/* replay the recorded ops, the effects of ops without adjustments
+ * are run together with the next effects
+ */
+static void
+run_ops (gint32 image, gint offset_x, gint offset_y)
+{
+  GArray *stack = g_array_new (FALSE, FALSE, sizeof (BeautifyEffectEntry));
+  gint    i;
+
+  for (i = 0; i < ops->len; i++)
+  {
+    const BeautifyValues *op = &g_array_index (ops, BeautifyValues, i);
+    BeautifyEffectEntry   entry = { op->effect, op->opacity };
+
+    g_array_append_val (stack, entry);
+
+    if (has_adjustment (op))
+    {
+      ColorLut rest;
+
+      run_effect_stack (image, (BeautifyEffectEntry *) stack->data, stack->len,
+                        width, height, offset_x, offset_y, &rest);
+      g_array_set_size (stack, 0);
+      run_adjustment (image, op, &rest);
+    }
+  }
+
+  run_effect_stack (image, (BeautifyEffectEntry *) stack->data, stack->len,
+                    width, height, offset_x, offset_y, NULL);
+  g_array_free (stack, TRUE);
 }
 
+/* an effect which only maps colors is mixed in by its table, the
+ * others are run on a copy and merged down at the opacity
+ */
 static void
 beautify_effect (GimpDrawable *drawable)
 {
-  run_effect (image_ID, bvals.effect);
+  BeautifyEffectEntry entry = { bvals.effect, bvals.opacity };
+
+  run_effect_stack (image_ID, &entry, 1, width, height, 0, 0, NULL);
+}
+
+static GimpPDBStatusType
+beautify_pipeline (GimpDrawable    *drawable,
+                   gint             nparams,
+                   const GimpParam *param)
+{
+  BeautifyValues       vals;
+  BeautifyEffectEntry *entries;
+  ColorLut             rest;
+  gint                 n_effects;
+  gint                 i;
+
+  if (nparams != 15 || param[11].data.d_int32 != param[13].data.d_int32)
+    return GIMP_PDB_CALLING_ERROR;
+
+  n_effects = MAX (0, param[11].data.d_int32);
+  for (i = 0; i < n_effects; i++)
+  {
+    gint effect = param[12].data.d_int32array[i];
+
+    if (effect < BEAUTIFY_EFFECT_NONE || effect > BEAUTIFY_EFFECT_PINK_BLUE_GRADIENT)
+      return GIMP_PDB_CALLING_ERROR;
+  }
+
+  if (!gimp_drawable_is_rgb (drawable->drawable_id) &&
+      !gimp_drawable_is_gray (drawable->drawable_id))
+    return GIMP_PDB_EXECUTION_ERROR;
+
+  /* the ranges of the sliders */
+  memset (&vals, 0, sizeof (BeautifyValues));
+  vals.brightness = CLAMP (param[3].data.d_int32, -127, 127);
+  vals.contrast = CLAMP (param[4].data.d_int32, -50, 50);
+  vals.saturation = CLAMP (param[5].data.d_float, -50, 50);
+  vals.definition = CLAMP (param[6].data.d_float, -50, 50);
+  vals.hue = CLAMP (param[7].data.d_float, -180, 180);
+  vals.cyan_red = CLAMP (param[8].data.d_float, -50, 50);
+  vals.magenta_green = CLAMP (param[9].data.d_float, -50, 50);
+  vals.yellow_blue = CLAMP (param[10].data.d_float, -50, 50);
+
+  entries = g_new (BeautifyEffectEntry, MAX (1, n_effects));
+  for (i = 0; i < n_effects; i++)
+  {
+    entries[i].effect = param[12].data.d_int32array[i];
+    entries[i].opacity = CLAMP (param[14].data.d_floatarray[i], 0, 100);
+  }
+
+  gimp_image_undo_group_start (image_ID);
+  gimp_image_set_active_layer (image_ID, drawable->drawable_id);
+
+  /* the colors mapping of the last effects goes into the adjustments */
+  run_effect_stack (image_ID, entries, n_effects, width, height, 0, 0, &rest);
+  run_adjustment (image_ID, &vals, &rest);
+
+  gimp_image_undo_group_end (image_ID);
+
+  g_free (entries);
+
+  return GIMP_PDB_SUCCESS;
+}
+
+static Recipe *
+recipe_compile (const GArray *steps, const gchar *border)
+{
+  Recipe      *recipe = g_new0 (Recipe, 1);
+  RecipeGroup *group = NULL;
+  gint         i;
+
+  recipe->groups = g_array_new (FALSE, TRUE, sizeof (RecipeGroup));
+
+  if (border)
+  {
+    const Border *texture = simple_border_lookup (border);
+
+    if (texture)
+      recipe->border_pixbuf = gdk_pixbuf_new_from_inline (-1, texture->texture, FALSE, NULL);
+    if (!recipe->border_pixbuf)
+    {
+      recipe_free (recipe);
+      return NULL;
+    }
+    border_texture_init (&recipe->border, texture, recipe->border_pixbuf);
+  }
+
+  for (i = 0; i < steps->len; i++)
+  {
+    const BeautifyValues *step = &g_array_index (steps, BeautifyValues, i);
+    BeautifyEffectEntry   entry = { step->effect, step->opacity };
+
+    if (!group)
+    {
+      g_array_set_size (recipe->groups, recipe->groups->len + 1);
+      group = &g_array_index (recipe->groups, RecipeGroup, recipe->groups->len - 1);
+      group->entries = g_array_new (FALSE, FALSE, sizeof (BeautifyEffectEntry));
+    }
+
+    g_array_append_val (group->entries, entry);
+
+    if (has_adjustment (step) || i == steps->len - 1)
+    {
+      ColorLut curves;
+
+      group->vals = *step;
+      group->fused = effect_stack_color_lut ((BeautifyEffectEntry *) group->entries->data,
+                                             group->entries->len, &curves);
+      if (group->fused)
+        adjust_from_values (&group->adjust, step, &curves);
+      group = NULL;
+    }
+  }
+
+  return recipe;
+}
+
+/* FALSE, and nothing done, on an indexed drawable */
+static gboolean
+recipe_apply (const Recipe *recipe, gint32 image, gint32 drawable_ID)
+{
+  gint i;
+
+  if (!gimp_drawable_is_rgb (drawable_ID) && !gimp_drawable_is_gray (drawable_ID))
+    return FALSE;
+
+  width = gimp_image_width (image);
+  height = gimp_image_height (image);
+
+  gimp_image_undo_group_start (image);
+  gimp_image_set_active_layer (image, drawable_ID);
+
+  for (i = 0; i < recipe->groups->len; i++)
+  {
+    const RecipeGroup *group = &g_array_index (recipe->groups, RecipeGroup, i);
+    gint32             layer = gimp_image_get_active_layer (image);
+
+    /* gray layers do not use the tables of the color channels */
+    if (group->fused && gimp_drawable_is_rgb (layer))
+    {
+      beautify_adjust_run (layer, &group->adjust);
+      run_definition (image, layer, &group->vals);
+    }
+    else
+    {
+      ColorLut rest;
+
+      run_effect_stack (image, (BeautifyEffectEntry *) group->entries->data,
+                        group->entries->len, width, height, 0, 0, &rest);
+      run_adjustment (image, &group->vals, &rest);
+    }
+  }
+
+  if (recipe->border_pixbuf)
+    simple_border_apply (image, &recipe->border);
+
+  gimp_image_undo_group_end (image);
+
+  return TRUE;
+}
+
+static void
+recipe_free (Recipe *recipe)
+{
+  gint i;
+
+  for (i = 0; i < recipe->groups->len; i++)
+    g_array_free (g_array_index (recipe->groups, RecipeGroup, i).entries, TRUE);
+
+  g_array_free (recipe->groups, TRUE);
+  if (recipe->border_pixbuf)
+    g_object_unref (recipe->border_pixbuf);
+  g_free (recipe);
+}
+
+static Recipe *
+recipe_load (const gchar *filename)
+{
+  GError *error = NULL;
+  gchar  *border;
+  GArray *steps = beautify_recipe_load (filename, &border, &error);
+
+  if (!steps)
+  {
+    g_message ("Could not read recipe '%s': %s",
+               gimp_filename_to_utf8 (filename), error->message);
+    g_error_free (error);
+    return NULL;
+  }
+
+  Recipe *recipe = recipe_compile (steps, border);
+  if (!recipe)
+    g_message ("Could not read recipe '%s': unknown border '%s'",
+               gimp_filename_to_utf8 (filename), border);
+
+  g_array_free (steps, TRUE);
+  g_free (border);
+
+  return recipe;
+}
+
+/* a border of the Simple Border plug-in, rendered here instead of
+ * starting that plug-in, FALSE if there is no border with that id
+ */
+static gboolean
+run_border (gint32 image, const gchar *border)
+{
+  const Border  *texture = simple_border_lookup (border);
+  GdkPixbuf     *pixbuf;
+  BorderTexture  border_texture;
+
+  if (!texture)
+    return FALSE;
+
+  pixbuf = gdk_pixbuf_new_from_inline (-1, texture->texture, FALSE, NULL);
+  if (!pixbuf)
+    return FALSE;
 
-  gint32 layer = gimp_image_get_active_layer (image_ID);
-  gimp_layer_set_opacity (layer, bvals.opacity);
+  border_texture_init (&border_texture, texture, pixbuf);
+  simple_border_apply (image, &border_texture);
+  g_object_unref (pixbuf);
 
-  gimp_image_merge_down (image_ID, layer, GIMP_CLIP_TO_IMAGE);
+  return TRUE;
 }
 
 static gint32
@@ -443,19 +955,41 @@ beautify_dialog (gint32        image_ID,
   gtk_widget_show (reset);
   g_signal_connect (reset, "pressed", G_CALLBACK (reset_pressed), NULL);
 
-  real_image = gimp_image_duplicate (image_ID);
+  GtkWidget *actual_size = gtk_toggle_button_new_with_label ("1:1");
+  gtk_box_pack_start (GTK_BOX (buttons), actual_size, FALSE, FALSE, 0);
+  gtk_widget_show (actual_size);
+  g_signal_connect (actual_size, "toggled", G_CALLBACK (inspector_toggled), NULL);
+
+  GtkWidget *save_recipe = gtk_button_new_with_label ("Save Recipe...");
+  gtk_box_pack_end (GTK_BOX (buttons), save_recipe, FALSE, FALSE, 0);
+  gtk_widget_show (save_recipe);
+  g_signal_connect (save_recipe, "clicked", G_CALLBACK (save_recipe_pressed), dialog);
+
+  GtkWidget *load_recipe = gtk_button_new_with_label ("Load Recipe...");
+  gtk_box_pack_end (GTK_BOX (buttons), load_recipe, FALSE, FALSE, 0);
+  gtk_widget_show (load_recipe);
+  g_signal_connect (load_recipe, "clicked", G_CALLBACK (load_recipe_pressed), dialog);
+
+  ops = g_array_new (FALSE, FALSE, sizeof (BeautifyValues));
+
   /* preview */
-  preview_image_cache = image_copy_scale (real_image, PREVIEW_SIZE);
+  preview_image_cache = image_copy_scale (image_ID, PREVIEW_SIZE);
   preview_image = gimp_image_duplicate(preview_image_cache);
   /* create thumbnail cache for effect icon */
   thumbnail = image_copy_scale (preview_image, THUMBNAIL_SIZE);
 
-  preview = gtk_image_new();
+  preview_surface = preview_surface_new (width, height, PREVIEW_SIZE);
+  preview = preview_surface->widget;
   preview_update (preview);
 
   gtk_box_pack_start (GTK_BOX (middle_vbox), preview, FALSE, FALSE, 0);
   gtk_widget_show (preview);
 
+  /* 1:1 view of the real drawable, shown instead of preview */
+  inspector = preview_inspector_new (drawable->drawable_id, PREVIEW_SIZE,
+                                     inspector_render, NULL);
+  gtk_box_pack_start (GTK_BOX (middle_vbox), inspector->widget, FALSE, FALSE, 0);
+
   /* effect option */
   effect_option = effect_option_new ();
   gtk_box_pack_start (GTK_BOX (middle_vbox), effect_option, FALSE, FALSE, 0);
@@ -469,10 +1003,50 @@ beautify_dialog (gint32        image_ID,
 
   gboolean run = (gimp_dialog_run (GIMP_DIALOG (dialog)) == GTK_RESPONSE_OK);
 
+  if (prefetch_id)
+  {
+    g_source_remove (prefetch_id);
+    prefetch_id = 0;
+  }
+
+  /* record the last effect while the widgets are still alive, one
+   * shown from the memo is not run on the preview that is going away
+   */
+  if (run)
+  {
+    pending_effect = BEAUTIFY_EFFECT_NONE;
+    apply_effect ();
+  }
+  else
+  {
+    g_array_free (ops, TRUE);
+    ops = NULL;
+  }
+
   gimp_image_delete(preview_image);
   gimp_image_delete(preview_image_cache);
   gimp_image_delete(thumbnail);
   gtk_widget_destroy (dialog);
+  preview_surface_free (preview_surface);
+  preview_inspector_free (inspector);
+  inspector = NULL;
+  if (inspector_smart_colors)
+    g_array_free (inspector_smart_colors, TRUE);
+  inspector_smart_colors = NULL;
+  if (!run)
+  {
+    g_free (recipe_border);
+    recipe_border = NULL;
+  }
+  effect_base_drop ();
+
+  while (memo)
+  {
+    PreviewMemo *entry = memo->data;
+    g_free (entry->pixels);
+    g_free (entry);
+    memo = g_list_delete_link (memo, memo);
+  }
 
   return run;
 }
@@ -548,11 +1122,25 @@ create_base_page (GtkNotebook *notebook) {
                    G_CALLBACK (definition_update),
                    NULL);
 
+  /* auto levels */
+  GtkWidget *button = gtk_button_new_with_label ("Auto Levels");
+  gtk_box_pack_start (GTK_BOX (thispage), button, FALSE, FALSE, 0);
+  gtk_widget_show (button);
+
+  g_signal_connect (button, "clicked",
+                   G_CALLBACK (auto_levels_pressed),
+                   NULL);
+
   gtk_notebook_append_page_menu (notebook, thispage, pagelabel, NULL);
 }
 
 static void adjustment_update () {
-  adjustment (preview_image);
+  sync_preview_image ();
+  /* the current effect gets recorded on the next click now,
+   * the remembered previews can not be shown again
+   */
+  memo_evict ();
+  adjustment (preview_image, &bvals);
   preview_update (preview);
 }
 
@@ -710,6 +1298,15 @@ create_color_page (GtkNotebook *notebook) {
   gtk_table_attach_defaults (GTK_TABLE (table), event_box, 2, 3, 2, 3);
   gtk_widget_show (event_box);
 
+  /* auto white balance */
+  GtkWidget *button = gtk_button_new_with_label ("Auto White Balance");
+  gtk_box_pack_start (GTK_BOX (thispage), button, FALSE, FALSE, 0);
+  gtk_widget_show (button);
+
+  g_signal_connect (button, "clicked",
+                   G_CALLBACK (auto_white_balance_pressed),
+                   NULL);
+
   gtk_notebook_append_page_menu (notebook, thispage, pagelabel, NULL);
 }
 
@@ -737,38 +1334,75 @@ yellow_blue_update (GtkRange *range, gpointer data) {
   adjustment_update ();
 }
 
-static void
-adjustment (gint32 image) {
-  if (bvals.brightness == 0 && bvals.contrast == 0 && bvals.saturation == 0 && bvals.definition == 0 && bvals.hue == 0 && bvals.cyan_red == 0 && bvals.magenta_green == 0 && bvals.yellow_blue == 0)
-    return;
+static gboolean
+has_adjustment (const BeautifyValues *vals)
+{
+  return (vals->brightness != 0 || vals->contrast != 0 || vals->saturation != 0 || vals->definition != 0 || vals->hue != 0 || vals->cyan_red != 0 || vals->magenta_green != 0 || vals->yellow_blue != 0);
+}
 
+static void
+adjustment (gint32 image, const BeautifyValues *vals) {
   if (image == preview_image) {
     /* need to save previous image for preview,
      * since bvals should to apply origin image,
      * otherwise, they would accumulate and result in unwanted effect.
      */
     if (!saved_image) {
+      if (!has_adjustment (vals))
+        return;
       gtk_widget_hide (effect_option);
+      effect_base_drop ();
       saved_image = gimp_image_duplicate (preview_image);
     }
+    gimp_image_delete (preview_image);
     preview_image = gimp_image_duplicate (saved_image);
     image = preview_image;
   }
+
+  run_adjustment (image, vals, NULL);
+}
+
+/* the adjustments of vals on the active layer, curves left over by the
+ * effects run before go into the same pass
+ */
+static void
+run_adjustment (gint32 image, const BeautifyValues *vals, const ColorLut *curves)
+{
+  if (!has_adjustment (vals) && (!curves || color_lut_is_identity (curves)))
+    return;
   gint32 layer = gimp_image_get_active_layer (image);
 
-  if (bvals.brightness != 0 || bvals.contrast != 0)
+  /* the point operations are evaluated together in one pass */
+  BeautifyAdjust adjust;
+  adjust_from_values (&adjust, vals, curves);
+
+  beautify_adjust_run (layer, &adjust);
+
+  run_definition (image, layer, vals);
+}
+
+/* the point operations of vals, after curves if not NULL */
+static void
+adjust_from_values (BeautifyAdjust *adjust, const BeautifyValues *vals, const ColorLut *curves)
+{
+  beautify_adjust_init (adjust);
+
+  if (curves)
+    beautify_adjust_curves (adjust, curves);
+
+  if (vals->brightness != 0 || vals->contrast != 0)
   {
     gint low_input = 0;
     gint high_input = 255;
     gint low_output = 0;
     gint high_output = 255;
 
-    if (bvals.brightness > 0)
-      high_input -= bvals.brightness;
-    if (bvals.brightness < 0)
-      high_output += bvals.brightness;
+    if (vals->brightness > 0)
+      high_input -= vals->brightness;
+    if (vals->brightness < 0)
+      high_output += vals->brightness;
 
-    gint value = 62 * (bvals.contrast / 50.0);
+    gint value = 62 * (vals->contrast / 50.0);
     if (value > 0) {
       low_input += value;
       high_input -= value;
@@ -778,69 +1412,376 @@ adjustment (gint32 image) {
       high_output += value;
     }
 
-    gimp_levels (layer, GIMP_HISTOGRAM_VALUE,
-                 low_input, high_input,
-                 1,
-                 low_output, high_output);
+    beautify_adjust_levels (adjust,
+                            low_input, high_input,
+                            1,
+                            low_output, high_output);
   }
 
-  if (bvals.saturation != 0 || bvals.hue)
-    gimp_hue_saturation (layer, GIMP_ALL_HUES, bvals.hue, 0, bvals.saturation);
+  if (vals->saturation != 0 || vals->hue)
+    beautify_adjust_hue_saturation (adjust, vals->hue, vals->saturation);
 
-  if (bvals.definition > 0)
+  if (vals->cyan_red != 0 || vals->magenta_green != 0 || vals->yellow_blue != 0)
+  {
+    beautify_adjust_color_balance (adjust, GIMP_SHADOWS, TRUE,
+                                   vals->cyan_red, vals->magenta_green, vals->yellow_blue);
+    beautify_adjust_color_balance (adjust, GIMP_MIDTONES, TRUE,
+                                   vals->cyan_red, vals->magenta_green, vals->yellow_blue);
+    beautify_adjust_color_balance (adjust, GIMP_HIGHLIGHTS, TRUE,
+                                   vals->cyan_red, vals->magenta_green, vals->yellow_blue);
+  }
+}
+
+/* definition looks at neighbour pixels, it runs after the point operations */
+static void
+run_definition (gint32 image, gint32 layer, const BeautifyValues *vals)
+{
+  if (vals->definition > 0)
   {
     gint       nreturn_vals;
     GimpParam *return_vals;
-    gint32     percent = 78 * (bvals.definition / 50);
+    gint32     percent = 78 * (vals->definition / 50);
     return_vals = gimp_run_procedure ("plug-in-sharpen",
                                       &nreturn_vals,
                                       GIMP_PDB_INT32, GIMP_RUN_NONINTERACTIVE,
-                                      GIMP_PDB_IMAGE, image_ID,
+                                      GIMP_PDB_IMAGE, image,
                                       GIMP_PDB_DRAWABLE, layer,
                                       GIMP_PDB_INT32, percent,
                                       GIMP_PDB_END);
     gimp_destroy_params (return_vals, nreturn_vals);
   }
-  else if (bvals.definition < 0)
+  else if (vals->definition < 0)
   {
-    // TODO
-  }
+    /* soften without halos: edge preserving smoothing, stronger
+     * settings keep only the stronger edges
+     */
+    gdouble strength = -vals->definition / 50.0;
+    gint    size;
 
-  if (bvals.cyan_red != 0 || bvals.magenta_green != 0 || bvals.yellow_blue != 0)
-  {
-    gimp_color_balance (layer, GIMP_SHADOWS, TRUE,
-                        bvals.cyan_red, bvals.magenta_green, bvals.yellow_blue);
-    gimp_color_balance (layer, GIMP_MIDTONES, TRUE,
-                        bvals.cyan_red, bvals.magenta_green, bvals.yellow_blue);
-    gimp_color_balance (layer, GIMP_HIGHLIGHTS, TRUE,
-                        bvals.cyan_red, bvals.magenta_green, bvals.yellow_blue);
+    /* the inspector renders parts of the real image */
+    if (image == preview_image)
+      size = MIN (gimp_image_width (image), gimp_image_height (image));
+    else
+      size = MIN (width, height);
+
+    guided_filter_run (layer, definition_radius (size), 0.01 * strength * strength);
   }
 }
 
-static void
-reset_pressed (GtkButton *button, gpointer user_date)
+/* the smoothing radius follows the image size,
+ * so the preview looks like the result
+ */
+static gint
+definition_radius (gint size)
 {
-  reset_adjustment ();
-  cancel_effect ();
-
-  gimp_image_delete (real_image);
-  gimp_image_delete (preview_image);
-  real_image = gimp_image_duplicate (image_ID);
-  preview_image = gimp_image_duplicate(preview_image_cache);
-  preview_update (preview);
+  return MAX (1, ROUND (size / 200.0));
 }
 
-static void
-preview_update (GtkWidget *preview)
+/* the layer the sliders apply to, as it is before the adjustments */
+static gint32
+adjustment_source ()
 {
-  gint preview_size = PREVIEW_SIZE;
-  gint max_size = height;
-  if (height < width)
-    max_size = width;
-  if (preview_size > max_size)
-    preview_size = max_size;
-  GdkPixbuf *pixbuf = gimp_image_get_thumbnail (preview_image, preview_size, preview_size, GIMP_PIXBUF_SMALL_CHECKS);
-  gtk_image_set_from_pixbuf (GTK_IMAGE(preview), pixbuf);
+  sync_preview_image ();
+
+  return gimp_image_get_active_layer (saved_image ? saved_image : preview_image);
+}
+
+static void
+auto_levels_pressed (GtkButton *button, gpointer user_data)
+{
+  ImageStats stats;
+
+  image_stats_collect (&stats, adjustment_source (), 0);
+  if (stats.count == 0)
+    return;
+
+  gint low = image_stats_percentile (&stats, IMAGE_STATS_LUMINANCE, 0.005);
+  gint high = image_stats_percentile (&stats, IMAGE_STATS_LUMINANCE, 0.995);
+
+  /* see adjustment (): contrast moves both input ends in by the same
+   * amount, brightness moves the high input further down
+   */
+  gint contrast_value = CLAMP (ROUND (MIN (low, 255 - high) * 50 / 62.0), 0, 50);
+  gint value = 62 * (contrast_value / 50.0);
+  gint brightness_value = CLAMP (255 - high - value, 0, 127);
+
+  gtk_range_set_value (GTK_RANGE (contrast), contrast_value);
+  gtk_range_set_value (GTK_RANGE (brightness), brightness_value);
+}
+
+static void
+auto_white_balance_pressed (GtkButton *button, gpointer user_data)
+{
+  ImageStats stats;
+
+  image_stats_collect (&stats, adjustment_source (), 0);
+  if (stats.count == 0 || !stats.has_color)
+    return;
+
+  gdouble red = image_stats_mean (&stats, IMAGE_STATS_RED);
+  gdouble green = image_stats_mean (&stats, IMAGE_STATS_GREEN);
+  gdouble blue = image_stats_mean (&stats, IMAGE_STATS_BLUE);
+  gdouble gray = (red + green + blue) / 3;
+
+  /* gray world: move the channel means together. The three ranges
+   * of the color balance add up to 0.7 * value / 100 on a channel.
+   */
+  gdouble scale = 100 / (0.7 * 255);
+
+  gtk_range_set_value (GTK_RANGE (cyan_red), CLAMP (ROUND ((gray - red) * scale), -50, 50));
+  gtk_range_set_value (GTK_RANGE (magenta_green), CLAMP (ROUND ((gray - green) * scale), -50, 50));
+  gtk_range_set_value (GTK_RANGE (yellow_blue), CLAMP (ROUND ((gray - blue) * scale), -50, 50));
+}
+
+static gchar *
+recipe_file_dialog (GtkWidget *parent, gboolean save)
+{
+  GtkWidget *chooser;
+  gchar     *filename = NULL;
+
+  chooser = gtk_file_chooser_dialog_new (save ? "Save Recipe" : "Load Recipe",
+                                         GTK_WINDOW (parent),
+                                         save ? GTK_FILE_CHOOSER_ACTION_SAVE : GTK_FILE_CHOOSER_ACTION_OPEN,
+                                         GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL,
+                                         save ? GTK_STOCK_SAVE : GTK_STOCK_OPEN, GTK_RESPONSE_ACCEPT,
+                                         NULL);
+  gtk_file_chooser_set_do_overwrite_confirmation (GTK_FILE_CHOOSER (chooser), TRUE);
+
+  if (gtk_dialog_run (GTK_DIALOG (chooser)) == GTK_RESPONSE_ACCEPT)
+    filename = gtk_file_chooser_get_filename (GTK_FILE_CHOOSER (chooser));
+
+  gtk_widget_destroy (chooser);
+
+  return filename;
+}
+
+static void
+save_recipe_pressed (GtkButton *button, gpointer user_data)
+{
+  gchar *filename = recipe_file_dialog (user_data, TRUE);
+
+  if (!filename)
+    return;
+
+  /* the recorded ops and what is being tried now */
+  GArray        *steps = g_array_new (FALSE, FALSE, sizeof (BeautifyValues));
+  BeautifyValues op;
+  GError        *error = NULL;
+
+  g_array_append_vals (steps, ops->data, ops->len);
+  current_op (&op);
+  if (op.effect != BEAUTIFY_EFFECT_NONE || has_adjustment (&op))
+    g_array_append_val (steps, op);
+
+  if (!beautify_recipe_save (filename, (BeautifyValues *) steps->data, steps->len,
+                             recipe_border, &error))
+  {
+    g_message ("Could not save recipe '%s': %s",
+               gimp_filename_to_utf8 (filename), error->message);
+    g_error_free (error);
+  }
+
+  g_array_free (steps, TRUE);
+  g_free (filename);
+}
+
+static void
+load_recipe_pressed (GtkButton *button, gpointer user_data)
+{
+  gchar  *filename = recipe_file_dialog (user_data, FALSE);
+  GError *error = NULL;
+  GArray *steps;
+  gchar  *border;
+  gint    i;
+
+  if (!filename)
+    return;
+
+  steps = beautify_recipe_load (filename, &border, &error);
+  if (!steps)
+  {
+    g_message ("Could not read recipe '%s': %s",
+               gimp_filename_to_utf8 (filename), error->message);
+    g_error_free (error);
+    g_free (filename);
+    return;
+  }
+
+  /* start over from the original, then run the steps on the preview */
+  reset_adjustment ();
+  cancel_effect ();
+  gimp_image_delete (preview_image);
+  preview_image = gimp_image_duplicate (preview_image_cache);
+
+  for (i = 0; i < steps->len; i++)
+  {
+    const BeautifyValues *step = &g_array_index (steps, BeautifyValues, i);
+    BeautifyEffectEntry   entry = { step->effect, step->opacity };
+    ColorLut              rest;
+
+    run_effect_stack (preview_image, &entry, 1,
+                      gimp_image_width (preview_image), gimp_image_height (preview_image),
+                      0, 0, &rest);
+    run_adjustment (preview_image, step, &rest);
+  }
+
+  g_array_set_size (ops, 0);
+  g_array_append_vals (ops, steps->data, steps->len);
+  source_version = ++last_version;
+
+  g_free (recipe_border);
+  recipe_border = border;
+
+  preview_update (preview);
+
+  g_array_free (steps, TRUE);
+  g_free (filename);
+}
+
+static void
+reset_pressed (GtkButton *button, gpointer user_date)
+{
+  reset_adjustment ();
+  cancel_effect ();
+
+  g_array_set_size (ops, 0);
+  source_version = 0;
+
+  gimp_image_delete (preview_image);
+  preview_image = gimp_image_duplicate(preview_image_cache);
+  preview_update (preview);
+}
+
+static void
+preview_update (GtkWidget *preview)
+{
+  preview_surface_draw_image (preview_surface, preview_image);
+  inspector_refresh ();
+}
+
+static void
+inspector_refresh ()
+{
+  if (inspector)
+  {
+    /* the context the whole pipeline needs around each tile */
+    BeautifyValues op;
+    gint           halo = 0;
+    gint           i;
+
+    current_op (&op);
+    for (i = 0; i <= ops->len; i++)
+    {
+      const BeautifyValues *vals = i < ops->len ? &g_array_index (ops, BeautifyValues, i) : &op;
+      halo += effect_halo (vals->effect);
+      if (vals->definition > 0)
+        halo += 1;
+      else if (vals->definition < 0)
+        halo += GUIDED_FILTER_HALO (definition_radius (MIN (width, height)));
+    }
+
+    inspector_smart_colors_valid = FALSE;
+    preview_inspector_invalidate (inspector, halo);
+  }
+}
+
+/* fit the curves of each Smart Color the way OK will. Until an op has
+ * changed pixels they come from the real drawable, as on OK. After that
+ * the ops are replayed on a copy of the preview and fitted on it, which
+ * is close to OK as Smart Color only samples the image down anyway, but
+ * not exact. Replaying them on the real image would cost as much as OK.
+ */
+static void
+inspector_fit_smart_colors ()
+{
+  BeautifyValues op;
+  gint32         image = -1;
+  gint           i, last = -1;
+
+  if (!inspector_smart_colors)
+    inspector_smart_colors = g_array_new (FALSE, FALSE, sizeof (ColorLut));
+  g_array_set_size (inspector_smart_colors, 0);
+  inspector_smart_colors_valid = TRUE;
+
+  current_op (&op);
+  for (i = 0; i <= ops->len; i++)
+  {
+    const BeautifyValues *vals = i < ops->len ? &g_array_index (ops, BeautifyValues, i) : &op;
+    if (vals->effect == BEAUTIFY_EFFECT_SMART_COLOR && vals->opacity > 0)
+      last = i;
+  }
+
+  if (last < 0)
+    return;
+
+  for (i = 0; i <= last; i++)
+  {
+    const BeautifyValues *vals = i < ops->len ? &g_array_index (ops, BeautifyValues, i) : &op;
+    BeautifyEffectEntry   entry = { vals->effect, vals->opacity };
+    ColorLut              lut;
+
+    if (vals->effect == BEAUTIFY_EFFECT_SMART_COLOR && vals->opacity > 0)
+    {
+      color_lut_init (&lut);
+      effect_color_lut (image == -1 ? gimp_image_get_active_layer (image_ID)
+                                    : gimp_image_get_active_layer (image),
+                        vals->effect, &lut);
+      g_array_append_val (inspector_smart_colors, lut);
+    }
+
+    if (i == last)
+      break;
+
+    if (image == -1 &&
+        (vals->effect == BEAUTIFY_EFFECT_NONE || vals->opacity == 0) &&
+        !has_adjustment (vals))
+      continue;
+
+    if (image == -1)
+      image = gimp_image_duplicate (preview_image_cache);
+
+    run_effect_stack (image, &entry, 1,
+                      gimp_image_width (image), gimp_image_height (image),
+                      0, 0, &lut);
+    run_adjustment (image, vals, &lut);
+  }
+
+  if (image != -1)
+    gimp_image_delete (image);
+}
+
+static void
+inspector_render (gint32 image, gint offset_x, gint offset_y, gpointer data)
+{
+  BeautifyValues op;
+
+  if (!inspector_smart_colors_valid)
+    inspector_fit_smart_colors ();
+  effect_set_region_smart_colors ((ColorLut *) inspector_smart_colors->data,
+                                  inspector_smart_colors->len);
+
+  run_ops (image, offset_x, offset_y);
+
+  current_op (&op);
+  run_op (image, &op, offset_x, offset_y);
+
+  effect_set_region_smart_colors (NULL, 0);
+}
+
+static void
+inspector_toggled (GtkToggleButton *button, gpointer data)
+{
+  if (gtk_toggle_button_get_active (button))
+  {
+    gtk_widget_hide (preview);
+    gtk_widget_show (inspector->widget);
+    preview_inspector_update (inspector);
+  }
+  else
+  {
+    gtk_widget_hide (inspector->widget);
+    gtk_widget_show (preview);
+  }
 }
 
 static GtkWidget*
@@ -870,11 +1811,76 @@ effect_opacity_update (GtkRange *range, gpointer data) {
     return;
   }
 
+  sync_preview_image ();
+  memo_evict ();
+
   gdouble opacity = gtk_range_get_value (range);
   gint32 layer = gimp_image_get_active_layer (preview_image);
   gimp_layer_set_opacity (layer, opacity);
 
-  preview_update (preview);
+  if (effect_base_prepare ())
+  {
+    ColorLut lut;
+    gint     rowstride;
+    guchar  *pixels = preview_surface_get_pixels (preview_surface, &rowstride);
+
+    color_lut_init (&lut);
+    color_lut_mix (&lut, &effect_base_lut, opacity / 100.0);
+    color_lut_apply (&lut, effect_base, pixels,
+                     rowstride / 4 * preview_surface->height, 4);
+    preview_surface_flatten (preview_surface);
+    inspector_refresh ();
+  }
+  else
+  {
+    preview_update (preview);
+  }
+}
+
+static gboolean
+effect_base_prepare ()
+{
+  gint     num_layers;
+  gint    *layers;
+  gboolean pointwise = FALSE;
+
+  if (effect_base)
+    return TRUE;
+
+  /* the effect layer is on top of the layer it was made from,
+   * under a selection it is masked and not mapped as a whole
+   */
+  layers = gimp_image_get_layers (preview_image, &num_layers);
+  if (num_layers >= 2 && gimp_drawable_is_rgb (layers[1]) &&
+      gimp_selection_is_empty (preview_image))
+  {
+    color_lut_init (&effect_base_lut);
+    pointwise = effect_color_lut (layers[1], current_effect, &effect_base_lut);
+  }
+
+  if (pointwise)
+  {
+    gint    rowstride;
+    guchar *pixels;
+
+    gimp_drawable_set_visible (layers[0], FALSE);
+    preview_surface_composite_image (preview_surface, preview_image);
+    gimp_drawable_set_visible (layers[0], TRUE);
+
+    pixels = preview_surface_get_pixels (preview_surface, &rowstride);
+    effect_base = g_memdup (pixels, rowstride * preview_surface->height);
+  }
+
+  g_free (layers);
+
+  return pointwise;
+}
+
+static void
+effect_base_drop ()
+{
+  g_free (effect_base);
+  effect_base = NULL;
 }
 
 static void
@@ -890,6 +1896,9 @@ create_effect_pages (GtkNotebook *notebook) {
 
   GtkWidget *page = gtk_notebook_get_nth_page (notebook, 0);
   effects_switch_page(notebook, page, 0, NULL);
+
+  /* the other pages are built in the background */
+  prefetch_id = g_idle_add_full (G_PRIORITY_LOW, prefetch_effects, notebook, NULL);
 }
 
 static void
@@ -903,98 +1912,118 @@ create_effect_page (GtkNotebook *notebook, gchar *str) {
   gtk_notebook_append_page_menu (notebook, thispage, pagelabel, NULL);
 }
 
-static void
-effects_switch_page (GtkNotebook *notebook, GtkWidget *page, guint page_num, gpointer user_data)
+static const BeautifyEffectType *
+page_effects (guint page_num, guint *n_effects)
 {
-  static time_t effects_timestamp [] = {0, 0, 0, 0, 0, 0};
-
-  if (effects_timestamp[page_num] > 0)
-    return;
-
-  // fix gtk2
-  page = gtk_notebook_get_nth_page (notebook, page_num);
-
-  const BeautifyEffectType* effects;
-  guint n_effects;
-
   switch (page_num)
   {
     case 0:
-    {
-      effects = basic_effects;
-      n_effects = G_N_ELEMENTS (basic_effects);
-      break;
-    }
+      *n_effects = G_N_ELEMENTS (basic_effects);
+      return basic_effects;
     case 1:
-    {
-      effects = lomo_effects;
-      n_effects = G_N_ELEMENTS (lomo_effects);
-      break;
-    }
+      *n_effects = G_N_ELEMENTS (lomo_effects);
+      return lomo_effects;
     case 2:
-    {
-      effects = studio_effects;
-      n_effects = G_N_ELEMENTS (studio_effects);
-      break;
-    }
+      *n_effects = G_N_ELEMENTS (studio_effects);
+      return studio_effects;
     case 3:
-    {
-      effects = fashion_effects;
-      n_effects = G_N_ELEMENTS (fashion_effects);
-      break;
-    }
+      *n_effects = G_N_ELEMENTS (fashion_effects);
+      return fashion_effects;
     case 4:
-    {
-      effects = art_effects;
-      n_effects = G_N_ELEMENTS (art_effects);
-      break;
-    }
+      *n_effects = G_N_ELEMENTS (art_effects);
+      return art_effects;
     case 5:
-    {
-      effects = gradient_effects;
-      n_effects = G_N_ELEMENTS (gradient_effects);
-      break;
-    }
+      *n_effects = G_N_ELEMENTS (gradient_effects);
+      return gradient_effects;
   }
 
-  gtk_container_set_border_width (GTK_CONTAINER (page), 0);
-  gtk_widget_set_size_request (page, -1, 480);
-
-  /* scrolled window */
-  GtkWidget *scrolled_window = gtk_scrolled_window_new (NULL, NULL);
-  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window), GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
-  gtk_box_pack_start (GTK_BOX (page), scrolled_window, TRUE, TRUE, 0);
-  gtk_widget_show (scrolled_window);
+  *n_effects = 0;
+  return NULL;
+}
 
-  /* table */
-  gint rows = 5;
+/* add the next missing icon of a page, creating the table first if needed,
+ * returns FALSE when the page is complete
+ */
+static gboolean
+effect_page_add_icon (GtkNotebook *notebook, guint page_num)
+{
+  guint n_effects;
+  const BeautifyEffectType *effects = page_effects (page_num, &n_effects);
   gint cols = 3;
-  GtkWidget *table = gtk_table_new (rows, cols, FALSE);
-  gtk_table_set_col_spacings (GTK_TABLE (table), 6);
-  gtk_table_set_row_spacings (GTK_TABLE (table), 6);
-  gtk_container_set_border_width (GTK_CONTAINER (table), 10);
-  gtk_scrolled_window_add_with_viewport (GTK_SCROLLED_WINDOW (scrolled_window), table);
-  gtk_widget_show (table);
 
-  gint row = 1;
-  gint col = 1;
+  if (effect_icons[page_num] >= n_effects)
+    return FALSE;
 
-  gint i;
-  for (i = 0; i < n_effects; i++)
+  if (!effect_tables[page_num])
+  {
+    // fix gtk2
+    GtkWidget *page = gtk_notebook_get_nth_page (notebook, page_num);
+
+    gtk_container_set_border_width (GTK_CONTAINER (page), 0);
+    gtk_widget_set_size_request (page, -1, 480);
+
+    /* scrolled window */
+    GtkWidget *scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+    gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window), GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+    gtk_box_pack_start (GTK_BOX (page), scrolled_window, TRUE, TRUE, 0);
+    gtk_widget_show (scrolled_window);
+
+    /* table */
+    gint rows = 5;
+    GtkWidget *table = gtk_table_new (rows, cols, FALSE);
+    gtk_table_set_col_spacings (GTK_TABLE (table), 6);
+    gtk_table_set_row_spacings (GTK_TABLE (table), 6);
+    gtk_container_set_border_width (GTK_CONTAINER (table), 10);
+    gtk_scrolled_window_add_with_viewport (GTK_SCROLLED_WINDOW (scrolled_window), table);
+    gtk_widget_show (table);
+
+    effect_tables[page_num] = table;
+  }
+
+  guint i = effect_icons[page_num]++;
+  gint row = i / cols;
+  gint col = i % cols;
+
+  GtkWidget *icon = effect_icon_new (effects[i]);
+  gtk_table_attach_defaults (GTK_TABLE (effect_tables[page_num]), icon, col, col + 1, row, row + 1);
+  gtk_widget_show (icon);
+
+  return effect_icons[page_num] < n_effects;
+}
+
+static void
+effects_switch_page (GtkNotebook *notebook, GtkWidget *page, guint page_num, gpointer user_data)
+{
+  /* the user is waiting for this page, finish it now */
+  while (effect_page_add_icon (notebook, page_num))
+    ;
+}
+
+/* warm the other pages one icon at a time while the dialog is idle */
+static gboolean
+prefetch_effects (gpointer data)
+{
+  GtkNotebook *notebook = data;
+  guint        page_num;
+
+  /* user input goes first, try again on the next idle */
+  if (gdk_events_pending ())
+    return TRUE;
+
+  for (page_num = 0; page_num < G_N_ELEMENTS (effect_icons); page_num++)
   {
-    GtkWidget *icon = effect_icon_new (effects[i]);
-    gtk_table_attach_defaults (GTK_TABLE (table), icon, col - 1, col, row - 1, row);
-    gtk_widget_show (icon);
+    guint n_effects;
+    page_effects (page_num, &n_effects);
 
-    col++;
-    if (col > cols)
+    if (effect_icons[page_num] < n_effects)
     {
-      row++;
-      col = 1;
+      effect_page_add_icon (notebook, page_num);
+      return TRUE;
     }
   }
 
-  effects_timestamp[page_num] = time (NULL);
+  prefetch_id = 0;
+  return FALSE;
 }
 
 static GtkWidget *
@@ -1202,74 +2231,198 @@ effect_icon_new (BeautifyEffectType effect)
 static gboolean
 select_effect (GtkWidget *widget, GdkEvent *event, gpointer user_data)
 {
-  apply_effect();
-  reset_adjustment ();
-
-
   BeautifyEffectType effect = (BeautifyEffectType) user_data;
-  run_effect (preview_image, effect);
-  current_effect = effect;
-  preview_update (preview);
+  BeautifyValues     op;
+
+  /* an effect that was not touched is replaced by the next one instead
+   * of being stacked, so users can compare effects by clicking around
+   */
+  current_op (&op);
+  if (op.effect != BEAUTIFY_EFFECT_NONE && op.opacity == 100 && !has_adjustment (&op))
+  {
+    cancel_effect ();
+  }
+  else
+  {
+    apply_effect ();
+    reset_adjustment ();
+    current_effect = BEAUTIFY_EFFECT_NONE;
+  }
 
   /* effect option */
   gtk_range_set_value (GTK_RANGE (effect_opacity), 100);
+
+  current_effect = effect;
+  current_op (&op);
+
+  PreviewMemo *entry = memo_lookup (&op);
+  if (entry)
+  {
+    gint    rowstride;
+    guchar *pixels = preview_surface_get_pixels (preview_surface, &rowstride);
+
+    memcpy (pixels, entry->pixels, rowstride * preview_surface->height);
+    preview_surface_flush (preview_surface);
+    pending_effect = effect;
+    inspector_refresh ();
+  }
+  else
+  {
+    run_effect (preview_image, effect);
+    preview_update (preview);
+    memo_store (&op);
+  }
+
   gtk_widget_show (effect_option);
 
   return TRUE;
 }
 
+static gboolean
+same_values (const BeautifyValues *a, const BeautifyValues *b)
+{
+  return (a->brightness == b->brightness &&
+          a->contrast == b->contrast &&
+          a->saturation == b->saturation &&
+          a->definition == b->definition &&
+          a->hue == b->hue &&
+          a->cyan_red == b->cyan_red &&
+          a->magenta_green == b->magenta_green &&
+          a->yellow_blue == b->yellow_blue &&
+          a->effect == b->effect &&
+          a->opacity == b->opacity);
+}
+
+static PreviewMemo *
+memo_lookup (const BeautifyValues *key)
+{
+  GList *list;
+
+  for (list = memo; list; list = list->next)
+  {
+    PreviewMemo *entry = list->data;
+
+    if (entry->version == source_version && same_values (&entry->key, key))
+    {
+      /* most recently used first */
+      memo = g_list_remove_link (memo, list);
+      memo = g_list_concat (list, memo);
+      return entry;
+    }
+  }
+
+  return NULL;
+}
+
+static void
+memo_store (const BeautifyValues *key)
+{
+  PreviewMemo *entry;
+  gint         rowstride;
+  guchar      *pixels = preview_surface_get_pixels (preview_surface, &rowstride);
+
+  if (g_list_length (memo) >= MEMO_SIZE)
+  {
+    GList *last = g_list_last (memo);
+
+    entry = last->data;
+    g_free (entry->pixels);
+    g_free (entry);
+    memo = g_list_delete_link (memo, last);
+  }
+
+  entry = g_new (PreviewMemo, 1);
+  entry->key = *key;
+  entry->version = source_version;
+  entry->pixels = g_memdup (pixels, rowstride * preview_surface->height);
+
+  memo = g_list_prepend (memo, entry);
+}
+
+/* drop the previews rendered over the current source */
+static void
+memo_evict ()
+{
+  GList *list = memo;
+
+  while (list)
+  {
+    GList       *next = list->next;
+    PreviewMemo *entry = list->data;
+
+    if (entry->version == source_version)
+    {
+      g_free (entry->pixels);
+      g_free (entry);
+      memo = g_list_delete_link (memo, list);
+    }
+
+    list = next;
+  }
+}
+
+/* run the effect shown from the memo on preview_image */
+static void
+sync_preview_image ()
+{
+  if (pending_effect == BEAUTIFY_EFFECT_NONE)
+    return;
+
+  run_effect (preview_image, pending_effect);
+  pending_effect = BEAUTIFY_EFFECT_NONE;
+}
+
 static void
 reset_adjustment ()
 {
-  if (bvals.brightness != 0) {
-    bvals.brightness = 0;
+  BeautifyValues old = bvals;
+
+  /* clear all values first, the sliders' callbacks must not
+   * see a half reset state
+   */
+  bvals.brightness = 0;
+  bvals.contrast = 0;
+  bvals.saturation = 0;
+  bvals.definition = 0;
+  bvals.hue = 0;
+  bvals.cyan_red = 0;
+  bvals.magenta_green = 0;
+  bvals.yellow_blue = 0;
+
+  if (old.brightness != 0)
     gtk_range_set_value (GTK_RANGE (brightness), 0);
-  }
-  if (bvals.contrast != 0) {
-    bvals.contrast = 0;
+  if (old.contrast != 0)
     gtk_range_set_value (GTK_RANGE (contrast), 0);
-  }
-  if (bvals.saturation != 0) {
-    bvals.saturation = 0;
+  if (old.saturation != 0)
     gtk_range_set_value (GTK_RANGE (saturation), 0);
-  }
-  if (bvals.definition != 0) {
-    bvals.definition = 0;
+  if (old.definition != 0)
     gtk_range_set_value (GTK_RANGE (definition), 0);
-  }
-  if (bvals.hue != 0) {
-    bvals.hue = 0;
+  if (old.hue != 0)
     gtk_range_set_value (GTK_RANGE (hue), 0);
-  }
-  if (bvals.cyan_red != 0) {
-    bvals.cyan_red = 0;
+  if (old.cyan_red != 0)
     gtk_range_set_value (GTK_RANGE (cyan_red), 0);
-  }
-  if (bvals.magenta_green != 0) {
-    bvals.magenta_green = 0;
+  if (old.magenta_green != 0)
     gtk_range_set_value (GTK_RANGE (magenta_green), 0);
-  }
-  if (bvals.yellow_blue != 0) {
-    bvals.yellow_blue = 0;
+  if (old.yellow_blue != 0)
     gtk_range_set_value (GTK_RANGE (yellow_blue), 0);
-  }
 }
 
 static void
 apply_effect ()
 {
   gtk_widget_hide (effect_option);
-  /* apply effect to real image */
-  if (current_effect != BEAUTIFY_EFFECT_NONE) {
-    run_effect(real_image, current_effect);
-    /* update opacity */
-    gdouble opacity = gtk_range_get_value (GTK_RANGE (effect_opacity));
-    if (opacity < 100) {
-      gint32 layer = gimp_image_get_active_layer (real_image);
-      gimp_layer_set_opacity (layer, opacity);
-    }
+  effect_base_drop ();
+  sync_preview_image ();
+  /* record effect and adjustments for the real image,
+   * entries which would not change anything are dropped
+   */
+  BeautifyValues op;
+  current_op (&op);
+  if (op.effect != BEAUTIFY_EFFECT_NONE || has_adjustment (&op))
+  {
+    g_array_append_val (ops, op);
+    source_version = ++last_version;
   }
-  adjustment(real_image);
 
   /* del saved_image if necessary */
   if (saved_image) {
@@ -1278,6 +2431,17 @@ apply_effect ()
   }
 }
 
+/* the effect and adjustments being edited, not recorded yet */
+static void
+current_op (BeautifyValues *op)
+{
+  *op = bvals;
+  op->effect = current_effect;
+  op->opacity = gtk_range_get_value (GTK_RANGE (effect_opacity));
+  if (op->effect != BEAUTIFY_EFFECT_NONE && op->opacity <= 0)
+    op->effect = BEAUTIFY_EFFECT_NONE;
+}
+
 static void
 cancel_effect ()
 {
@@ -1285,8 +2449,18 @@ cancel_effect ()
     return;
   }
 
-  gint32 current_layer = gimp_image_get_active_layer (preview_image);
-  gimp_drawable_delete (current_layer);
+  effect_base_drop ();
+
+  if (pending_effect != BEAUTIFY_EFFECT_NONE)
+  {
+    /* never made it into preview_image */
+    pending_effect = BEAUTIFY_EFFECT_NONE;
+  }
+  else
+  {
+    gint32 current_layer = gimp_image_get_active_layer (preview_image);
+    gimp_drawable_delete (current_layer);
+  }
 
   current_effect = BEAUTIFY_EFFECT_NONE;
 
@@ -0,0 +1,184 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <libgimp/gimp.h>
+
+#include "border-render.h"
+
+void
+border_slices_init (BorderSlices        *slices,
+                    const BorderTexture *texture,
+                    gint                 width,
+                    gint                 height)
+{
+  gdouble margin;
+
+  slices->texture = texture;
+  slices->width = width;
+  slices->height = height;
+
+  /* the texture is cut in the middle of its edges, leaving at least
+   * length pixels to repeat, small images take less of it
+   */
+  if (width > texture->width - texture->length)
+    margin = ((gdouble) texture->width - texture->left - texture->right - texture->length) / 2;
+  else
+    margin = ((gdouble) width - texture->left - texture->right) / 2;
+  slices->left = margin + texture->left;
+  slices->right = margin + texture->right;
+
+  if (height > texture->height - texture->length)
+    margin = ((gdouble) texture->height - texture->top - texture->bottom - texture->length) / 2;
+  else
+    margin = ((gdouble) height - texture->top - texture->bottom) / 2;
+  slices->top = margin + texture->top;
+  slices->bottom = margin + texture->bottom;
+}
+
+/* the texture column (or row) of canvas column v: in the near slice as
+ * it is, in the far slice counted from the end, in between repeated
+ */
+static gint
+slice_coordinate (gint v,
+                  gint size,
+                  gint near,
+                  gint far,
+                  gint texture_size)
+{
+  gint middle = texture_size - near - far;
+
+  if (v >= size - far)
+    v = texture_size - (size - v);
+  else if (v >= near)
+    v = (middle > 0) ? near + (v - near) % middle : near;
+
+  return CLAMP (v, 0, texture_size - 1);
+}
+
+static inline gboolean
+slices_inside (const BorderSlices *slices,
+               gint                x,
+               gint                y)
+{
+  return (x >= slices->left && x < slices->width - slices->right &&
+          y >= slices->top && y < slices->height - slices->bottom);
+}
+
+/* the border over the pixel d at x, y of the canvas */
+static inline void
+composite_pixel (const BorderSlices *slices,
+                 gint                x,
+                 gint                y,
+                 guchar             *d,
+                 gint                bpp)
+{
+  const BorderTexture *texture = slices->texture;
+  gboolean             has_alpha = (bpp == 2 || bpp == 4);
+  gint                 n_colors = has_alpha ? bpp - 1 : bpp;
+  const guchar        *t;
+  guchar               color[3];
+  gint                 alpha, dest_alpha, total, c;
+
+  t = texture->pixels +
+      slice_coordinate (y, slices->height, slices->top, slices->bottom,
+                        texture->height) * texture->rowstride +
+      slice_coordinate (x, slices->width, slices->left, slices->right,
+                        texture->width) * texture->n_channels;
+
+  alpha = (texture->n_channels == 4) ? t[3] : 255;
+  if (alpha == 0)
+    return;
+
+  if (n_colors == 1)
+    color[0] = (t[0] * 54 + t[1] * 183 + t[2] * 19) >> 8;
+  else
+    memcpy (color, t, 3);
+
+  /* over, in 255 * 255 units of alpha */
+  dest_alpha = has_alpha ? d[n_colors] : 255;
+  total = alpha * 255 + dest_alpha * (255 - alpha);
+
+  for (c = 0; c < n_colors; c++)
+    d[c] = (color[c] * alpha * 255 + d[c] * dest_alpha * (255 - alpha) + total / 2) / total;
+  if (has_alpha)
+    d[n_colors] = (total + 127) / 255;
+}
+
+void
+border_render_rect (const BorderSlices *slices,
+                    guchar             *buf,
+                    gint                x,
+                    gint                y,
+                    gint                width,
+                    gint                height,
+                    gint                bpp)
+{
+  gint i, j;
+
+  for (j = 0; j < height; j++)
+  {
+    guchar *d = buf + (gsize) j * width * bpp;
+
+    for (i = 0; i < width; i++, d += bpp)
+      if (!slices_inside (slices, x + i, y + j))
+        composite_pixel (slices, x + i, y + j, d, bpp);
+  }
+}
+
+void
+border_render (const BorderTexture *texture,
+               gint                 image_width,
+               gint                 image_height,
+               const guchar        *src,
+               gint                 src_width,
+               gint                 src_height,
+               guchar              *dest,
+               gint                 dest_width,
+               gint                 dest_height)
+{
+  BorderSlices slices;
+  gint         width = image_width + texture->left + texture->right;
+  gint         height = image_height + texture->top + texture->bottom;
+  gint         i, j;
+
+  border_slices_init (&slices, texture, width, height);
+
+  /* each dest pixel samples the canvas at its center */
+  for (j = 0; j < dest_height; j++)
+  {
+    gint    y = (gint64) (2 * j + 1) * height / (2 * dest_height);
+    gint    sy = (gint64) (y - texture->top) * src_height / image_height;
+    guchar *d = dest + (gsize) j * dest_width * 4;
+
+    for (i = 0; i < dest_width; i++, d += 4)
+    {
+      gint x = (gint64) (2 * i + 1) * width / (2 * dest_width);
+      gint sx = (gint64) (x - texture->left) * src_width / image_width;
+
+      if (x >= texture->left && x < texture->left + image_width &&
+          y >= texture->top && y < texture->top + image_height)
+        memcpy (d, src + ((gsize) sy * src_width + sx) * 4, 4);
+      else
+        memset (d, 0, 4);
+
+      if (!slices_inside (&slices, x, y))
+        composite_pixel (&slices, x, y, d, 4);
+    }
+  }
+}
@@ -0,0 +1,80 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Borders from a texture cut in nine slices: the corners are copied, the
+ * edges repeated between them. Rendering only reads the texture and
+ * writes the pixels it is given, with no GIMP calls and nothing global,
+ * so borders can be rendered on any thread, several at once.
+ */
+
+typedef struct
+{
+  const guchar *pixels;      /* RGB or RGBA */
+  gint          rowstride;
+  gint          n_channels;
+  gint          width;
+  gint          height;
+  gint          top;         /* the canvas grows by these around the image */
+  gint          bottom;
+  gint          left;
+  gint          right;
+  gint          length;      /* of the edges kept to repeat */
+} BorderTexture;
+
+/* the slices of a texture for a canvas of width x height */
+typedef struct
+{
+  const BorderTexture *texture;
+  gint                 width;
+  gint                 height;
+  gint                 left;     /* the size of the outer slices */
+  gint                 right;
+  gint                 top;
+  gint                 bottom;
+} BorderSlices;
+
+void border_slices_init (BorderSlices        *slices,
+                         const BorderTexture *texture,
+                         gint                 width,
+                         gint                 height);
+
+/* composite the border over the rectangle x, y, width, height of the
+ * canvas in buf, with the "normal" mode. buf holds gray or RGB pixels,
+ * with or without alpha, the pixels inside the border are left as they
+ * are.
+ */
+void border_render_rect (const BorderSlices  *slices,
+                         guchar              *buf,
+                         gint                 x,
+                         gint                 y,
+                         gint                 width,
+                         gint                 height,
+                         gint                 bpp);
+
+/* the canvas of an image of image_width x image_height with its border,
+ * at dest_width x dest_height RGBA pixels. src is the image at any size
+ * in RGBA, scaled into its place.
+ */
+void border_render      (const BorderTexture *texture,
+                         gint                 image_width,
+                         gint                 image_height,
+                         const guchar        *src,
+                         gint                 src_width,
+                         gint                 src_height,
+                         guchar              *dest,
+                         gint                 dest_width,
+                         gint                 dest_height);
@@ -19,6 +19,7 @@
 #include <libgimp/gimpui.h>
 
 #include "border-textures.h"
+#include "preview-surface.h"
 
 #define RIP_BORDER_PROC     "plug-in-rip-border"
 #define TEXTURE_BORDER_PROC "plug-in-texture-border"
@@ -89,6 +90,7 @@ static gint       width;
 static gint       height;
 
 static GtkWidget *preview          = NULL;
+static PreviewSurface *preview_surface = NULL;
 static gint32     preview_image    = 0;
 static gint32     color_layer      = 0;
 static gint32     texture_mask     = 0;
@@ -316,14 +318,7 @@ border (gint32 image_ID)
 static void
 preview_update (GtkWidget *preview)
 {
-  gint preview_size = PREVIEW_SIZE;
-  gint max_size = height;
-  if (height < width)
-    max_size = width;
-  if (preview_size > max_size)
-    preview_size = max_size;
-  GdkPixbuf *pixbuf = gimp_image_get_thumbnail (preview_image, preview_size, preview_size, GIMP_PIXBUF_SMALL_CHECKS);
-  gtk_image_set_from_pixbuf (GTK_IMAGE(preview), pixbuf);
+  preview_surface_draw_image (preview_surface, preview_image);
 }
 
 static void
@@ -440,7 +435,8 @@ border_dialog (const gchar *title, const gchar *help_id, const guint8** textures
                                          GIMP_ADD_BLACK_MASK);
   gimp_layer_add_mask (color_layer, texture_mask);
 
-  preview = gtk_image_new();
+  preview_surface = preview_surface_new (width, height, PREVIEW_SIZE);
+  preview = preview_surface->widget;
   preview_update (preview);
 
   gtk_box_pack_start (GTK_BOX (middle_vbox), preview, TRUE, TRUE, 0);
@@ -479,6 +475,7 @@ border_dialog (const gchar *title, const gchar *help_id, const guint8** textures
   run = (gimp_dialog_run (GIMP_DIALOG (dialog)) == GTK_RESPONSE_OK);
 
   gtk_widget_destroy (dialog);
+  preview_surface_free (preview_surface);
 
   return run;
 }
@@ -0,0 +1,267 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libgimp/gimp.h>
+
+#include "color-lut.h"
+#include "pixel-kernel.h"
+
+void
+color_lut_init (ColorLut *lut)
+{
+  gint c, i;
+
+  for (c = 0; c < 4; c++)
+    for (i = 0; i < 256; i++)
+      lut->lut[c][i] = i;
+}
+
+/* gimp_curve_plot (), the bezier segment between points p2 and p3 */
+static void
+curve_plot (gdouble       *samples,
+            const gdouble *x,
+            const gdouble *y,
+            gint           p1,
+            gint           p2,
+            gint           p3,
+            gint           p4)
+{
+  gdouble x0 = x[p2];
+  gdouble y0 = y[p2];
+  gdouble x3 = x[p3];
+  gdouble y3 = y[p3];
+  gdouble dx = x3 - x0;
+  gdouble dy = y3 - y0;
+  gdouble y1, y2, slope;
+  gint    i;
+
+  if (dx <= 0)
+    return;
+
+  if (p1 == p2 && p3 == p4)
+  {
+    /* a straight line */
+    y1 = y0 + dy / 3.0;
+    y2 = y0 + dy * 2.0 / 3.0;
+  }
+  else if (p1 == p2 && p3 != p4)
+  {
+    slope = (y[p4] - y0) / (x[p4] - x0);
+
+    y2 = y3 - slope * dx / 3.0;
+    y1 = y0 + (y2 - y0) / 2.0;
+  }
+  else if (p1 != p2 && p3 == p4)
+  {
+    slope = (y3 - y[p1]) / (x3 - x[p1]);
+
+    y1 = y0 + slope * dx / 3.0;
+    y2 = y3 + (y1 - y3) / 2.0;
+  }
+  else
+  {
+    slope = (y3 - y[p1]) / (x3 - x[p1]);
+    y1 = y0 + slope * dx / 3.0;
+
+    slope = (y[p4] - y0) / (x[p4] - x0);
+    y2 = y3 - slope * dx / 3.0;
+  }
+
+  for (i = 0; i <= ROUND (dx * 255); i++)
+  {
+    gdouble t = i / dx / 255;
+    gint    index = i + ROUND (x0 * 255);
+
+    if (index < 256)
+      samples[index] = CLAMP (y0 * (1 - t) * (1 - t) * (1 - t) +
+                              3 * y1 * (1 - t) * (1 - t) * t +
+                              3 * y2 * (1 - t) * t * t +
+                              y3 * t * t * t,
+                              0.0, 1.0);
+  }
+}
+
+void
+color_lut_spline (ColorLut        *lut,
+                  ColorLutChannel  channel,
+                  gint             num_points,
+                  const guint8    *control_pts)
+{
+  gdouble samples[256];
+  gdouble x[17], y[17];
+  guchar  map[256];
+  gint    n = MIN (num_points / 2, 17);
+  gint    i;
+
+  if (n < 1)
+    return;
+
+  for (i = 0; i < n; i++)
+  {
+    x[i] = control_pts[i * 2] / 255.0;
+    y[i] = control_pts[i * 2 + 1] / 255.0;
+  }
+
+  /* gimp_curve_calculate (), flat outside the points */
+  for (i = 0; i < 256; i++)
+  {
+    if (i <= ROUND (x[0] * 255))
+      samples[i] = y[0];
+    else if (i >= ROUND (x[n - 1] * 255))
+      samples[i] = y[n - 1];
+  }
+
+  for (i = 0; i < n - 1; i++)
+    curve_plot (samples, x, y,
+                MAX (i - 1, 0), i, i + 1, MIN (i + 2, n - 1));
+
+  for (i = 0; i < 256; i++)
+    map[i] = ROUND (samples[i] * 255);
+
+  color_lut_map (lut, channel, map);
+}
+
+void
+color_lut_map (ColorLut        *lut,
+               ColorLutChannel  channel,
+               const guchar    *map)
+{
+  gint i;
+
+  for (i = 0; i < 256; i++)
+    lut->lut[channel][i] = map[lut->lut[channel][i]];
+}
+
+void
+color_lut_mix (ColorLut       *lut,
+               const ColorLut *next,
+               gdouble         opacity)
+{
+  guchar map[256];
+  gint   c, i;
+
+  for (c = COLOR_LUT_RED; c <= COLOR_LUT_BLUE; c++)
+  {
+    for (i = 0; i < 256; i++)
+    {
+      gint value = next->lut[c][next->lut[COLOR_LUT_VALUE][i]];
+
+      map[i] = ROUND (i + opacity * (value - i));
+    }
+
+    color_lut_map (lut, c, map);
+  }
+}
+
+gboolean
+color_lut_is_identity (const ColorLut *lut)
+{
+  gint c, i;
+
+  for (c = 0; c < 4; c++)
+    for (i = 0; i < 256; i++)
+      if (lut->lut[c][i] != i)
+        return FALSE;
+
+  return TRUE;
+}
+
+/* the value table chained with each color table */
+typedef struct
+{
+  guchar lut[3][256];
+} FusedLut;
+
+static void
+color_lut_pixels (const guchar *src,
+                  guchar       *dest,
+                  gint          n_pixels,
+                  gint          bpp,
+                  gpointer      data)
+{
+  const FusedLut *fused = data;
+  const guchar   *r = fused->lut[0];
+  const guchar   *g = fused->lut[1];
+  const guchar   *b = fused->lut[2];
+  gint            alpha = (bpp == 2 || bpp == 4) ? bpp - 1 : -1;
+
+  if (bpp < 3)
+  {
+    for (; n_pixels--; src += bpp, dest += bpp)
+    {
+      dest[0] = r[src[0]];
+      if (alpha > 0)
+        dest[alpha] = src[alpha];
+    }
+    return;
+  }
+
+  for (; n_pixels--; src += bpp, dest += bpp)
+  {
+    dest[0] = r[src[0]];
+    dest[1] = g[src[1]];
+    dest[2] = b[src[2]];
+    if (alpha > 0)
+      dest[alpha] = src[alpha];
+  }
+}
+
+static void
+fuse (FusedLut       *fused,
+      const ColorLut *lut,
+      gboolean        has_color)
+{
+  gint c, i;
+
+  if (has_color)
+  {
+    for (c = 0; c < 3; c++)
+      for (i = 0; i < 256; i++)
+        fused->lut[c][i] = lut->lut[COLOR_LUT_RED + c][lut->lut[COLOR_LUT_VALUE][i]];
+  }
+  else
+  {
+    for (i = 0; i < 256; i++)
+      fused->lut[0][i] = lut->lut[COLOR_LUT_VALUE][i];
+  }
+}
+
+void
+color_lut_apply (const ColorLut *lut,
+                 const guchar   *src,
+                 guchar         *dest,
+                 gint            n_pixels,
+                 gint            bpp)
+{
+  FusedLut fused;
+
+  fuse (&fused, lut, bpp >= 3);
+  color_lut_pixels (src, dest, n_pixels, bpp, &fused);
+}
+
+void
+color_lut_run (gint32          drawable_ID,
+               const ColorLut *lut)
+{
+  FusedLut fused;
+
+  if (color_lut_is_identity (lut))
+    return;
+
+  fuse (&fused, lut, gimp_drawable_is_rgb (drawable_ID));
+  pixel_kernel_run (drawable_ID, color_lut_pixels, &fused);
+}
@@ -0,0 +1,70 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Per channel lookup tables, as the Curves tool has them: the value
+ * table applies to every channel first, then the red, green and blue
+ * tables to their own channel. Gray drawables only use the value table.
+ * Tables are built and chained up front, the pixels are then mapped in
+ * one pass.
+ */
+
+typedef enum
+{
+  COLOR_LUT_VALUE,
+  COLOR_LUT_RED,
+  COLOR_LUT_GREEN,
+  COLOR_LUT_BLUE,
+} ColorLutChannel;
+
+typedef struct
+{
+  guchar lut[4][256];
+} ColorLut;
+
+void     color_lut_init        (ColorLut        *lut);
+
+/* chain the curve of gimp_curves_spline () after the channel,
+ * points are num_points / 2 pairs of input and output values
+ */
+void     color_lut_spline      (ColorLut        *lut,
+                                ColorLutChannel  channel,
+                                gint             num_points,
+                                const guint8    *control_pts);
+
+/* chain a table after the channel */
+void     color_lut_map         (ColorLut        *lut,
+                                ColorLutChannel  channel,
+                                const guchar    *map);
+
+/* chain next after each color channel, mixed with the input
+ * at opacity (0..1)
+ */
+void     color_lut_mix         (ColorLut        *lut,
+                                const ColorLut  *next,
+                                gdouble          opacity);
+
+gboolean color_lut_is_identity (const ColorLut  *lut);
+
+/* map a buffer of RGB, RGBA, gray or gray alpha pixels */
+void     color_lut_apply       (const ColorLut  *lut,
+                                const guchar    *src,
+                                guchar          *dest,
+                                gint             n_pixels,
+                                gint             bpp);
+
+void     color_lut_run         (gint32           drawable_ID,
+                                const ColorLut  *lut);
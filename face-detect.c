@@ -0,0 +1,443 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <libgimp/gimp.h>
+
+#include "face-detect.h"
+#include "pixel-kernel.h"
+
+/* the windows grow by this factor, and move by this part of their size */
+#define SCALE_FACTOR  1.1
+#define STRIDE_FACTOR 0.1
+
+/* windows overlapping more than this are the same face */
+#define OVERLAP 0.3
+
+/* the sum of the scores of a face found by several windows */
+#define MIN_SCORE 5.0
+
+/* the smallest faces looked for, in pixels and of the smaller side */
+#define MIN_SIZE     20
+#define MIN_FRACTION 20
+
+struct _FaceCascade
+{
+  gint    depth;
+  gint    n_trees;
+  gint8  *codes;        /* four per node, the nodes of a tree from 1 */
+  gfloat *predictions;  /* per leaf */
+  gfloat *thresholds;   /* per tree */
+};
+
+typedef struct
+{
+  const FaceCascade *cascade;
+  const guchar      *gray;
+  gint               width;
+  gint               height;
+  gint               size;     /* of the windows */
+  gint               step;
+  gint               offset;   /* of the first window center */
+  GArray           **hits;     /* one per thread */
+} Scan;
+
+static gint32
+read_int32 (const gchar *data)
+{
+  guint32 value;
+
+  memcpy (&value, data, 4);
+  return (gint32) GUINT32_FROM_LE (value);
+}
+
+static gfloat
+read_float (const gchar *data)
+{
+  union { guint32 i; gfloat f; } value;
+
+  memcpy (&value.i, data, 4);
+  value.i = GUINT32_FROM_LE (value.i);
+  return value.f;
+}
+
+FaceCascade *
+face_cascade_load (const gchar  *filename,
+                   GError      **error)
+{
+  FaceCascade *cascade;
+  gchar       *data;
+  gsize        length;
+  gint         depth, n_trees, n_nodes, n_leaves;
+  gsize        tree_size;
+  gint         t, i;
+
+  if (!g_file_get_contents (filename, &data, &length, error))
+    return NULL;
+
+  /* two floats not used here, the depth and the number of trees */
+  depth = (length >= 16) ? read_int32 (data + 8) : 0;
+  n_trees = (length >= 16) ? read_int32 (data + 12) : 0;
+  n_nodes = (1 << CLAMP (depth, 0, 16)) - 1;
+  n_leaves = n_nodes + 1;
+  tree_size = 4 * n_nodes + 4 * n_leaves + 4;
+
+  if (depth < 1 || depth > 16 || n_trees < 1 ||
+      (gsize) n_trees > (length - 16) / tree_size)
+  {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                 "'%s' is not a face cascade", gimp_filename_to_utf8 (filename));
+    g_free (data);
+    return NULL;
+  }
+
+  cascade = g_new (FaceCascade, 1);
+  cascade->depth = depth;
+  cascade->n_trees = n_trees;
+  cascade->codes = g_new (gint8, (gsize) n_trees * n_nodes * 4);
+  cascade->predictions = g_new (gfloat, (gsize) n_trees * n_leaves);
+  cascade->thresholds = g_new (gfloat, n_trees);
+
+  for (t = 0; t < n_trees; t++)
+  {
+    const gchar *tree = data + 16 + t * tree_size;
+
+    memcpy (cascade->codes + (gsize) t * n_nodes * 4, tree, 4 * n_nodes);
+    for (i = 0; i < n_leaves; i++)
+      cascade->predictions[(gsize) t * n_leaves + i] = read_float (tree + 4 * n_nodes + 4 * i);
+    cascade->thresholds[t] = read_float (tree + 4 * n_nodes + 4 * n_leaves);
+  }
+
+  g_free (data);
+
+  return cascade;
+}
+
+void
+face_cascade_free (FaceCascade *cascade)
+{
+  if (!cascade)
+    return;
+
+  g_free (cascade->codes);
+  g_free (cascade->predictions);
+  g_free (cascade->thresholds);
+  g_free (cascade);
+}
+
+/* run the trees on the window of size pixels centered at row, col, each
+ * node compares the pixels at two offsets given in 1/256 of the size.
+ * FALSE as soon as the sum of the outputs falls below a threshold.
+ */
+static gboolean
+cascade_classify (const FaceCascade *cascade,
+                  const guchar      *gray,
+                  gint               width,
+                  gint               height,
+                  gint               row,
+                  gint               col,
+                  gint               size,
+                  gfloat            *score)
+{
+  gint   n_nodes = (1 << cascade->depth) - 1;
+  gint   n_leaves = n_nodes + 1;
+  gfloat sum = 0;
+  gint   t, j;
+
+  row *= 256;
+  col *= 256;
+
+  if ((row + 128 * size) / 256 >= height || (row - 128 * size) / 256 < 0 ||
+      (col + 128 * size) / 256 >= width || (col - 128 * size) / 256 < 0)
+    return FALSE;
+
+  for (t = 0; t < cascade->n_trees; t++)
+  {
+    const gint8 *codes = cascade->codes + (gsize) t * n_nodes * 4;
+    gint         node = 1;
+
+    for (j = 0; j < cascade->depth; j++)
+    {
+      const gint8 *code = codes + (node - 1) * 4;
+      guchar       p1 = gray[(row + code[0] * size) / 256 * width + (col + code[1] * size) / 256];
+      guchar       p2 = gray[(row + code[2] * size) / 256 * width + (col + code[3] * size) / 256];
+
+      node = 2 * node + (p1 <= p2);
+    }
+
+    sum += cascade->predictions[(gsize) t * n_leaves + node - n_leaves];
+    if (sum <= cascade->thresholds[t])
+      return FALSE;
+  }
+
+  *score = sum - cascade->thresholds[cascade->n_trees - 1];
+  return TRUE;
+}
+
+/* the window centers on rows [start, end) of a scan */
+static void
+scan_rows (gint start, gint end, gint thread, gpointer data)
+{
+  Scan *scan = data;
+  gint  i, col;
+
+  for (i = start; i < end; i++)
+  {
+    gint row = scan->offset + i * scan->step;
+
+    for (col = scan->offset; col <= scan->width - scan->offset; col += scan->step)
+    {
+      Face face;
+
+      if (!cascade_classify (scan->cascade, scan->gray, scan->width, scan->height,
+                             row, col, scan->size, &face.score))
+        continue;
+
+      face.x = col;
+      face.y = row;
+      face.size = scan->size;
+      g_array_append_val (scan->hits[thread], face);
+    }
+  }
+}
+
+/* intersection over union of two square windows */
+static gdouble
+overlap (const Face *a,
+         const Face *b)
+{
+  gdouble width = MIN (a->x + a->size / 2, b->x + b->size / 2) -
+                  MAX (a->x - a->size / 2, b->x - b->size / 2);
+  gdouble height = MIN (a->y + a->size / 2, b->y + b->size / 2) -
+                   MAX (a->y - a->size / 2, b->y - b->size / 2);
+  gdouble intersection;
+
+  if (width <= 0 || height <= 0)
+    return 0;
+
+  intersection = width * height;
+  return intersection / (a->size * a->size + b->size * b->size - intersection);
+}
+
+/* the hits around each one not taken yet make a face, placed at their
+ * mean, with the sum of their scores
+ */
+static GArray *
+cluster (const GArray *hits)
+{
+  GArray   *faces = g_array_new (FALSE, FALSE, sizeof (Face));
+  gboolean *taken = g_new0 (gboolean, hits->len);
+  gint      i, j;
+
+  for (i = 0; i < hits->len; i++)
+  {
+    const Face *seed = &g_array_index (hits, Face, i);
+    Face        face = { 0, 0, 0, 0 };
+    gint        n = 0;
+
+    if (taken[i])
+      continue;
+
+    for (j = i; j < hits->len; j++)
+    {
+      const Face *hit = &g_array_index (hits, Face, j);
+
+      if (taken[j] || overlap (seed, hit) <= OVERLAP)
+        continue;
+
+      taken[j] = TRUE;
+      face.x += hit->x;
+      face.y += hit->y;
+      face.size += hit->size;
+      face.score += hit->score;
+      n++;
+    }
+
+    face.x /= n;
+    face.y /= n;
+    face.size /= n;
+
+    if (face.score >= MIN_SCORE)
+      g_array_append_val (faces, face);
+  }
+
+  g_free (taken);
+
+  return faces;
+}
+
+GArray *
+face_detect (const FaceCascade *cascade,
+             const guchar      *gray,
+             gint               width,
+             gint               height,
+             gint               min_size)
+{
+  GArray *hits = g_array_new (FALSE, FALSE, sizeof (Face));
+  GArray *faces;
+  Scan    scan;
+  gdouble size;
+  gint    i;
+
+  scan.cascade = cascade;
+  scan.gray = gray;
+  scan.width = width;
+  scan.height = height;
+  scan.hits = g_new (GArray *, pixel_kernel_num_threads ());
+  for (i = 0; i < pixel_kernel_num_threads (); i++)
+    scan.hits[i] = g_array_new (FALSE, FALSE, sizeof (Face));
+
+  /* every window size, its rows spread over the threads */
+  for (size = MAX (min_size, 1); size <= MIN (width, height); size *= SCALE_FACTOR)
+  {
+    scan.size = size;
+    scan.step = MAX (1, STRIDE_FACTOR * size);
+    scan.offset = scan.size / 2 + 1;
+
+    if (height - 2 * scan.offset < 0)
+      break;
+
+    pixel_kernel_parallel ((height - 2 * scan.offset) / scan.step + 1, scan_rows, &scan);
+  }
+
+  for (i = 0; i < pixel_kernel_num_threads (); i++)
+  {
+    g_array_append_vals (hits, scan.hits[i]->data, scan.hits[i]->len);
+    g_array_free (scan.hits[i], TRUE);
+  }
+  g_free (scan.hits);
+
+  faces = cluster (hits);
+  g_array_free (hits, TRUE);
+
+  return faces;
+}
+
+GArray *
+face_detect_rgb (const FaceCascade *cascade,
+                 const guchar      *buf,
+                 gint               width,
+                 gint               height,
+                 gint               bpp)
+{
+  gint    n_pixels = width * height;
+  guchar *gray = g_new (guchar, n_pixels);
+  GArray *faces;
+  gint    i;
+
+  /* GIMP_RGB_LUMINANCE in 8 bit fixed point */
+  for (i = 0; i < n_pixels; i++, buf += bpp)
+    gray[i] = (bpp < 3) ? buf[0] : (buf[0] * 54 + buf[1] * 183 + buf[2] * 19) >> 8;
+
+  faces = face_detect (cascade, gray, width, height,
+                       MAX (MIN_SIZE, MIN (width, height) / MIN_FRACTION));
+  g_free (gray);
+
+  return faces;
+}
+
+GArray *
+face_detect_drawable (const FaceCascade *cascade,
+                      gint32             drawable_ID,
+                      gint               max_size)
+{
+  GArray *faces;
+  guchar *buf;
+  gint    x, y, width, height;
+  gint    step = 1;
+  gint    columns, rows, bpp;
+
+  if (!gimp_drawable_mask_intersect (drawable_ID, &x, &y, &width, &height))
+    return g_array_new (FALSE, FALSE, sizeof (Face));
+
+  if (max_size > 0 && MAX (width, height) > max_size)
+    step = ceil ((gdouble) MAX (width, height) / max_size);
+
+  columns = (width + step - 1) / step;
+  rows = (height + step - 1) / step;
+  buf = pixel_kernel_sample (drawable_ID, x, y, width, height, &columns, &rows, &bpp);
+  if (!buf)
+    return g_array_new (FALSE, FALSE, sizeof (Face));
+
+  faces = face_detect_rgb (cascade, buf, columns, rows, bpp);
+  face_scale (faces, (gdouble) width / columns);
+
+  g_free (buf);
+
+  return faces;
+}
+
+void
+face_scale (GArray  *faces,
+            gdouble  scale)
+{
+  gint i;
+
+  for (i = 0; i < faces->len; i++)
+  {
+    Face *face = &g_array_index (faces, Face, i);
+
+    face->x *= scale;
+    face->y *= scale;
+    face->size *= scale;
+  }
+}
+
+/* the face, as wide again to the sides and above, twice its size below */
+static void
+face_area (const Face *face,
+           gfloat     *x1,
+           gfloat     *y1,
+           gfloat     *x2,
+           gfloat     *y2)
+{
+  *x1 = face->x - face->size;
+  *x2 = face->x + face->size;
+  *y1 = face->y - face->size;
+  *y2 = face->y + 2 * face->size;
+}
+
+gboolean
+face_near (const GArray *faces,
+           gint          x,
+           gint          y)
+{
+  return face_near_rect (faces, x, y, 1, 1);
+}
+
+gboolean
+face_near_rect (const GArray *faces,
+                gint          x,
+                gint          y,
+                gint          width,
+                gint          height)
+{
+  gint i;
+
+  for (i = 0; i < faces->len; i++)
+  {
+    gfloat x1, y1, x2, y2;
+
+    face_area (&g_array_index (faces, Face, i), &x1, &y1, &x2, &y2);
+    if (x + width > x1 && x < x2 && y + height > y1 && y < y2)
+      return TRUE;
+  }
+
+  return FALSE;
+}
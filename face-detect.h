@@ -0,0 +1,87 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Face detection with a cascade of pixel intensity comparison trees, as
+ * in the PICO object detector (Markus, Frljak, Pandzic, Ahlberg,
+ * Forchheimer). Each tree looks at pairs of pixels placed relative to
+ * the window, so no integral image or rescaled image is needed, and a
+ * window is given up as soon as the sum of the tree outputs falls below
+ * a threshold. Windows of growing sizes are scanned over a small gray
+ * copy of the image, the rows of each size split over the threads, and
+ * the overlapping hits are put together.
+ *
+ * The cascade is read from a file in the format of PICO's facefinder:
+ * two floats, the tree depth and the number of trees as 32 bit
+ * integers, then for each tree the codes of its nodes, four signed
+ * bytes each, the outputs of its leaves and its threshold, as floats,
+ * all little endian.
+ */
+
+typedef struct
+{
+  gfloat x;      /* the center */
+  gfloat y;
+  gfloat size;   /* width and height of the face */
+  gfloat score;
+} Face;
+
+typedef struct _FaceCascade FaceCascade;
+
+FaceCascade *face_cascade_load    (const gchar       *filename,
+                                   GError           **error);
+void         face_cascade_free    (FaceCascade       *cascade);
+
+/* the faces of at least min_size pixels in width x height gray pixels,
+ * an array of Face
+ */
+GArray      *face_detect          (const FaceCascade *cascade,
+                                   const guchar      *gray,
+                                   gint               width,
+                                   gint               height,
+                                   gint               min_size);
+
+/* the same on RGB or RGBA pixels */
+GArray      *face_detect_rgb      (const FaceCascade *cascade,
+                                   const guchar      *buf,
+                                   gint               width,
+                                   gint               height,
+                                   gint               bpp);
+
+/* the faces in the selected part of a drawable, searched at about
+ * max_size pixels, in the coordinates of that part
+ */
+GArray      *face_detect_drawable (const FaceCascade *cascade,
+                                   gint32             drawable_ID,
+                                   gint               max_size);
+
+/* scale the faces, for pixels scaled by scale */
+void         face_scale           (GArray            *faces,
+                                   gdouble            scale);
+
+/* whether a pixel is on or around one of the faces: the face itself,
+ * some hair and the neck below it
+ */
+gboolean     face_near            (const GArray      *faces,
+                                   gint               x,
+                                   gint               y);
+
+/* whether any pixel of a rectangle is */
+gboolean     face_near_rect       (const GArray      *faces,
+                                   gint               x,
+                                   gint               y,
+                                   gint               width,
+                                   gint               height);
@@ -0,0 +1,320 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <libgimp/gimp.h>
+
+#include "guided-filter.h"
+#include "pixel-kernel.h"
+
+#define TILE_SIZE 256
+
+typedef struct
+{
+  const guchar *src;     /* rows src_y .. src_y + src_rows of the area */
+  gint          src_y;
+  gint          src_rows;
+  guchar       *dest;    /* rows y .. y + rows */
+  gint          y;
+  gint          rows;
+  const guchar *mask;    /* the selection over rows y .. y + rows, or NULL */
+
+  gint          width;   /* of the area */
+  gint          height;
+  gint          bpp;
+  gint          radius;
+  gfloat        epsilon;
+} Strip;
+
+void
+guided_filter_box_mean (const gfloat *src,
+                        gfloat       *dest,
+                        gfloat       *tmp,
+                        gint          width,
+                        gint          height,
+                        gint          radius)
+{
+  gint   size = 2 * radius + 1;
+  gint   dest_width = width - 2 * radius;
+  gint   dest_height = height - 2 * radius;
+  gfloat scale = 1.0 / (size * size);
+  gint   x, y;
+
+  /* horizontal running sums */
+  for (y = 0; y < height; y++)
+  {
+    const gfloat *s = src + y * width;
+    gfloat       *t = tmp + y * dest_width;
+    gfloat        sum = 0;
+
+    for (x = 0; x < size; x++)
+      sum += s[x];
+
+    t[0] = sum;
+    for (x = 1; x < dest_width; x++)
+    {
+      sum += s[x + size - 1] - s[x - 1];
+      t[x] = sum;
+    }
+  }
+
+  /* vertical running sums, a row at a time */
+  gfloat *d = dest;
+
+  for (x = 0; x < dest_width; x++)
+    d[x] = 0;
+  for (y = 0; y < size; y++)
+    for (x = 0; x < dest_width; x++)
+      d[x] += tmp[y * dest_width + x];
+
+  for (y = 1; y < dest_height; y++)
+  {
+    const gfloat *add = tmp + (y + size - 1) * dest_width;
+    const gfloat *sub = tmp + (y - 1) * dest_width;
+    gfloat       *prev = d;
+
+    d += dest_width;
+    for (x = 0; x < dest_width; x++)
+      d[x] = prev[x] + add[x] - sub[x];
+  }
+
+  for (x = 0; x < dest_width * dest_height; x++)
+    dest[x] *= scale;
+}
+
+void
+guided_filter_plane (const gfloat *src,
+                     gfloat       *dest,
+                     gint          width,
+                     gint          height,
+                     gint          radius,
+                     gfloat        epsilon)
+{
+  /* the means of src are needed one radius into the halo,
+   * for the means of a and b
+   */
+  gint    outer_width = width + 4 * radius;
+  gint    outer_height = height + 4 * radius;
+  gint    inner_width = width + 2 * radius;
+  gint    inner_height = height + 2 * radius;
+  gint    n_outer = outer_width * outer_height;
+  gint    n_inner = inner_width * inner_height;
+  gint    x, y, i;
+
+  gfloat *square = g_new (gfloat, n_outer);
+  gfloat *tmp = g_new (gfloat, inner_width * outer_height);
+  gfloat *mean = g_new (gfloat, n_inner);
+  gfloat *mean_square = g_new (gfloat, n_inner);
+  gfloat *mean_a = g_new (gfloat, width * height);
+  gfloat *mean_b = g_new (gfloat, width * height);
+
+  for (i = 0; i < n_outer; i++)
+    square[i] = src[i] * src[i];
+
+  guided_filter_box_mean (src, mean, tmp, outer_width, outer_height, radius);
+  guided_filter_box_mean (square, mean_square, tmp, outer_width, outer_height, radius);
+
+  /* a and b of the local linear model, in place of the means */
+  for (i = 0; i < n_inner; i++)
+  {
+    /* rounding in flat areas can leave the difference slightly negative */
+    gfloat variance = MAX (mean_square[i] - mean[i] * mean[i], 0);
+    gfloat a = variance / (variance + epsilon);
+
+    mean_square[i] = a;
+    mean[i] = (1 - a) * mean[i];
+  }
+
+  guided_filter_box_mean (mean_square, mean_a, tmp, inner_width, inner_height, radius);
+  guided_filter_box_mean (mean, mean_b, tmp, inner_width, inner_height, radius);
+
+  for (y = 0; y < height; y++)
+  {
+    const gfloat *s = src + (y + 2 * radius) * outer_width + 2 * radius;
+
+    for (x = 0; x < width; x++)
+    {
+      i = y * width + x;
+      dest[i] = mean_a[i] * s[x] + mean_b[i];
+    }
+  }
+
+  g_free (square);
+  g_free (tmp);
+  g_free (mean);
+  g_free (mean_square);
+  g_free (mean_a);
+  g_free (mean_b);
+}
+
+/* filter the tiles [start, end) of a strip */
+static void
+strip_tiles (gint start, gint end, gint thread, gpointer data)
+{
+  Strip  *strip = data;
+  gint    halo = GUIDED_FILTER_HALO (strip->radius);
+  gint    n_channels = (strip->bpp == 2 || strip->bpp == 4) ? strip->bpp - 1 : strip->bpp;
+  gint    tile;
+
+  for (tile = start; tile < end; tile++)
+  {
+    gint    x1 = tile * TILE_SIZE;
+    gint    width = MIN (TILE_SIZE, strip->width - x1);
+    gint    outer_width = width + 2 * halo;
+    gint    outer_height = strip->rows + 2 * halo;
+    gint    c, x, y;
+
+    /* tiles outside the selection or fully transparent are copied as
+     * they are, and so are tiles which are uniform with their halo, the
+     * filter keeps flat areas as they are
+     */
+    gint          rowstride = strip->width * strip->bpp;
+    const guchar *s = strip->src + (strip->y - strip->src_y) * rowstride + x1 * strip->bpp;
+    gint          halo_x1 = MAX (0, x1 - halo);
+    gint          halo_x2 = MIN (strip->width, x1 + width + halo);
+
+    if ((strip->mask &&
+         !pixel_kernel_mask_any (strip->mask + x1, width, strip->rows, strip->width)) ||
+        pixel_kernel_classify (s, width, strip->rows, rowstride,
+                               strip->bpp) == PIXEL_KERNEL_TILE_TRANSPARENT ||
+        pixel_kernel_classify (strip->src + halo_x1 * strip->bpp, halo_x2 - halo_x1,
+                               strip->src_rows, rowstride,
+                               strip->bpp) == PIXEL_KERNEL_TILE_UNIFORM)
+    {
+      for (y = 0; y < strip->rows; y++)
+        memcpy (strip->dest + (y * strip->width + x1) * strip->bpp,
+                strip->src + ((strip->y + y - strip->src_y) * strip->width + x1) * strip->bpp,
+                width * strip->bpp);
+      continue;
+    }
+
+    gfloat *plane = g_new (gfloat, outer_width * outer_height);
+    gfloat *result = g_new (gfloat, width * strip->rows);
+
+    for (c = 0; c < n_channels; c++)
+    {
+      /* the tile with its halo, edge pixels repeated outside the area */
+      for (y = 0; y < outer_height; y++)
+      {
+        gint          sy = CLAMP (strip->y + y - halo, 0, strip->height - 1) - strip->src_y;
+        const guchar *row = strip->src + sy * strip->width * strip->bpp;
+        gfloat       *p = plane + y * outer_width;
+
+        for (x = 0; x < outer_width; x++)
+        {
+          gint sx = CLAMP (x1 + x - halo, 0, strip->width - 1);
+          p[x] = row[sx * strip->bpp + c] / 255.0;
+        }
+      }
+
+      guided_filter_plane (plane, result, width, strip->rows,
+                           strip->radius, strip->epsilon);
+
+      for (y = 0; y < strip->rows; y++)
+      {
+        guchar *d = strip->dest + (y * strip->width + x1) * strip->bpp + c;
+        gfloat *r = result + y * width;
+
+        for (x = 0; x < width; x++, d += strip->bpp)
+          *d = CLAMP (ROUND (r[x] * 255.0), 0, 255);
+      }
+    }
+
+    /* alpha is not filtered */
+    if (n_channels < strip->bpp)
+      for (y = 0; y < strip->rows; y++)
+      {
+        const guchar *s = strip->src + ((strip->y + y - strip->src_y) * strip->width + x1) * strip->bpp;
+        guchar       *d = strip->dest + (y * strip->width + x1) * strip->bpp;
+
+        for (x = 0; x < width; x++)
+          d[x * strip->bpp + n_channels] = s[x * strip->bpp + n_channels];
+      }
+
+    g_free (plane);
+    g_free (result);
+  }
+}
+
+void
+guided_filter_run (gint32  drawable_ID,
+                   gint    radius,
+                   gdouble epsilon)
+{
+  GimpDrawable    *drawable;
+  GimpPixelRgn     src_rgn, dest_rgn;
+  PixelKernelMask  mask;
+  Strip            strip;
+  gint             x, y, width, height;
+  gint             halo = GUIDED_FILTER_HALO (radius);
+  gint             row;
+
+  if (radius < 1)
+    return;
+
+  if (!gimp_drawable_mask_intersect (drawable_ID, &x, &y, &width, &height))
+    return;
+
+  drawable = gimp_drawable_get (drawable_ID);
+  gimp_tile_cache_ntiles (3 * (width / gimp_tile_width () + 1) *
+                          ((TILE_SIZE + 2 * halo) / gimp_tile_height () + 2));
+
+  strip.width = width;
+  strip.height = height;
+  strip.bpp = drawable->bpp;
+  strip.radius = radius;
+  strip.epsilon = epsilon;
+
+  guchar *src = g_new (guchar, (gsize) width * (TILE_SIZE + 2 * halo) * drawable->bpp);
+  guchar *dest = g_new (guchar, (gsize) width * TILE_SIZE * drawable->bpp);
+
+  gimp_pixel_rgn_init (&src_rgn, drawable, x, y, width, height, FALSE, FALSE);
+  gimp_pixel_rgn_init (&dest_rgn, drawable, x, y, width, height, TRUE, TRUE);
+  pixel_kernel_mask_init (&mask, drawable_ID, x, y, width, TILE_SIZE);
+
+  /* strips of TILE_SIZE rows, read with the halo rows above and below,
+   * the tiles of a strip are spread over the threads, strips outside the
+   * selection are skipped
+   */
+  for (row = 0; row < height; row += TILE_SIZE)
+  {
+    if (!pixel_kernel_mask_read (&mask, y + row, MIN (TILE_SIZE, height - row)))
+      continue;
+
+    strip.mask = mask.buf;
+    strip.y = row;
+    strip.rows = MIN (TILE_SIZE, height - row);
+    strip.src_y = MAX (0, row - halo);
+    strip.src_rows = MIN (height, row + strip.rows + halo) - strip.src_y;
+    strip.src = src;
+    strip.dest = dest;
+
+    gimp_pixel_rgn_get_rect (&src_rgn, src, x, y + strip.src_y, width, strip.src_rows);
+    pixel_kernel_parallel ((width + TILE_SIZE - 1) / TILE_SIZE, strip_tiles, &strip);
+    gimp_pixel_rgn_set_rect (&dest_rgn, dest, x, y + row, width, strip.rows);
+  }
+
+  g_free (src);
+  g_free (dest);
+  pixel_kernel_mask_free (&mask);
+
+  gimp_drawable_flush (drawable);
+  gimp_drawable_merge_shadow (drawable_ID, TRUE);
+  gimp_drawable_update (drawable_ID, x, y, width, height);
+  gimp_drawable_detach (drawable);
+}
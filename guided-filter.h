@@ -0,0 +1,53 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Edge preserving smoothing with the guided filter (He, Sun, Tang),
+ * each color channel guiding itself. Flat areas are averaged over a
+ * (2 * radius + 1) square, edges with a variance well above epsilon are
+ * kept. All the means are box filters done with running sums, so the
+ * cost per pixel does not depend on the radius.
+ */
+
+/* pixels of context needed around each output pixel */
+#define GUIDED_FILTER_HALO(radius) (2 * (radius))
+
+/* mean over (2 * radius + 1) squares, dest is (width - 2 * radius) x
+ * (height - 2 * radius), tmp holds (width - 2 * radius) x height
+ */
+void guided_filter_box_mean (const gfloat *src,
+                             gfloat       *dest,
+                             gfloat       *tmp,
+                             gint          width,
+                             gint          height,
+                             gint          radius);
+
+/* filter one channel of a tile, src is (width + 4 * radius) x
+ * (height + 4 * radius) values in 0..1, dest gets width x height values
+ */
+void guided_filter_plane    (const gfloat *src,
+                             gfloat       *dest,
+                             gint          width,
+                             gint          height,
+                             gint          radius,
+                             gfloat        epsilon);
+
+/* filter the selected part of a drawable, epsilon is a variance with
+ * values in 0..1
+ */
+void guided_filter_run      (gint32        drawable_ID,
+                             gint          radius,
+                             gdouble       epsilon);
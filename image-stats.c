@@ -0,0 +1,155 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <libgimp/gimp.h>
+
+#include "image-stats.h"
+#include "pixel-kernel.h"
+
+typedef guint64 Histograms[4][256];
+
+typedef struct
+{
+  const guchar *buf;
+  gint          bpp;
+  Histograms   *histograms;   /* one per thread */
+} Count;
+
+static void
+count_pixels (gint start, gint end, gint thread, gpointer data)
+{
+  Count        *count = data;
+  guint64     (*histogram)[256] = count->histograms[thread];
+  gint          bpp = count->bpp;
+  const guchar *s = count->buf + (gsize) start * bpp;
+  gint          i;
+
+  switch (bpp)
+  {
+    case 1:
+      for (i = start; i < end; i++, s++)
+        histogram[IMAGE_STATS_LUMINANCE][s[0]]++;
+      break;
+
+    case 2:
+      for (i = start; i < end; i++, s += 2)
+        if (s[1])
+          histogram[IMAGE_STATS_LUMINANCE][s[0]]++;
+      break;
+
+    default:
+      for (i = start; i < end; i++, s += bpp)
+      {
+        if (bpp == 4 && s[3] == 0)
+          continue;
+
+        /* GIMP_RGB_LUMINANCE in 8 bit fixed point */
+        gint luminance = (s[0] * 54 + s[1] * 183 + s[2] * 19) >> 8;
+
+        histogram[IMAGE_STATS_LUMINANCE][luminance]++;
+        histogram[IMAGE_STATS_RED][s[0]]++;
+        histogram[IMAGE_STATS_GREEN][s[1]]++;
+        histogram[IMAGE_STATS_BLUE][s[2]]++;
+      }
+      break;
+  }
+}
+
+void
+image_stats_collect (ImageStats *stats,
+                     gint32      drawable_ID,
+                     gint        max_pixels)
+{
+  Count   count;
+  guchar *buf;
+  gint    x, y, width, height;
+  gint    step = 1;
+  gint    columns, rows, bpp;
+  gint    i, c, v;
+
+  memset (stats, 0, sizeof (ImageStats));
+
+  if (!gimp_drawable_mask_intersect (drawable_ID, &x, &y, &width, &height))
+    return;
+
+  if (max_pixels > 0 && (gdouble) width * height > max_pixels)
+    step = ceil (sqrt ((gdouble) width * height / max_pixels));
+
+  columns = (width + step - 1) / step;
+  rows = (height + step - 1) / step;
+  buf = pixel_kernel_sample (drawable_ID, x, y, width, height, &columns, &rows, &bpp);
+  if (!buf)
+    return;
+
+  stats->has_color = (bpp >= 3);
+
+  count.buf = buf;
+  count.bpp = bpp;
+  count.histograms = g_new0 (Histograms, pixel_kernel_num_threads ());
+
+  pixel_kernel_parallel (columns * rows, count_pixels, &count);
+
+  /* add up the threads */
+  for (i = 0; i < pixel_kernel_num_threads (); i++)
+    for (c = 0; c < 4; c++)
+      for (v = 0; v < 256; v++)
+        stats->histogram[c][v] += count.histograms[i][c][v];
+
+  for (v = 0; v < 256; v++)
+    stats->count += stats->histogram[IMAGE_STATS_LUMINANCE][v];
+
+  g_free (count.histograms);
+  g_free (buf);
+}
+
+gdouble
+image_stats_mean (const ImageStats  *stats,
+                  ImageStatsChannel  channel)
+{
+  gdouble sum = 0;
+  gint    v;
+
+  if (stats->count == 0)
+    return 0;
+
+  for (v = 0; v < 256; v++)
+    sum += (gdouble) v * stats->histogram[channel][v];
+
+  return sum / stats->count;
+}
+
+gint
+image_stats_percentile (const ImageStats  *stats,
+                        ImageStatsChannel  channel,
+                        gdouble            fraction)
+{
+  guint64 limit = fraction * stats->count;
+  guint64 sum = 0;
+  gint    v;
+
+  for (v = 0; v < 255; v++)
+  {
+    sum += stats->histogram[channel][v];
+    if (sum > limit)
+      break;
+  }
+
+  return v;
+}
@@ -0,0 +1,52 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Histograms of a drawable, collected in one pass. The pixels are read by
+ * the main thread, every thread counts into its own histograms, which
+ * are added up at the end. Fully transparent pixels are not counted.
+ */
+
+typedef enum
+{
+  IMAGE_STATS_LUMINANCE,
+  IMAGE_STATS_RED,
+  IMAGE_STATS_GREEN,
+  IMAGE_STATS_BLUE,
+} ImageStatsChannel;
+
+typedef struct
+{
+  gboolean has_color;
+  guint64  count;
+  /* gray drawables fill the luminance histogram only */
+  guint64  histogram[4][256];
+} ImageStats;
+
+/* look at no more than about max_pixels pixels, of a scaled down copy,
+ * 0 looks at all of them
+ */
+void    image_stats_collect    (ImageStats        *stats,
+                                gint32             drawable_ID,
+                                gint               max_pixels);
+
+gdouble image_stats_mean       (const ImageStats  *stats,
+                                ImageStatsChannel  channel);
+
+/* the value below which fraction (0..1) of the pixels are */
+gint    image_stats_percentile (const ImageStats  *stats,
+                                ImageStatsChannel  channel,
+                                gdouble            fraction);
@@ -0,0 +1,407 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libgimp/gimp.h>
+
+#include "pixel-kernel.h"
+
+/* sides of a scaled down sample, at most */
+#define SAMPLE_MAX_SIZE 512
+
+typedef struct
+{
+  PixelKernelRangeFunc func;
+  gpointer             data;
+  gint                 start;
+  gint                 end;
+  gint                 thread;
+} Job;
+
+typedef struct
+{
+  PixelKernelFunc  func;
+  gpointer         data;
+  const guchar    *src;
+  guchar          *dest;
+  gint             width;
+  gint             bpp;
+
+  /* the strip is processed a tile at a time */
+  const guchar    *mask;     /* the selection over the strip, or NULL */
+  gint             rows;
+  gint             columns;
+  gint             tile_width;
+  gint             tile_height;
+} Strip;
+
+gint
+pixel_kernel_num_threads (void)
+{
+  static gint n_threads = 0;
+
+  if (n_threads == 0)
+  {
+    /* follow the number of processors set in GIMP's preferences */
+    gchar *value = gimp_gimprc_query ("num-processors");
+
+    if (value)
+      n_threads = atoi (value);
+    g_free (value);
+
+#if GLIB_CHECK_VERSION (2, 36, 0)
+    if (n_threads < 1)
+      n_threads = g_get_num_processors ();
+#endif
+
+    n_threads = CLAMP (n_threads, 1, PIXEL_KERNEL_MAX_THREADS);
+  }
+
+  return n_threads;
+}
+
+static gpointer
+job_run (gpointer data)
+{
+  Job *job = data;
+
+  job->func (job->start, job->end, job->thread, job->data);
+
+  return NULL;
+}
+
+/* the worker threads live as long as the plug-in, so a batch of
+ * drawables does not start new ones for every strip
+ */
+static GThreadPool *pool = NULL;
+static GAsyncQueue *pool_done = NULL;
+
+static void
+job_pool_run (gpointer data, gpointer user_data)
+{
+  job_run (data);
+  g_async_queue_push (pool_done, data);
+}
+
+static void
+pool_init (void)
+{
+  if (pool)
+    return;
+
+#if !GLIB_CHECK_VERSION (2, 32, 0)
+  if (!g_thread_supported ())
+    g_thread_init (NULL);
+#endif
+
+  pool_done = g_async_queue_new ();
+  pool = g_thread_pool_new (job_pool_run, NULL,
+                            pixel_kernel_num_threads () - 1, TRUE, NULL);
+}
+
+void
+pixel_kernel_parallel (gint                 n_items,
+                       PixelKernelRangeFunc func,
+                       gpointer             data)
+{
+  Job  jobs[PIXEL_KERNEL_MAX_THREADS];
+  gint n_threads = MIN (pixel_kernel_num_threads (), n_items);
+  gint i;
+
+  if (n_items <= 0)
+    return;
+
+  for (i = 0; i < n_threads; i++)
+  {
+    jobs[i].func = func;
+    jobs[i].data = data;
+    jobs[i].start = (gint64) n_items * i / n_threads;
+    jobs[i].end = (gint64) n_items * (i + 1) / n_threads;
+    jobs[i].thread = i;
+  }
+
+  if (n_threads > 1)
+    pool_init ();
+
+  /* the calling thread takes the first part */
+  for (i = 1; i < n_threads; i++)
+    g_thread_pool_push (pool, &jobs[i], NULL);
+
+  job_run (&jobs[0]);
+
+  for (i = 1; i < n_threads; i++)
+    g_async_queue_pop (pool_done);
+}
+
+/* the tiles [start, end) of a strip: tiles outside the selection or fully
+ * transparent are copied as they are, uniform tiles map one pixel
+ */
+static void
+strip_tiles (gint start, gint end, gint thread, gpointer data)
+{
+  Strip *strip = data;
+  gint   bpp = strip->bpp;
+  gsize  rowstride = (gsize) strip->width * bpp;
+  gint   tile;
+
+  for (tile = start; tile < end; tile++)
+  {
+    gint                x1 = (tile % strip->columns) * strip->tile_width;
+    gint                y1 = (tile / strip->columns) * strip->tile_height;
+    gint                width = MIN (strip->tile_width, strip->width - x1);
+    gint                height = MIN (strip->tile_height, strip->rows - y1);
+    const guchar       *src = strip->src + y1 * rowstride + (gsize) x1 * bpp;
+    guchar             *dest = strip->dest + y1 * rowstride + (gsize) x1 * bpp;
+    PixelKernelTileKind kind = PIXEL_KERNEL_TILE_TRANSPARENT;
+    gint                x, y;
+
+    if (!strip->mask ||
+        pixel_kernel_mask_any (strip->mask + (gsize) y1 * strip->width + x1,
+                               width, height, strip->width))
+      kind = pixel_kernel_classify (src, width, height, rowstride, bpp);
+
+    switch (kind)
+    {
+      case PIXEL_KERNEL_TILE_TRANSPARENT:
+        for (y = 0; y < height; y++)
+          memcpy (dest + y * rowstride, src + y * rowstride, (gsize) width * bpp);
+        break;
+
+      case PIXEL_KERNEL_TILE_UNIFORM:
+        strip->func (src, dest, 1, bpp, strip->data);
+        for (y = 0; y < height; y++)
+          for (x = (y == 0); x < width; x++)
+            memcpy (dest + y * rowstride + (gsize) x * bpp, dest, bpp);
+        break;
+
+      default:
+        for (y = 0; y < height; y++)
+          strip->func (src + y * rowstride, dest + y * rowstride,
+                       width, bpp, strip->data);
+        break;
+    }
+  }
+}
+
+PixelKernelTileKind
+pixel_kernel_classify (const guchar *buf,
+                       gint          width,
+                       gint          height,
+                       gint          rowstride,
+                       gint          bpp)
+{
+  gboolean transparent = (bpp == 2 || bpp == 4);
+  gboolean uniform = TRUE;
+  gint     x, y;
+
+  for (y = 0; y < height; y++)
+  {
+    const guchar *p = buf + (gsize) y * rowstride;
+
+    for (x = 0; x < width; x++, p += bpp)
+    {
+      if (transparent && p[bpp - 1])
+        transparent = FALSE;
+      if (uniform && memcmp (p, buf, bpp))
+        uniform = FALSE;
+
+      if (!transparent && !uniform)
+        return PIXEL_KERNEL_TILE_MIXED;
+    }
+  }
+
+  return transparent ? PIXEL_KERNEL_TILE_TRANSPARENT : PIXEL_KERNEL_TILE_UNIFORM;
+}
+
+void
+pixel_kernel_mask_init (PixelKernelMask *mask,
+                        gint32           drawable_ID,
+                        gint             x,
+                        gint             y,
+                        gint             width,
+                        gint             max_rows)
+{
+  gint32 image_ID = gimp_drawable_get_image (drawable_ID);
+  gint   offset_x, offset_y;
+
+  memset (mask, 0, sizeof (PixelKernelMask));
+
+  if (gimp_selection_is_empty (image_ID))
+    return;
+
+  gimp_drawable_offsets (drawable_ID, &offset_x, &offset_y);
+
+  mask->selection = gimp_drawable_get (gimp_image_get_selection (image_ID));
+  mask->x = x + offset_x;
+  mask->y = offset_y;
+  mask->width = width;
+  mask->buf = g_new (guchar, (gsize) width * max_rows);
+
+  gimp_pixel_rgn_init (&mask->rgn, mask->selection, 0, 0,
+                       mask->selection->width, mask->selection->height,
+                       FALSE, FALSE);
+}
+
+gboolean
+pixel_kernel_mask_read (PixelKernelMask *mask,
+                        gint             row,
+                        gint             n_rows)
+{
+  if (!mask->selection)
+    return TRUE;
+
+  gimp_pixel_rgn_get_rect (&mask->rgn, mask->buf,
+                           mask->x, mask->y + row, mask->width, n_rows);
+
+  return pixel_kernel_mask_any (mask->buf, mask->width, n_rows, mask->width);
+}
+
+gboolean
+pixel_kernel_mask_any (const guchar *buf,
+                       gint          width,
+                       gint          height,
+                       gint          rowstride)
+{
+  gint x, y;
+
+  for (y = 0; y < height; y++, buf += rowstride)
+    for (x = 0; x < width; x++)
+      if (buf[x])
+        return TRUE;
+
+  return FALSE;
+}
+
+void
+pixel_kernel_mask_free (PixelKernelMask *mask)
+{
+  if (mask->selection)
+    gimp_drawable_detach (mask->selection);
+  g_free (mask->buf);
+}
+
+guchar *
+pixel_kernel_sample (gint32  drawable_ID,
+                     gint    x,
+                     gint    y,
+                     gint    width,
+                     gint    height,
+                     gint   *dest_width,
+                     gint   *dest_height,
+                     gint   *bpp)
+{
+  GimpDrawable *drawable;
+  GimpPixelRgn  rgn;
+  guchar       *buf;
+
+  if (*dest_width < width || *dest_height < height)
+  {
+    /* the largest thumbnail GIMP makes */
+    gdouble scale = MIN (1.0, (gdouble) SAMPLE_MAX_SIZE / MAX (*dest_width, *dest_height));
+
+    *dest_width = MAX (1, *dest_width * scale);
+    *dest_height = MAX (1, *dest_height * scale);
+
+    return gimp_drawable_get_sub_thumbnail_data (drawable_ID, x, y, width, height,
+                                                 dest_width, dest_height, bpp);
+  }
+
+  drawable = gimp_drawable_get (drawable_ID);
+
+  *dest_width = width;
+  *dest_height = height;
+  *bpp = drawable->bpp;
+
+  buf = g_new (guchar, (gsize) width * height * drawable->bpp);
+  gimp_pixel_rgn_init (&rgn, drawable, x, y, width, height, FALSE, FALSE);
+  gimp_pixel_rgn_get_rect (&rgn, buf, x, y, width, height);
+
+  gimp_drawable_detach (drawable);
+
+  return buf;
+}
+
+void
+pixel_kernel_run (gint32          drawable_ID,
+                  PixelKernelFunc func,
+                  gpointer        data)
+{
+  GimpDrawable    *drawable;
+  GimpPixelRgn     src_rgn, dest_rgn;
+  PixelKernelMask  mask;
+  Strip            strip;
+  gint             x, y, width, height;
+  gint             rows, row;
+  guchar          *src, *dest;
+
+  if (!gimp_drawable_mask_intersect (drawable_ID, &x, &y, &width, &height))
+    return;
+
+  drawable = gimp_drawable_get (drawable_ID);
+
+  /* one row of tiles per thread in each strip */
+  rows = gimp_tile_height () * pixel_kernel_num_threads ();
+  gimp_tile_cache_ntiles (3 * (width / gimp_tile_width () + 1));
+
+  src = g_new (guchar, (gsize) width * rows * drawable->bpp);
+  dest = g_new (guchar, (gsize) width * rows * drawable->bpp);
+
+  gimp_pixel_rgn_init (&src_rgn, drawable, x, y, width, height, FALSE, FALSE);
+  gimp_pixel_rgn_init (&dest_rgn, drawable, x, y, width, height, TRUE, TRUE);
+  pixel_kernel_mask_init (&mask, drawable_ID, x, y, width, rows);
+
+  strip.func = func;
+  strip.data = data;
+  strip.src = src;
+  strip.dest = dest;
+  strip.width = width;
+  strip.bpp = drawable->bpp;
+  strip.mask = mask.buf;
+  strip.tile_width = gimp_tile_width ();
+  strip.tile_height = gimp_tile_height ();
+  strip.columns = (width + strip.tile_width - 1) / strip.tile_width;
+
+  for (row = y; row < y + height; row += rows)
+  {
+    gint n_rows = MIN (rows, y + height - row);
+
+    /* the shadow tiles of a strip which is not selected at all are
+     * not written, merging leaves those pixels alone
+     */
+    if (!pixel_kernel_mask_read (&mask, row, n_rows))
+      continue;
+
+    gimp_pixel_rgn_get_rect (&src_rgn, src, x, row, width, n_rows);
+
+    strip.rows = n_rows;
+    pixel_kernel_parallel (strip.columns * ((n_rows + strip.tile_height - 1) / strip.tile_height),
+                           strip_tiles, &strip);
+
+    gimp_pixel_rgn_set_rect (&dest_rgn, dest, x, row, width, n_rows);
+  }
+
+  g_free (src);
+  g_free (dest);
+  pixel_kernel_mask_free (&mask);
+
+  gimp_drawable_flush (drawable);
+  gimp_drawable_merge_shadow (drawable_ID, TRUE);
+  gimp_drawable_update (drawable_ID, x, y, width, height);
+  gimp_drawable_detach (drawable);
+}
@@ -0,0 +1,121 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Run per pixel code over a drawable in-process, instead of a chain of
+ * PDB calls that each read and write every pixel. The drawable is read
+ * in strips by the main thread (libgimp is not thread safe), the tiles of
+ * a strip are split over worker threads, and the result goes to the
+ * shadow tiles, so the whole operation is one undo step. Only the
+ * bounds of the selection are read, tiles outside the selection are not
+ * processed, and merging the shadow tiles blends the result with the
+ * drawable by the selection mask.
+ */
+
+#define PIXEL_KERNEL_MAX_THREADS 16
+
+/* process n_pixels pixels of bpp bytes, src and dest do not overlap.
+ * Each pixel is mapped on its own and keeps its alpha: fully transparent
+ * tiles are copied without calling it, uniform tiles map one pixel.
+ */
+typedef void (*PixelKernelFunc)      (const guchar *src,
+                                      guchar       *dest,
+                                      gint          n_pixels,
+                                      gint          bpp,
+                                      gpointer      data);
+
+/* process items [start, end), thread is 0 .. pixel_kernel_num_threads () - 1 */
+typedef void (*PixelKernelRangeFunc) (gint          start,
+                                      gint          end,
+                                      gint          thread,
+                                      gpointer      data);
+
+typedef enum
+{
+  PIXEL_KERNEL_TILE_MIXED,
+  PIXEL_KERNEL_TILE_TRANSPARENT,  /* all alpha is 0 */
+  PIXEL_KERNEL_TILE_UNIFORM,      /* all pixels are the same */
+} PixelKernelTileKind;
+
+gint pixel_kernel_num_threads (void);
+
+/* split n_items over the threads and wait for all of them, the threads
+ * are kept for the next call. Not to be called from inside func.
+ */
+void pixel_kernel_parallel    (gint                 n_items,
+                               PixelKernelRangeFunc func,
+                               gpointer             data);
+
+/* the selection over a part of a drawable, read a strip at a time */
+typedef struct
+{
+  GimpDrawable *selection;   /* NULL when nothing is selected */
+  GimpPixelRgn  rgn;
+  gint          x;           /* of the part, in the selection */
+  gint          y;
+  gint          width;
+  guchar       *buf;         /* width x rows of the last strip read */
+} PixelKernelMask;
+
+/* for the part x, y, width of the drawable, in strips of up to max_rows */
+void     pixel_kernel_mask_init (PixelKernelMask      *mask,
+                                 gint32                drawable_ID,
+                                 gint                  x,
+                                 gint                  y,
+                                 gint                  width,
+                                 gint                  max_rows);
+
+/* read rows row .. row + n_rows (in the drawable) into buf, FALSE when
+ * none of them is selected, TRUE without a selection
+ */
+gboolean pixel_kernel_mask_read (PixelKernelMask      *mask,
+                                 gint                  row,
+                                 gint                  n_rows);
+
+/* whether any of width x height values, rowstride apart, is selected */
+gboolean pixel_kernel_mask_any  (const guchar         *buf,
+                                 gint                  width,
+                                 gint                  height,
+                                 gint                  rowstride);
+
+void     pixel_kernel_mask_free (PixelKernelMask      *mask);
+
+/* look at width x height pixels of bpp bytes, rowstride bytes apart */
+PixelKernelTileKind pixel_kernel_classify (const guchar *buf,
+                                           gint          width,
+                                           gint          height,
+                                           gint          rowstride,
+                                           gint          bpp);
+
+/* the part x, y, width x height of the drawable, scaled down to about
+ * *dest_width x *dest_height (both are set to the size returned). A
+ * scaled down copy is made by GIMP from its own tiles, so only that copy
+ * is transferred; its bpp may differ from the drawable's for indexed
+ * drawables. NULL on failure, free with g_free.
+ */
+guchar *pixel_kernel_sample   (gint32               drawable_ID,
+                               gint                 x,
+                               gint                 y,
+                               gint                 width,
+                               gint                 height,
+                               gint                *dest_width,
+                               gint                *dest_height,
+                               gint                *bpp);
+
+/* run func over the selected part of the drawable */
+void pixel_kernel_run         (gint32               drawable_ID,
+                               PixelKernelFunc      func,
+                               gpointer             data);
@@ -0,0 +1,374 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <libgimp/gimp.h>
+#include <libgimp/gimpui.h>
+
+#include "pixel-kernel.h"
+#include "preview-surface.h"
+#include "preview-inspector.h"
+
+#define TILE_SIZE 128
+/* 16MB of RGBA tiles */
+#define MAX_TILES 256
+
+static gint
+tiles_x (PreviewInspector *inspector)
+{
+  return (inspector->width + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+static gpointer
+tile_key (PreviewInspector *inspector, gint tx, gint ty)
+{
+  return GINT_TO_POINTER (ty * tiles_x (inspector) + tx + 1);
+}
+
+/* tiles more than two tiles away from the view */
+static gboolean
+tile_is_far (gpointer key, gpointer value, gpointer data)
+{
+  PreviewInspector *inspector = data;
+  gint index = GPOINTER_TO_INT (key) - 1;
+  gint tx = index % tiles_x (inspector);
+  gint ty = index / tiles_x (inspector);
+
+  return (tx < inspector->x / TILE_SIZE - 2 ||
+          ty < inspector->y / TILE_SIZE - 2 ||
+          tx > (inspector->x + inspector->surface->width) / TILE_SIZE + 2 ||
+          ty > (inspector->y + inspector->surface->height) / TILE_SIZE + 2);
+}
+
+/* render tiles (tx1, ty1) - (tx2, ty2) which are not in the cache yet,
+ * with one run of the render function over their bounding box
+ */
+/* a pixel of bpp bytes as RGBA */
+static inline void
+pixel_to_rgba (const guchar *s,
+               gint          bpp,
+               guchar       *d)
+{
+  if (bpp >= 3)
+  {
+    d[0] = s[0];
+    d[1] = s[1];
+    d[2] = s[2];
+  }
+  else
+  {
+    d[0] = d[1] = d[2] = s[0];
+  }
+  d[3] = (bpp == 2 || bpp == 4) ? s[bpp - 1] : 255;
+}
+
+static void
+render_tiles (PreviewInspector *inspector,
+              gint              tx1,
+              gint              ty1,
+              gint              tx2,
+              gint              ty2)
+{
+  GimpDrawable    *drawable;
+  GimpPixelRgn     src_rgn, dest_rgn;
+  PixelKernelMask  mask;
+  guchar          *buf;
+  guchar          *source;
+  gint             source_bpp;
+  gint             x1, y1, x2, y2;
+  gint          tx, ty;
+
+  x1 = MAX (0, tx1 * TILE_SIZE - inspector->halo);
+  y1 = MAX (0, ty1 * TILE_SIZE - inspector->halo);
+  x2 = MIN (inspector->width, (tx2 + 1) * TILE_SIZE + inspector->halo);
+  y2 = MIN (inspector->height, (ty2 + 1) * TILE_SIZE + inspector->halo);
+
+  gint width = x2 - x1;
+  gint height = y2 - y1;
+
+  gint32 image = gimp_image_new (width, height,
+                                 gimp_drawable_is_gray (inspector->drawable_ID) ? GIMP_GRAY : GIMP_RGB);
+  gimp_image_undo_disable (image);
+
+  gint32 layer = gimp_layer_new (image, "region", width, height,
+                                 gimp_drawable_type (inspector->drawable_ID),
+                                 100, GIMP_NORMAL_MODE);
+  gimp_image_add_layer (image, layer, -1);
+
+  /* copy the source pixels, halo included */
+  drawable = gimp_drawable_get (inspector->drawable_ID);
+  source_bpp = drawable->bpp;
+  source = g_new (guchar, width * height * source_bpp);
+  gimp_pixel_rgn_init (&src_rgn, drawable, x1, y1, width, height, FALSE, FALSE);
+  gimp_pixel_rgn_get_rect (&src_rgn, source, x1, y1, width, height);
+  gimp_drawable_detach (drawable);
+
+  drawable = gimp_drawable_get (layer);
+  gimp_pixel_rgn_init (&dest_rgn, drawable, 0, 0, width, height, TRUE, FALSE);
+  gimp_pixel_rgn_set_rect (&dest_rgn, source, 0, 0, width, height);
+  gimp_drawable_flush (drawable);
+  gimp_drawable_detach (drawable);
+
+  /* the small image has no selection, the result is mixed with the
+   * source by the selection of the region below, as OK does
+   */
+  pixel_kernel_mask_init (&mask, inspector->drawable_ID, x1, y1, width, height);
+  pixel_kernel_mask_read (&mask, y1, height);
+
+  inspector->render (image,
+                     inspector->offset_x + x1, inspector->offset_y + y1,
+                     inspector->render_data);
+
+  layer = gimp_image_merge_visible_layers (image, GIMP_CLIP_TO_IMAGE);
+  gimp_layer_resize_to_image_size (layer);
+
+  drawable = gimp_drawable_get (layer);
+  gint bpp = drawable->bpp;
+  buf = g_new (guchar, width * height * bpp);
+  gimp_pixel_rgn_init (&src_rgn, drawable, 0, 0, width, height, FALSE, FALSE);
+  gimp_pixel_rgn_get_rect (&src_rgn, buf, 0, 0, width, height);
+  gimp_drawable_detach (drawable);
+  gimp_image_delete (image);
+
+  if (g_hash_table_size (inspector->tiles) >= MAX_TILES)
+    g_hash_table_foreach_remove (inspector->tiles, tile_is_far, inspector);
+
+  /* cut the result into RGBA tiles, the halo is thrown away */
+  for (ty = ty1; ty <= ty2; ty++)
+    for (tx = tx1; tx <= tx2; tx++)
+    {
+      gpointer key = tile_key (inspector, tx, ty);
+      gint     x, y;
+
+      if (g_hash_table_lookup (inspector->tiles, key))
+        continue;
+
+      guchar *tile = g_new0 (guchar, TILE_SIZE * TILE_SIZE * 4);
+      gint    tile_width = MIN (TILE_SIZE, inspector->width - tx * TILE_SIZE);
+      gint    tile_height = MIN (TILE_SIZE, inspector->height - ty * TILE_SIZE);
+
+      for (y = 0; y < tile_height; y++)
+      {
+        gint          i = (ty * TILE_SIZE + y - y1) * width + tx * TILE_SIZE - x1;
+        const guchar *s = buf + i * bpp;
+        const guchar *o = source + i * source_bpp;
+        const guchar *m = mask.buf ? mask.buf + i : NULL;
+        guchar       *d = tile + y * TILE_SIZE * 4;
+
+        for (x = 0; x < tile_width; x++, s += bpp, o += source_bpp, d += 4)
+        {
+          pixel_to_rgba (s, bpp, d);
+
+          if (m && m[x] < 255)
+          {
+            guchar original[4];
+            gint   c;
+
+            pixel_to_rgba (o, source_bpp, original);
+            for (c = 0; c < 4; c++)
+              d[c] = original[c] + (d[c] - original[c]) * m[x] / 255;
+          }
+        }
+      }
+
+      g_hash_table_insert (inspector->tiles, key, tile);
+    }
+
+  g_free (buf);
+  g_free (source);
+  pixel_kernel_mask_free (&mask);
+}
+
+void
+preview_inspector_update (PreviewInspector *inspector)
+{
+  PreviewSurface *surface = inspector->surface;
+  guchar         *pixels;
+  gint            rowstride;
+  gint            tx, ty;
+
+  gint tx1 = inspector->x / TILE_SIZE;
+  gint ty1 = inspector->y / TILE_SIZE;
+  gint tx2 = (inspector->x + surface->width - 1) / TILE_SIZE;
+  gint ty2 = (inspector->y + surface->height - 1) / TILE_SIZE;
+
+  /* bounding box of the visible tiles which are not rendered yet */
+  gint mx1 = G_MAXINT, my1 = G_MAXINT;
+  gint mx2 = -1, my2 = -1;
+
+  for (ty = ty1; ty <= ty2; ty++)
+    for (tx = tx1; tx <= tx2; tx++)
+      if (!g_hash_table_lookup (inspector->tiles, tile_key (inspector, tx, ty)))
+      {
+        mx1 = MIN (mx1, tx);
+        my1 = MIN (my1, ty);
+        mx2 = MAX (mx2, tx);
+        my2 = MAX (my2, ty);
+      }
+
+  if (mx2 >= 0)
+    render_tiles (inspector, mx1, my1, mx2, my2);
+
+  pixels = preview_surface_get_pixels (surface, &rowstride);
+
+  for (ty = ty1; ty <= ty2; ty++)
+    for (tx = tx1; tx <= tx2; tx++)
+    {
+      const guchar *tile = g_hash_table_lookup (inspector->tiles, tile_key (inspector, tx, ty));
+      gint          y;
+
+      /* part of the tile inside the view, in view coordinates */
+      gint x1 = MAX (0, tx * TILE_SIZE - inspector->x);
+      gint y1 = MAX (0, ty * TILE_SIZE - inspector->y);
+      gint x2 = MIN (surface->width, (tx + 1) * TILE_SIZE - inspector->x);
+      gint y2 = MIN (surface->height, (ty + 1) * TILE_SIZE - inspector->y);
+
+      for (y = y1; y < y2; y++)
+      {
+        gint sx = x1 + inspector->x - tx * TILE_SIZE;
+        gint sy = y + inspector->y - ty * TILE_SIZE;
+
+        memcpy (pixels + y * rowstride + x1 * 4,
+                tile + (sy * TILE_SIZE + sx) * 4,
+                (x2 - x1) * 4);
+      }
+    }
+
+  preview_surface_flatten (surface);
+}
+
+static void
+scroll_to (PreviewInspector *inspector,
+           gint              x,
+           gint              y)
+{
+  x = CLAMP (x, 0, inspector->width - inspector->surface->width);
+  y = CLAMP (y, 0, inspector->height - inspector->surface->height);
+
+  if (x == inspector->x && y == inspector->y)
+    return;
+
+  inspector->x = x;
+  inspector->y = y;
+  preview_inspector_update (inspector);
+}
+
+static gboolean
+button_press (GtkWidget        *widget,
+              GdkEventButton   *event,
+              PreviewInspector *inspector)
+{
+  if (event->button != 1)
+    return FALSE;
+
+  inspector->dragging = TRUE;
+  inspector->drag_x = event->x;
+  inspector->drag_y = event->y;
+  inspector->drag_view_x = inspector->x;
+  inspector->drag_view_y = inspector->y;
+
+  return TRUE;
+}
+
+static gboolean
+button_release (GtkWidget        *widget,
+                GdkEventButton   *event,
+                PreviewInspector *inspector)
+{
+  inspector->dragging = FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+motion_notify (GtkWidget        *widget,
+               GdkEventMotion   *event,
+               PreviewInspector *inspector)
+{
+  if (!inspector->dragging)
+    return FALSE;
+
+  scroll_to (inspector,
+             inspector->drag_view_x - ROUND (event->x - inspector->drag_x),
+             inspector->drag_view_y - ROUND (event->y - inspector->drag_y));
+
+  /* we use motion hints, ask for the next event once this one is drawn */
+  gdk_event_request_motions (event);
+
+  return TRUE;
+}
+
+PreviewInspector *
+preview_inspector_new (gint32                     drawable_ID,
+                       gint                       view_size,
+                       PreviewInspectorRenderFunc render,
+                       gpointer                   data)
+{
+  PreviewInspector *inspector = g_new0 (PreviewInspector, 1);
+
+  inspector->drawable_ID = drawable_ID;
+  inspector->width = gimp_drawable_width (drawable_ID);
+  inspector->height = gimp_drawable_height (drawable_ID);
+  gimp_drawable_offsets (drawable_ID, &inspector->offset_x, &inspector->offset_y);
+
+  inspector->render = render;
+  inspector->render_data = data;
+  inspector->tiles = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+
+  /* 1:1, so the view is never larger than the drawable */
+  gint view_width = MIN (view_size, inspector->width);
+  gint view_height = MIN (view_size, inspector->height);
+  inspector->surface = preview_surface_new (view_width, view_height,
+                                            MAX (view_width, view_height));
+
+  /* start in the middle */
+  inspector->x = (inspector->width - inspector->surface->width) / 2;
+  inspector->y = (inspector->height - inspector->surface->height) / 2;
+
+  inspector->widget = gtk_event_box_new ();
+  gtk_container_add (GTK_CONTAINER (inspector->widget), inspector->surface->widget);
+  gtk_widget_show (inspector->surface->widget);
+
+  gtk_widget_add_events (inspector->widget,
+                         GDK_BUTTON_PRESS_MASK | GDK_BUTTON_RELEASE_MASK |
+                         GDK_BUTTON1_MOTION_MASK | GDK_POINTER_MOTION_HINT_MASK);
+  g_signal_connect (inspector->widget, "button-press-event", G_CALLBACK (button_press), inspector);
+  g_signal_connect (inspector->widget, "button-release-event", G_CALLBACK (button_release), inspector);
+  g_signal_connect (inspector->widget, "motion-notify-event", G_CALLBACK (motion_notify), inspector);
+
+  return inspector;
+}
+
+void
+preview_inspector_free (PreviewInspector *inspector)
+{
+  g_hash_table_destroy (inspector->tiles);
+  preview_surface_free (inspector->surface);
+  g_free (inspector);
+}
+
+void
+preview_inspector_invalidate (PreviewInspector *inspector,
+                              gint              halo)
+{
+  inspector->halo = halo;
+  g_hash_table_remove_all (inspector->tiles);
+
+  if (gtk_widget_get_visible (inspector->widget))
+    preview_inspector_update (inspector);
+}
@@ -0,0 +1,68 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A preview inspector shows the drawable at 1:1 in a view the user can
+ * drag around. Only the tiles under the view are rendered, each batch of
+ * missing tiles is copied with a halo into a small image and handed to
+ * the render function, which runs the plug-in pipeline on it. Rendered
+ * tiles are cached until the inspector is invalidated.
+ */
+
+/* offset_x and offset_y are the position of image_ID in the real image */
+typedef void (*PreviewInspectorRenderFunc) (gint32   image_ID,
+                                            gint     offset_x,
+                                            gint     offset_y,
+                                            gpointer data);
+
+typedef struct
+{
+  GtkWidget      *widget;
+  PreviewSurface *surface;
+
+  gint32          drawable_ID;
+  gint            width;
+  gint            height;
+  gint            offset_x;
+  gint            offset_y;
+
+  /* view origin, in drawable coordinates */
+  gint            x;
+  gint            y;
+
+  gint            halo;
+  GHashTable     *tiles;
+
+  PreviewInspectorRenderFunc render;
+  gpointer                   render_data;
+
+  gboolean        dragging;
+  gdouble         drag_x;
+  gdouble         drag_y;
+  gint            drag_view_x;
+  gint            drag_view_y;
+} PreviewInspector;
+
+PreviewInspector *preview_inspector_new        (gint32                     drawable_ID,
+                                                gint                       view_size,
+                                                PreviewInspectorRenderFunc render,
+                                                gpointer                   data);
+void              preview_inspector_free       (PreviewInspector *inspector);
+
+/* the pipeline changed, drop all tiles, halo is the context it needs */
+void              preview_inspector_invalidate (PreviewInspector *inspector,
+                                                gint              halo);
+void              preview_inspector_update     (PreviewInspector *inspector);
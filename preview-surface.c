@@ -0,0 +1,546 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libgimp/gimp.h>
+#include <libgimp/gimpui.h>
+
+#include "preview-surface.h"
+
+#define CHECK_SIZE 4
+
+PreviewSurface *
+preview_surface_new (gint image_width,
+                     gint image_height,
+                     gint max_size)
+{
+  PreviewSurface *surface = g_new0 (PreviewSurface, 1);
+
+  /* same size as gimp_image_get_thumbnail (max_size, max_size) gives,
+   * but never scale up a small image
+   */
+  if (max_size > MAX (image_width, image_height))
+    max_size = MAX (image_width, image_height);
+
+  if (image_width > image_height)
+  {
+    surface->width = max_size;
+    surface->height = MAX (1, max_size * image_height / image_width);
+  }
+  else
+  {
+    surface->width = MAX (1, max_size * image_width / image_height);
+    surface->height = max_size;
+  }
+
+  surface->pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8,
+                                    surface->width, surface->height);
+  gdk_pixbuf_fill (surface->pixbuf, 0x000000ff);
+
+  surface->widget = gtk_image_new_from_pixbuf (surface->pixbuf);
+
+  return surface;
+}
+
+void
+preview_surface_free (PreviewSurface *surface)
+{
+  g_object_unref (surface->pixbuf);
+  g_free (surface);
+}
+
+guchar *
+preview_surface_get_pixels (PreviewSurface *surface,
+                            gint           *rowstride)
+{
+  if (rowstride)
+    *rowstride = gdk_pixbuf_get_rowstride (surface->pixbuf);
+
+  return gdk_pixbuf_get_pixels (surface->pixbuf);
+}
+
+void
+preview_surface_flush (PreviewSurface *surface)
+{
+  /* the GtkImage draws straight from our pixbuf, a redraw is enough */
+  gtk_widget_queue_draw (surface->widget);
+}
+
+/* the modes which mix the layer with what is below it, the others
+ * are composited with "normal"
+ */
+static gboolean
+mode_blends (GimpLayerModeEffects mode)
+{
+  switch (mode)
+  {
+    case GIMP_MULTIPLY_MODE:
+    case GIMP_SCREEN_MODE:
+    case GIMP_OVERLAY_MODE:
+    case GIMP_DIFFERENCE_MODE:
+    case GIMP_ADDITION_MODE:
+    case GIMP_SUBTRACT_MODE:
+    case GIMP_DARKEN_ONLY_MODE:
+    case GIMP_LIGHTEN_ONLY_MODE:
+    case GIMP_HUE_MODE:
+    case GIMP_SATURATION_MODE:
+    case GIMP_COLOR_MODE:
+    case GIMP_VALUE_MODE:
+    case GIMP_DIVIDE_MODE:
+    case GIMP_DODGE_MODE:
+    case GIMP_BURN_MODE:
+    case GIMP_HARDLIGHT_MODE:
+    case GIMP_SOFTLIGHT_MODE:
+    case GIMP_GRAIN_EXTRACT_MODE:
+    case GIMP_GRAIN_MERGE_MODE:
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+/* one channel of the layer s over d, as the paint functions of GIMP 2 do */
+static gint
+blend_channel (GimpLayerModeEffects mode,
+               gint                 s,
+               gint                 d)
+{
+  switch (mode)
+  {
+    case GIMP_MULTIPLY_MODE:
+      return d * s / 255;
+    case GIMP_SCREEN_MODE:
+      return 255 - (255 - d) * (255 - s) / 255;
+    case GIMP_OVERLAY_MODE:
+    case GIMP_SOFTLIGHT_MODE:
+      return ((255 - d) * (d * s / 255) + d * (255 - (255 - d) * (255 - s) / 255)) / 255;
+    case GIMP_DIFFERENCE_MODE:
+      return ABS (d - s);
+    case GIMP_ADDITION_MODE:
+      return MIN (d + s, 255);
+    case GIMP_SUBTRACT_MODE:
+      return MAX (d - s, 0);
+    case GIMP_DARKEN_ONLY_MODE:
+      return MIN (d, s);
+    case GIMP_LIGHTEN_ONLY_MODE:
+      return MAX (d, s);
+    case GIMP_DIVIDE_MODE:
+      return MIN (d * 256 / (s + 1), 255);
+    case GIMP_DODGE_MODE:
+      return MIN (d * 256 / (256 - s), 255);
+    case GIMP_BURN_MODE:
+      return 255 - MIN ((255 - d) * 256 / (s + 1), 255);
+    case GIMP_HARDLIGHT_MODE:
+      if (s > 128)
+        return 255 - (((255 - d) * (255 - ((s - 128) << 1))) >> 8);
+      return (d * (s << 1)) >> 8;
+    case GIMP_GRAIN_EXTRACT_MODE:
+      return CLAMP (d - s + 128, 0, 255);
+    case GIMP_GRAIN_MERGE_MODE:
+      return CLAMP (d + s - 128, 0, 255);
+    default:
+      return s;
+  }
+}
+
+/* the color of the layer s over d in b, with the mode of the layer */
+static void
+blend_pixel (GimpLayerModeEffects  mode,
+             const gint           *s,
+             const guchar         *d,
+             gint                 *b)
+{
+  gint t[3];
+  gint c;
+
+  switch (mode)
+  {
+    case GIMP_HUE_MODE:
+    case GIMP_SATURATION_MODE:
+    case GIMP_VALUE_MODE:
+      /* the hue, saturation or value of the layer, the rest of below */
+      t[0] = s[0];
+      t[1] = s[1];
+      t[2] = s[2];
+      b[0] = d[0];
+      b[1] = d[1];
+      b[2] = d[2];
+      gimp_rgb_to_hsv_int (&t[0], &t[1], &t[2]);
+      gimp_rgb_to_hsv_int (&b[0], &b[1], &b[2]);
+      if (mode == GIMP_HUE_MODE && t[1] != 0)
+        b[0] = t[0];
+      else if (mode == GIMP_SATURATION_MODE)
+        b[1] = t[1];
+      else if (mode == GIMP_VALUE_MODE)
+        b[2] = t[2];
+      gimp_hsv_to_rgb_int (&b[0], &b[1], &b[2]);
+      break;
+
+    case GIMP_COLOR_MODE:
+      /* hue and saturation of the layer, lightness of below */
+      t[0] = s[0];
+      t[1] = s[1];
+      t[2] = s[2];
+      b[0] = d[0];
+      b[1] = d[1];
+      b[2] = d[2];
+      gimp_rgb_to_hsl_int (&t[0], &t[1], &t[2]);
+      gimp_rgb_to_hsl_int (&b[0], &b[1], &b[2]);
+      b[0] = t[0];
+      b[1] = t[1];
+      gimp_hsl_to_rgb_int (&b[0], &b[1], &b[2]);
+      break;
+
+    default:
+      for (c = 0; c < 3; c++)
+        b[c] = blend_channel (mode, s[c], d[c]);
+      break;
+  }
+}
+
+/* where a layer falls on the surface */
+typedef struct
+{
+  gint *columns;     /* the layer column of each surface column, or -1 */
+  gint *rows;        /* the layer row of each surface row, or -1 */
+  gint  x1, y1;      /* the surface pixels covered by the layer */
+  gint  x2, y2;
+  gint  src_x, src_y;
+  gint  src_width, src_height;
+} LayerPlace;
+
+/* FALSE if the layer covers no surface pixel */
+static gboolean
+layer_place_init (LayerPlace     *place,
+                  PreviewSurface *surface,
+                  gint32          layer_ID,
+                  gint            image_width,
+                  gint            image_height)
+{
+  gint layer_width = gimp_drawable_width (layer_ID);
+  gint layer_height = gimp_drawable_height (layer_ID);
+  gint offset_x, offset_y;
+  gint x, y;
+
+  gimp_drawable_offsets (layer_ID, &offset_x, &offset_y);
+
+  place->columns = g_new (gint, surface->width);
+  place->x1 = surface->width;
+  place->x2 = 0;
+  for (x = 0; x < surface->width; x++)
+  {
+    gint lx = (2 * x + 1) * image_width / (2 * surface->width) - offset_x;
+
+    place->columns[x] = (lx >= 0 && lx < layer_width) ? lx : -1;
+    if (place->columns[x] >= 0)
+    {
+      place->x1 = MIN (place->x1, x);
+      place->x2 = x + 1;
+    }
+  }
+
+  place->rows = g_new (gint, surface->height);
+  place->y1 = surface->height;
+  place->y2 = 0;
+  for (y = 0; y < surface->height; y++)
+  {
+    gint ly = (2 * y + 1) * image_height / (2 * surface->height) - offset_y;
+
+    place->rows[y] = (ly >= 0 && ly < layer_height) ? ly : -1;
+    if (place->rows[y] >= 0)
+    {
+      place->y1 = MIN (place->y1, y);
+      place->y2 = y + 1;
+    }
+  }
+
+  if (place->x1 >= place->x2 || place->y1 >= place->y2)
+  {
+    g_free (place->columns);
+    g_free (place->rows);
+    return FALSE;
+  }
+
+  place->src_x = place->columns[place->x1];
+  place->src_y = place->rows[place->y1];
+  place->src_width = place->columns[place->x2 - 1] - place->src_x + 1;
+  place->src_height = place->rows[place->y2 - 1] - place->src_y + 1;
+
+  return TRUE;
+}
+
+static void
+layer_place_free (LayerPlace *place)
+{
+  g_free (place->columns);
+  g_free (place->rows);
+}
+
+/* the covered part of the layer, or of its mask, scaled down by GIMP to
+ * the covered surface pixels, so only those come over the wire. The
+ * size may come back different, the pixels are looked up by scaling.
+ */
+static guchar *
+layer_place_sample (const LayerPlace *place,
+                    gint32            drawable_ID,
+                    gint             *width,
+                    gint             *height,
+                    gint             *bpp)
+{
+  *width = place->x2 - place->x1;
+  *height = place->y2 - place->y1;
+
+  return gimp_drawable_get_sub_thumbnail_data (drawable_ID, place->src_x, place->src_y,
+                                               place->src_width, place->src_height,
+                                               width, height, bpp);
+}
+
+/* composite one layer over the surface with its mode, opacity and mask.
+ * The colors and alpha of the layer come from pixels, an RGBA buffer
+ * at the surface size, if it is not NULL.
+ */
+static void
+composite_layer (PreviewSurface *surface,
+                 gint32          layer_ID,
+                 gint            image_width,
+                 gint            image_height,
+                 const guchar   *layer_pixels)
+{
+  GimpLayerModeEffects mode;
+  LayerPlace           place;
+  gint                 opacity;
+  gint                 sample_width, sample_height, bpp = 4;
+  gint                 mask_width, mask_height, mask_bpp;
+  guchar              *sample = NULL;
+  guchar              *mask = NULL;
+  guchar              *pixels;
+  gint                 rowstride;
+  gint                 x, y;
+
+  mode = gimp_layer_get_mode (layer_ID);
+  opacity = ROUND (gimp_layer_get_opacity (layer_ID) * 255 / 100);
+
+  if (opacity == 0 ||
+      !layer_place_init (&place, surface, layer_ID, image_width, image_height))
+    return;
+
+  if (!layer_pixels)
+  {
+    sample = layer_place_sample (&place, layer_ID, &sample_width, &sample_height, &bpp);
+    if (!sample)
+    {
+      layer_place_free (&place);
+      return;
+    }
+  }
+
+  gint32 mask_ID = gimp_layer_get_mask (layer_ID);
+  if (mask_ID != -1 && gimp_layer_get_apply_mask (layer_ID))
+    mask = layer_place_sample (&place, mask_ID, &mask_width, &mask_height, &mask_bpp);
+
+  pixels = preview_surface_get_pixels (surface, &rowstride);
+
+  for (y = place.y1; y < place.y2; y++)
+  {
+    gint          h = place.y2 - place.y1;
+    const guchar *s_row = sample ? sample + (gsize) ((y - place.y1) * sample_height / h) * sample_width * bpp : NULL;
+    const guchar *m_row = mask ? mask + (gsize) ((y - place.y1) * mask_height / h) * mask_width * mask_bpp : NULL;
+    guchar       *d = pixels + y * rowstride + place.x1 * 4;
+
+    if (place.rows[y] < 0)
+      continue;
+
+    for (x = place.x1; x < place.x2; x++, d += 4)
+    {
+      gint          w = place.x2 - place.x1;
+      const guchar *s;
+      gint          color[3], blended[3];
+      gint          a, c;
+
+      if (place.columns[x] < 0)
+        continue;
+
+      if (layer_pixels)
+        s = layer_pixels + ((gsize) y * surface->width + x) * 4;
+      else
+        s = s_row + (x - place.x1) * sample_width / w * bpp;
+
+      if (bpp >= 3)
+      {
+        color[0] = s[0];
+        color[1] = s[1];
+        color[2] = s[2];
+      }
+      else
+      {
+        color[0] = color[1] = color[2] = s[0];
+      }
+
+      a = (bpp == 2 || bpp == 4) ? s[bpp - 1] : 255;
+      a = a * opacity / 255;
+      if (m_row)
+        a = a * m_row[(x - place.x1) * mask_width / w * mask_bpp] / 255;
+
+      if (a == 0)
+        continue;
+
+      if (mode_blends (mode))
+      {
+        /* these modes only change what is below, as in GIMP 2 */
+        a = MIN (a, d[3]);
+        blend_pixel (mode, color, d, blended);
+
+        for (c = 0; c < 3; c++)
+          d[c] += (blended[c] - d[c]) * a / 255;
+      }
+      else
+      {
+        gint da = d[3] * (255 - a) / 255;
+        gint oa = a + da;
+
+        for (c = 0; c < 3; c++)
+          d[c] = (color[c] * a + d[c] * da) / oa;
+        d[3] = oa;
+      }
+    }
+  }
+
+  layer_place_free (&place);
+  g_free (sample);
+  g_free (mask);
+}
+
+/* flatten the surface over small checks, like GIMP_PIXBUF_SMALL_CHECKS */
+static void
+composite_checks (PreviewSurface *surface)
+{
+  guchar  light, dark;
+  guchar *pixels;
+  gint    rowstride;
+  gint    x, y;
+
+  gimp_checks_get_shades (GIMP_CHECK_TYPE_GRAY_CHECKS, &light, &dark);
+
+  pixels = preview_surface_get_pixels (surface, &rowstride);
+
+  for (y = 0; y < surface->height; y++)
+  {
+    guchar *d = pixels + y * rowstride;
+
+    for (x = 0; x < surface->width; x++, d += 4)
+    {
+      gint check = ((x / CHECK_SIZE) + (y / CHECK_SIZE)) & 1 ? light : dark;
+      gint a = d[3];
+
+      d[0] = (d[0] * a + check * (255 - a)) / 255;
+      d[1] = (d[1] * a + check * (255 - a)) / 255;
+      d[2] = (d[2] * a + check * (255 - a)) / 255;
+      d[3] = 255;
+    }
+  }
+}
+
+void
+preview_surface_composite_image (PreviewSurface *surface,
+                                 gint32          image_ID)
+{
+  preview_surface_composite_image_with (surface, image_ID, -1, NULL);
+}
+
+void
+preview_surface_composite_image_with (PreviewSurface *surface,
+                                      gint32          image_ID,
+                                      gint32          layer_ID,
+                                      const guchar   *layer_pixels)
+{
+  gint   image_width = gimp_image_width (image_ID);
+  gint   image_height = gimp_image_height (image_ID);
+  gint   num_layers;
+  gint  *layers;
+  gint   i;
+
+  gdk_pixbuf_fill (surface->pixbuf, 0x00000000);
+
+  /* layers are returned from top to bottom */
+  layers = gimp_image_get_layers (image_ID, &num_layers);
+  for (i = num_layers - 1; i >= 0; i--)
+  {
+    if (gimp_drawable_get_visible (layers[i]))
+      composite_layer (surface, layers[i], image_width, image_height,
+                       layers[i] == layer_ID ? layer_pixels : NULL);
+  }
+  g_free (layers);
+}
+
+guchar *
+preview_surface_read_layer (PreviewSurface *surface,
+                            gint32          image_ID,
+                            gint32          layer_ID)
+{
+  LayerPlace  place;
+  guchar     *pixels = g_new0 (guchar, (gsize) surface->width * surface->height * 4);
+  guchar     *sample;
+  gint        sample_width, sample_height, bpp;
+  gint        x, y;
+
+  if (!layer_place_init (&place, surface, layer_ID,
+                         gimp_image_width (image_ID), gimp_image_height (image_ID)))
+    return pixels;
+
+  sample = layer_place_sample (&place, layer_ID, &sample_width, &sample_height, &bpp);
+
+  for (y = place.y1; sample && y < place.y2; y++)
+  {
+    const guchar *s_row = sample + (gsize) ((y - place.y1) * sample_height / (place.y2 - place.y1)) * sample_width * bpp;
+    guchar       *d = pixels + ((gsize) y * surface->width + place.x1) * 4;
+
+    if (place.rows[y] < 0)
+      continue;
+
+    for (x = place.x1; x < place.x2; x++, d += 4)
+    {
+      const guchar *s = s_row + (x - place.x1) * sample_width / (place.x2 - place.x1) * bpp;
+
+      if (place.columns[x] < 0)
+        continue;
+
+      d[0] = s[0];
+      d[1] = (bpp >= 3) ? s[1] : s[0];
+      d[2] = (bpp >= 3) ? s[2] : s[0];
+      d[3] = (bpp == 2 || bpp == 4) ? s[bpp - 1] : 255;
+    }
+  }
+
+  layer_place_free (&place);
+  g_free (sample);
+
+  return pixels;
+}
+
+void
+preview_surface_draw_image (PreviewSurface *surface,
+                            gint32          image_ID)
+{
+  preview_surface_composite_image (surface, image_ID);
+  preview_surface_flatten (surface);
+}
+
+void
+preview_surface_flatten (PreviewSurface *surface)
+{
+  composite_checks (surface);
+  preview_surface_flush (surface);
+}
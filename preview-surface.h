@@ -0,0 +1,62 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A preview surface is a GtkImage showing a RGBA buffer that is owned by
+ * the plug-in and allocated once at display size. Updating the preview
+ * writes into that buffer and redraws the widget, instead of asking GIMP
+ * for a new thumbnail pixbuf each time.
+ */
+typedef struct
+{
+  GtkWidget *widget;
+  GdkPixbuf *pixbuf;
+  gint       width;
+  gint       height;
+} PreviewSurface;
+
+PreviewSurface *preview_surface_new        (gint image_width,
+                                            gint image_height,
+                                            gint max_size);
+void            preview_surface_free       (PreviewSurface *surface);
+
+guchar         *preview_surface_get_pixels (PreviewSurface *surface,
+                                            gint           *rowstride);
+void            preview_surface_flush      (PreviewSurface *surface);
+/* composite the RGBA buffer over checks and flush it */
+void            preview_surface_flatten    (PreviewSurface *surface);
+
+void            preview_surface_draw_image (PreviewSurface *surface,
+                                            gint32          image_ID);
+/* composite the visible layers into the RGBA buffer with their modes,
+ * opacities and masks, without flattening or flushing it. Each layer is
+ * scaled down by GIMP, only surface sized pixels are transferred.
+ */
+void            preview_surface_composite_image (PreviewSurface *surface,
+                                                 gint32          image_ID);
+/* the same with the colors and alpha of layer_ID, a layer which is not
+ * in a group, taken from layer_pixels, an RGBA buffer at the surface size
+ */
+void            preview_surface_composite_image_with (PreviewSurface *surface,
+                                                      gint32          image_ID,
+                                                      gint32          layer_ID,
+                                                      const guchar   *layer_pixels);
+/* the pixels of one layer alone, at its place on the surface, in a new
+ * RGBA buffer at the surface size which is transparent around it
+ */
+guchar         *preview_surface_read_layer (PreviewSurface *surface,
+                                            gint32          image_ID,
+                                            gint32          layer_ID);
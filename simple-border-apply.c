@@ -0,0 +1,262 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <libgimp/gimp.h>
+
+#include "simple-border-textures.h"
+#include "border-render.h"
+#include "pixel-kernel.h"
+#include "simple-border-apply.h"
+
+const Border simple_border_textures[] =
+{
+  {"15356",   0, 0, 0, 0, 10, texture_15356},
+  {"15327",   24,37,29,41,10, texture_15327},
+  {"201544",  12,12,12,12,10, texture_201544},
+  {"15352",   9, 35,7, 6, 10, texture_15352},
+  {"201365",  24,23,23,23,10, texture_201365},
+  {"15349",   56,63,54,56,10, texture_15349},
+  {"24252",   40,43,35,38,90, texture_24252},
+  {"114844",  14,13,14,14,10, texture_114844},
+  {"200832",  14,14,14,14,10, texture_200832},
+  {"200878",  12,12,12,12,10, texture_200878},
+  {"201017",  0, 0, 0, 0, 10, texture_201017},
+  {"114568",  0, 0, 0, 0, 10, texture_114568},
+  {"111026",  0, 0, 0, 0, 10, texture_111026},
+  {"200377",  20,166,20,20,10,texture_200377},
+  {"201385",  11,12,12,12,10, texture_201385},
+  {"111025",  25,56,16,16,10, texture_111025},
+  {"200547",  21,21,17,17,10, texture_200547},
+  {"200776",  16,16,16,16,10, texture_200776},
+  {"200646",  18,18, 8, 8,18, texture_200646},
+  {"200282",  0, 0, 0, 0, 16, texture_200282},
+  {"111020",  16,18,17,19,10, texture_111020},
+  {"113579",  28,28,25,25,42, texture_113579},
+  {"111569",  0, 0, 0, 0, 10, texture_111569},
+  {"200031",  0, 0, 0, 0, 10, texture_200031},
+  {"113576",  39,39,40,40,36, texture_113576},
+  {"114907",  0, 0, 0, 0, 16, texture_114907},
+  {"114577",  0, 0, 0, 0, 44, texture_114577},
+  {"113575",  38,38,38,38,34, texture_113575},
+  {"113573",  27,22,26,24,10, texture_113573},
+  {"114576",  0, 0, 0, 0, 10, texture_114576},
+  {"111013",  35,35,35,35,10, texture_111013},
+  {"114575",  0, 0, 0, 0, 10, texture_114575},
+  {"111017",  31,31,31,31,10, texture_111017},
+  {"114573",  10,10,10,10,10, texture_114573},
+  {"111027",  17,16,16,19,10, texture_111027},
+  {"111021",  18,18,21,22,22, texture_111021},
+  {"114572",  16,16,14,14,10, texture_114572},
+  {"114570",  20,22,21,19,21, texture_114570},
+  {"22753",   34,36,34,36,53, texture_22753},
+  {"20130",   59,59,0, 0, 10, texture_20130},
+  {"114569",  20,20,20,19,21, texture_114569},
+  {"20129",   83,82,0, 0, 10, texture_20129},
+  {"15354",   30,45,47,58,10, texture_15354},
+  {"15357",   45,45,0, 0, 32, texture_15357},
+  {"15353",   13,48,10,11,10, texture_15353},
+  {"15351",   15,73,16,17,10, texture_15351},
+  {"15328",   7, 7, 7, 7, 16, texture_15328},
+  {"15350",   0, 0, 0, 0, 10, texture_15350},
+  {"15329",   13,14,20,19,10, texture_15329},
+  {"15330",   26,23,25,27,10, texture_15330},
+  {"114567",  14,13,13,13,10, texture_114567},
+  {"15870",   39,50,41,192,63,texture_15870},
+  {"21926",   43,53,43,212,429,texture_21926},
+  {"21959",   42,50,44,216,74,texture_21959},
+  {"21927",   43,53,43,212,23,texture_21927},
+  {"15871",   39,50,41,210,16,texture_15871},
+};
+
+const gint simple_border_n_textures = G_N_ELEMENTS (simple_border_textures);
+
+const Border *
+simple_border_lookup (const gchar *id)
+{
+  gint i;
+
+  for (i = 0; i < simple_border_n_textures; i++)
+    if (strcmp (simple_border_textures[i].id, id) == 0)
+      return &simple_border_textures[i];
+
+  return NULL;
+}
+
+/* the texture of a border, pixbuf is kept while it is used */
+void
+border_texture_init (BorderTexture *texture,
+                     const Border  *border,
+                     GdkPixbuf     *pixbuf)
+{
+  texture->pixels = gdk_pixbuf_get_pixels (pixbuf);
+  texture->rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  texture->n_channels = gdk_pixbuf_get_n_channels (pixbuf);
+  texture->width = gdk_pixbuf_get_width (pixbuf);
+  texture->height = gdk_pixbuf_get_height (pixbuf);
+  texture->top = border->top;
+  texture->bottom = border->bottom;
+  texture->left = border->left;
+  texture->right = border->right;
+  texture->length = border->length;
+}
+
+typedef struct
+{
+  const BorderSlices *slices;
+  guchar             *buf;
+  gint                x;
+  gint                y;
+  gint                width;
+  gint                bpp;
+} Rows;
+
+static void
+render_rows (gint start, gint end, gint thread, gpointer data)
+{
+  Rows *rows = data;
+
+  border_render_rect (rows->slices,
+                      rows->buf + (gsize) start * rows->width * rows->bpp,
+                      rows->x, rows->y + start, rows->width, end - start, rows->bpp);
+}
+
+/* the rows of a rectangle spread over the threads */
+static void
+render_rect (const BorderSlices *slices,
+             guchar             *buf,
+             gint                x,
+             gint                y,
+             gint                width,
+             gint                height,
+             gint                bpp)
+{
+  Rows rows = { slices, buf, x, y, width, bpp };
+
+  pixel_kernel_parallel (height, render_rows, &rows);
+}
+
+void
+simple_border_apply (gint32               image_ID,
+                     const BorderTexture *texture)
+{
+  GimpDrawable *drawable;
+  GimpPixelRgn  src_rgn, dest_rgn;
+  BorderSlices  slices;
+  gint32        layer;
+  gint          offset_x, offset_y;
+  gboolean      in_place = FALSE;
+  gint          i;
+
+  layer = gimp_image_get_active_layer (image_ID);
+
+  gint width = gimp_image_width (image_ID);
+  gint height = gimp_image_height (image_ID);
+
+  if (texture->top || texture->bottom || texture->left || texture->right)
+  {
+    width += texture->left + texture->right;
+    height += texture->top + texture->bottom;
+    gimp_image_resize (image_ID,
+                       width,
+                       height,
+                       texture->left,
+                       texture->top);
+  }
+
+  /* the layer gets alpha and covers the image, as merging a border layer
+   * down made it. Either keeps the old pixels for undo, so the border can
+   * be written in place.
+   */
+  if (!gimp_drawable_has_alpha (layer))
+  {
+    gimp_layer_add_alpha (layer);
+    in_place = TRUE;
+  }
+
+  gimp_drawable_offsets (layer, &offset_x, &offset_y);
+  if (offset_x != 0 || offset_y != 0 ||
+      gimp_drawable_width (layer) != width || gimp_drawable_height (layer) != height)
+  {
+    gimp_layer_resize_to_image_size (layer);
+    in_place = TRUE;
+  }
+
+  border_slices_init (&slices, texture, width, height);
+
+  drawable = gimp_drawable_get (layer);
+  gimp_tile_cache_ntiles (2 * (width / gimp_tile_width () + 1));
+
+  /* only the strips under the border are read and written. When nothing
+   * kept the old pixels for undo, each strip goes through the shadow
+   * tiles on its own, selected so merging it covers only the strip
+   */
+  gint bands[4][4] =
+  {
+    { 0, 0, width, slices.top },
+    { 0, height - slices.bottom, width, slices.bottom },
+    { 0, slices.top, slices.left, height - slices.top - slices.bottom },
+    { width - slices.right, slices.top, slices.right, height - slices.top - slices.bottom },
+  };
+
+  if (in_place)
+    gimp_pixel_rgn_init (&dest_rgn, drawable, 0, 0, width, height, TRUE, FALSE);
+
+  for (i = 0; i < G_N_ELEMENTS (bands); i++)
+  {
+    gint    x = MAX (0, bands[i][0]), y = MAX (0, bands[i][1]);
+    gint    w = MIN (width, bands[i][0] + bands[i][2]) - x;
+    gint    h = MIN (height, bands[i][1] + bands[i][3]) - y;
+    guchar *buf;
+
+    if (w <= 0 || h <= 0)
+      continue;
+
+    buf = g_new (guchar, (gsize) w * h * drawable->bpp);
+
+    if (in_place)
+    {
+      gimp_pixel_rgn_get_rect (&dest_rgn, buf, x, y, w, h);
+      render_rect (&slices, buf, x, y, w, h, drawable->bpp);
+      gimp_pixel_rgn_set_rect (&dest_rgn, buf, x, y, w, h);
+    }
+    else
+    {
+      gimp_rect_select (image_ID, x, y, w, h, GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
+      gimp_pixel_rgn_init (&src_rgn, drawable, x, y, w, h, FALSE, FALSE);
+      gimp_pixel_rgn_init (&dest_rgn, drawable, x, y, w, h, TRUE, TRUE);
+
+      gimp_pixel_rgn_get_rect (&src_rgn, buf, x, y, w, h);
+      render_rect (&slices, buf, x, y, w, h, drawable->bpp);
+      gimp_pixel_rgn_set_rect (&dest_rgn, buf, x, y, w, h);
+
+      gimp_drawable_flush (drawable);
+      gimp_drawable_merge_shadow (layer, TRUE);
+    }
+
+    g_free (buf);
+  }
+
+  if (in_place)
+    gimp_drawable_flush (drawable);
+  else
+    gimp_selection_none (image_ID);
+
+  gimp_drawable_update (layer, 0, 0, width, height);
+  gimp_drawable_detach (drawable);
+}
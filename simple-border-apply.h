@@ -0,0 +1,49 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The built-in textures of simple-border, and putting one around an
+ * image, shared by the simple-border plug-in and beautify recipes.
+ * border-render.h goes first.
+ */
+
+typedef struct
+{
+  const gchar  *id;
+  gint32        top;
+  gint32        bottom;
+  gint32        left;
+  gint32        right;
+  gint32        length;
+  const guint8 *texture;
+} Border;
+
+extern const Border simple_border_textures[];
+extern const gint   simple_border_n_textures;
+
+/* the built-in texture with id, NULL if there is none */
+const Border *simple_border_lookup (const gchar   *id);
+
+/* the texture of a border, pixbuf is kept while it is used */
+void          border_texture_init  (BorderTexture *texture,
+                                    const Border  *border,
+                                    GdkPixbuf     *pixbuf);
+
+/* grow the canvas of the image by the border and composite it on the
+ * active layer, which gets alpha and the size of the image
+ */
+void          simple_border_apply  (gint32               image_ID,
+                                    const BorderTexture *texture);
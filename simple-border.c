@@ -15,20 +15,14 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+
 #include <libgimp/gimp.h>
 #include <libgimp/gimpui.h>
 
-/* fix gimp_context_set_pattern ("Clipboard") only works on English versions of Gimp */
-#include <glib/gi18n.h>
-#define GETTEXT_PACKAGE "gimp20"
-#define INIT_I18N()	G_STMT_START{                                \
-  bindtextdomain (GETTEXT_PACKAGE,                    \
-                  gimp_locale_directory ());                         \
-  bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8"); \
-  textdomain (GETTEXT_PACKAGE);		             \
-}G_STMT_END
-
-#include "simple-border-textures.h"
+#include "border-render.h"
+#include "preview-surface.h"
+#include "simple-border-apply.h"
 
 #define PLUG_IN_PROC   "plug-in-simple-border"
 #define PLUG_IN_BINARY "border"
@@ -39,17 +33,6 @@
 #define PREVIEW_SIZE  480
 #define THUMBNAIL_SIZE  80
 
-typedef struct
-{
-  const gchar  *id;
-  gint32        top;
-  gint32        bottom;
-  gint32        left;
-  gint32        right;
-  gint32        length;
-  const guint8 *texture;
-} Border;
-
 typedef struct
 {
   const Border* border;
@@ -105,67 +88,9 @@ static gint       width;
 static gint       height;
 
 static GtkWidget *preview          = NULL;
-static gint32     preview_image    = 0;
-
-static const Border textures[] =
-{
-  {"15356",   0, 0, 0, 0, 10, texture_15356},
-  {"15327",   24,37,29,41,10, texture_15327},
-  {"201544",  12,12,12,12,10, texture_201544},
-  {"15352",   9, 35,7, 6, 10, texture_15352},
-  {"201365",  24,23,23,23,10, texture_201365},
-  {"15349",   56,63,54,56,10, texture_15349},
-  {"24252",   40,43,35,38,90, texture_24252},
-  {"114844",  14,13,14,14,10, texture_114844},
-  {"200832",  14,14,14,14,10, texture_200832},
-  {"200878",  12,12,12,12,10, texture_200878},
-  {"201017",  0, 0, 0, 0, 10, texture_201017},
-  {"114568",  0, 0, 0, 0, 10, texture_114568},
-  {"111026",  0, 0, 0, 0, 10, texture_111026},
-  {"200377",  20,166,20,20,10,texture_200377},
-  {"201385",  11,12,12,12,10, texture_201385},
-  {"111025",  25,56,16,16,10, texture_111025},
-  {"200547",  21,21,17,17,10, texture_200547},
-  {"200776",  16,16,16,16,10, texture_200776},
-  {"200646",  18,18, 8, 8,18, texture_200646},
-  {"200282",  0, 0, 0, 0, 16, texture_200282},
-  {"111020",  16,18,17,19,10, texture_111020},
-  {"113579",  28,28,25,25,42, texture_113579},
-  {"111569",  0, 0, 0, 0, 10, texture_111569},
-  {"200031",  0, 0, 0, 0, 10, texture_200031},
-  {"113576",  39,39,40,40,36, texture_113576},
-  {"114907",  0, 0, 0, 0, 16, texture_114907},
-  {"114577",  0, 0, 0, 0, 44, texture_114577},
-  {"113575",  38,38,38,38,34, texture_113575},
-  {"113573",  27,22,26,24,10, texture_113573},
-  {"114576",  0, 0, 0, 0, 10, texture_114576},
-  {"111013",  35,35,35,35,10, texture_111013},
-  {"114575",  0, 0, 0, 0, 10, texture_114575},
-  {"111017",  31,31,31,31,10, texture_111017},
-  {"114573",  10,10,10,10,10, texture_114573},
-  {"111027",  17,16,16,19,10, texture_111027},
-  {"111021",  18,18,21,22,22, texture_111021},
-  {"114572",  16,16,14,14,10, texture_114572},
-  {"114570",  20,22,21,19,21, texture_114570},
-  {"22753",   34,36,34,36,53, texture_22753},
-  {"20130",   59,59,0, 0, 10, texture_20130},
-  {"114569",  20,20,20,19,21, texture_114569},
-  {"20129",   83,82,0, 0, 10, texture_20129},
-  {"15354",   30,45,47,58,10, texture_15354},
-  {"15357",   45,45,0, 0, 32, texture_15357},
-  {"15353",   13,48,10,11,10, texture_15353},
-  {"15351",   15,73,16,17,10, texture_15351},
-  {"15328",   7, 7, 7, 7, 16, texture_15328},
-  {"15350",   0, 0, 0, 0, 10, texture_15350},
-  {"15329",   13,14,20,19,10, texture_15329},
-  {"15330",   26,23,25,27,10, texture_15330},
-  {"114567",  14,13,13,13,10, texture_114567},
-  {"15870",   39,50,41,192,63,texture_15870},
-  {"21926",   43,53,43,212,429,texture_21926},
-  {"21959",   42,50,44,216,74,texture_21959},
-  {"21927",   43,53,43,212,23,texture_21927},
-  {"15871",   39,50,41,210,16,texture_15871},
-};
+static PreviewSurface *preview_surface = NULL;
+/* the image at preview size, as it is */
+static guchar    *proxy            = NULL;
 
 static GArray *textures_timestamps = NULL;
 
@@ -192,6 +117,7 @@ query (void)
     { GIMP_PDB_INT32,    "run-mode",   "The run mode { RUN-INTERACTIVE (0), RUN-NONINTERACTIVE (1) }" },
     { GIMP_PDB_IMAGE,    "image",      "Input image" },
     { GIMP_PDB_DRAWABLE, "drawable",   "Input drawable" },
+    { GIMP_PDB_STRING,   "border",     "The id of the border texture, for RUN-NONINTERACTIVE" },
   };
 
   gimp_install_procedure (PLUG_IN_PROC,
@@ -243,6 +169,12 @@ run (const gchar      *name,
         break;
 
       case GIMP_RUN_NONINTERACTIVE:
+        bvals.border = NULL;
+        if (nparams == 4 && param[3].data.d_string)
+          bvals.border = simple_border_lookup (param[3].data.d_string);
+
+        if (!bvals.border)
+          status = GIMP_PDB_CALLING_ERROR;
         break;
 
       case GIMP_RUN_WITH_LAST_VALS:
@@ -252,6 +184,8 @@ run (const gchar      *name,
         break;
     }
 
+  values[0].data.d_status = status;
+
   if ((status == GIMP_PDB_SUCCESS) &&
       (gimp_drawable_is_rgb(drawable->drawable_id) ||
        gimp_drawable_is_gray(drawable->drawable_id)))
@@ -277,226 +211,72 @@ run (const gchar      *name,
 static void
 border (gint32 image_ID)
 {
-  GdkPixbuf  *pixbuf = NULL;
-  int         texture_width;
-  int         texture_height;
-  gdouble     margin_top;
-  gdouble     margin_bottom;
-  gdouble     margin_left;
-  gdouble     margin_right;
-
-  pixbuf = gdk_pixbuf_new_from_inline (-1, bvals.border->texture, FALSE, NULL);
-
-  if (pixbuf)
-  {
-    texture_width = gdk_pixbuf_get_width (pixbuf);
-    texture_height = gdk_pixbuf_get_height (pixbuf);
-
-    gint32 texture_image = gimp_image_new (texture_width, texture_height, GIMP_RGB);
-    gint32 texture_layer = gimp_layer_new_from_pixbuf (texture_image, "texture", pixbuf, 100, GIMP_NORMAL_MODE, 0, 0);
-    gimp_image_add_layer (texture_image, texture_layer, -1);
-
-    gint width = gimp_image_width (image_ID);
-    gint height = gimp_image_height (image_ID);
-
-    if (bvals.border->top || bvals.border->bottom || bvals.border->left || bvals.border->right)
-    {
-      width += bvals.border->left + bvals.border->right;
-      height += bvals.border->top + bvals.border->bottom;
-      gimp_image_resize (image_ID,
-                         width,
-                         height,
-                         bvals.border->left,
-                         bvals.border->top);
-    }
-
-    gint32 layer = gimp_layer_new (image_ID, "border",
-                                   width, height,
-                                   GIMP_RGBA_IMAGE,
-                                   100,
-                                   GIMP_NORMAL_MODE);
-    gimp_image_add_layer (image_ID, layer, -1);
-
-    if (width > texture_width - bvals.border->length)
-    {
-      margin_left = ((gdouble) texture_width - bvals.border->left - bvals.border->right - bvals.border->length) / 2;
-      margin_right = margin_left;
-    }
-    else
-    {
-      margin_left = ((gdouble) width - bvals.border->left - bvals.border->right) / 2;
-      margin_right = margin_left;
-    }
-    margin_left += bvals.border->left;
-    margin_right += bvals.border->right;
+  GdkPixbuf    *pixbuf;
+  BorderTexture texture;
 
-    if (height > texture_height - bvals.border->length)
-    {
-      margin_top = ((gdouble) texture_height - bvals.border->top - bvals.border->bottom - bvals.border->length) / 2;
-      margin_bottom = margin_top;
-    }
-    else
-    {
-      margin_top = ((gdouble) height - bvals.border->top - bvals.border->bottom) / 2;
-      margin_bottom = margin_top;
-    }
-    margin_top += bvals.border->top;
-    margin_bottom += bvals.border->bottom;
-
-    /* fix gimp_context_set_pattern ("Clipboard") only works on English versions of Gimp */
-    //gimp_context_set_pattern ("Clipboard");
-    INIT_I18N ();
-    gimp_context_set_pattern (_("Clipboard"));
-
-    if (width > margin_left + margin_right) {
-      /* top */
-      gimp_rect_select (texture_image,
-                        margin_left,
-                        0,
-                        (gdouble) texture_width - margin_left - margin_right,
-                        margin_top,
-                        GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
-      gimp_edit_copy (texture_layer);
-      gimp_rect_select (image_ID,
-                        margin_left,
-                        0,
-                        (gdouble) width - margin_left - margin_right,
-                        margin_top,
-                        GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
-      gimp_edit_fill (layer, GIMP_PATTERN_FILL);
-
-      /* bottom */
-      gimp_rect_select (texture_image,
-                        margin_left,
-                        (gdouble) texture_height - margin_bottom,
-                        (gdouble) texture_width - margin_left - margin_right,
-                        margin_bottom,
-                        GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
-      gimp_edit_copy (texture_layer);
-      gimp_rect_select (image_ID,
-                        margin_left,
-                        (gdouble) height - margin_bottom,
-                        (gdouble) width - margin_left - margin_right,
-                        margin_bottom,
-                        GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
-      gimp_edit_fill (layer, GIMP_PATTERN_FILL);
-    }
+  if (!bvals.border)
+    return;
 
-    if (height > margin_top + margin_bottom) {
-      /* left */
-      gimp_rect_select (texture_image,
-                        0,
-                        margin_top,
-                        margin_left,
-                        (gdouble) texture_height - margin_top - margin_bottom,
-                        GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
-      gimp_edit_copy (texture_layer);
-      gimp_rect_select (image_ID,
-                        0,
-                        margin_top,
-                        margin_left,
-                        (gdouble) height - margin_top - margin_bottom,
-                        GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
-      gimp_edit_fill (layer, GIMP_PATTERN_FILL);
-
-      /* right */
-      gimp_rect_select (texture_image,
-                        (gdouble) texture_width - margin_right,
-                        margin_top,
-                        margin_right,
-                        (gdouble) texture_height - margin_top - margin_bottom,
-                        GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
-      gimp_edit_copy (texture_layer);
-      gimp_rect_select (image_ID,
-                        (gdouble) width - margin_right,
-                        margin_top,
-                        margin_right,
-                        (gdouble) height - margin_top - margin_bottom,
-                        GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
-      gimp_edit_fill (layer, GIMP_PATTERN_FILL);
-    }
+  pixbuf = gdk_pixbuf_new_from_inline (-1, bvals.border->texture, FALSE, NULL);
+  if (!pixbuf)
+    return;
 
-    /* top left */
-    gimp_rect_select (texture_image,
-                      0,
-                      0,
-                      margin_left,
-                      margin_top,
-                      GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
-    gimp_edit_copy (texture_layer);
-    gimp_rect_select (image_ID,
-                      0,
-                      0,
-                      margin_left,
-                      margin_top,
-                      GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
-    gimp_edit_fill (layer, GIMP_PATTERN_FILL);
-
-    /* top right */
-    gimp_rect_select (texture_image,
-                      (gdouble) texture_width - margin_right,
-                      0,
-                      margin_right,
-                      margin_top,
-                      GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
-    gimp_edit_copy (texture_layer);
-    gimp_rect_select (image_ID,
-                      (gdouble) width - margin_right,
-                      0,
-                      margin_right,
-                      margin_top,
-                      GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
-    gimp_edit_fill (layer, GIMP_PATTERN_FILL);
-
-    /* bottom left */
-    gimp_rect_select (texture_image,
-                      0,
-                      (gdouble) texture_height - margin_bottom,
-                      margin_left,
-                      margin_bottom,
-                      GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
-    gimp_edit_copy (texture_layer);
-    gimp_rect_select (image_ID,
-                      0,
-                      (gdouble) height - margin_bottom,
-                      margin_left,
-                      margin_bottom,
-                      GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
-    gimp_edit_fill (layer, GIMP_PATTERN_FILL);
-
-    /* bottom right */
-    gimp_rect_select (texture_image,
-                      (gdouble) texture_width - margin_right,
-                      (gdouble) texture_height - margin_bottom,
-                      margin_right,
-                      margin_bottom,
-                      GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
-    gimp_edit_copy (texture_layer);
-    gimp_rect_select (image_ID,
-                      (gdouble) width - margin_right,
-                      (gdouble) height - margin_bottom,
-                      margin_right,
-                      margin_bottom,
-                      GIMP_CHANNEL_OP_REPLACE, FALSE, 0);
-    gimp_edit_fill (layer, GIMP_PATTERN_FILL);
-
-    gimp_image_merge_down(image_ID, layer, GIMP_CLIP_TO_IMAGE);
-
-    gimp_selection_none (image_ID);
-  }
+  border_texture_init (&texture, bvals.border, pixbuf);
+  simple_border_apply (image_ID, &texture);
+  g_object_unref (pixbuf);
 }
 
+/* the border rendered around the proxy, without touching the image */
 static void
 preview_update (GtkWidget *preview)
 {
-  gint preview_size = PREVIEW_SIZE;
-  gint max_size = height;
-  if (height < width)
-    max_size = width;
-  if (preview_size > max_size)
-    preview_size = max_size;
-  GdkPixbuf *pixbuf = gimp_image_get_thumbnail (preview_image, preview_size, preview_size, GIMP_PIXBUF_SMALL_CHECKS);
-  gtk_image_set_from_pixbuf (GTK_IMAGE(preview), pixbuf);
+  GdkPixbuf *pixbuf = NULL;
+  guchar    *pixels = preview_surface_get_pixels (preview_surface, NULL);
+  gint       w = preview_surface->width;
+  gint       h = preview_surface->height;
+
+  if (bvals.border)
+    pixbuf = gdk_pixbuf_new_from_inline (-1, bvals.border->texture, FALSE, NULL);
+
+  /* the rows of an RGBA pixbuf are not padded */
+  if (pixbuf)
+  {
+    BorderTexture texture;
+    gint          canvas_w, canvas_h;
+    gdouble       scale;
+    guchar       *canvas;
+    gint          x, y, row;
+
+    border_texture_init (&texture, bvals.border, pixbuf);
+
+    /* the surface has the shape of the image, the bordered canvas is
+     * fitted into it and the rest left transparent
+     */
+    canvas_w = width + texture.left + texture.right;
+    canvas_h = height + texture.top + texture.bottom;
+    scale = MIN ((gdouble) w / canvas_w, (gdouble) h / canvas_h);
+    canvas_w = CLAMP (RINT (canvas_w * scale), 1, w);
+    canvas_h = CLAMP (RINT (canvas_h * scale), 1, h);
+    x = (w - canvas_w) / 2;
+    y = (h - canvas_h) / 2;
+
+    canvas = g_new (guchar, (gsize) canvas_w * canvas_h * 4);
+    border_render (&texture, width, height, proxy, w, h, canvas, canvas_w, canvas_h);
+
+    memset (pixels, 0, (gsize) w * h * 4);
+    for (row = 0; row < canvas_h; row++)
+      memcpy (pixels + ((gsize) (y + row) * w + x) * 4,
+              canvas + (gsize) row * canvas_w * 4, (gsize) canvas_w * 4);
+
+    g_free (canvas);
+    g_object_unref (pixbuf);
+  }
+  else
+  {
+    memcpy (pixels, proxy, (gsize) w * h * 4);
+  }
+
+  preview_surface_flatten (preview_surface);
 }
 
 static gboolean
@@ -548,9 +328,12 @@ border_dialog (gint32        image_ID,
   gtk_box_pack_start (GTK_BOX (middle_vbox), label, FALSE, FALSE, 0);
   gtk_widget_show (label);
 
-  preview_image = gimp_image_duplicate(image_ID);
+  preview_surface = preview_surface_new (width, height, PREVIEW_SIZE);
+  preview = preview_surface->widget;
 
-  preview = gtk_image_new();
+  preview_surface_composite_image (preview_surface, image_ID);
+  proxy = g_memdup (preview_surface_get_pixels (preview_surface, NULL),
+                    preview_surface->width * preview_surface->height * 4);
   preview_update (preview);
 
   gtk_box_pack_start (GTK_BOX (middle_vbox), preview, TRUE, TRUE, 0);
@@ -566,11 +349,14 @@ border_dialog (gint32        image_ID,
   gtk_notebook_set_scrollable (GTK_NOTEBOOK (notebook), TRUE);
   gtk_widget_show (notebook);
 
-  create_texture_page (GTK_NOTEBOOK (notebook), "Top", textures, G_N_ELEMENTS (textures));
+  create_texture_page (GTK_NOTEBOOK (notebook), "Top", simple_border_textures, simple_border_n_textures);
 
   run = (gimp_dialog_run (GIMP_DIALOG (dialog)) == GTK_RESPONSE_OK);
 
   gtk_widget_destroy (dialog);
+  preview_surface_free (preview_surface);
+  g_free (proxy);
+  proxy = NULL;
 
   return run;
 }
@@ -776,11 +562,6 @@ custom_texture_press (GtkWidget *event_box, GdkEventButton *event, const gchar *
 static void
 do_texture_press ()
 {
-  gimp_image_delete (preview_image);
-  preview_image = gimp_image_duplicate(image_ID);
-
-  border (preview_image);
-
   preview_update (preview);
 }
 
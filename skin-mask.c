@@ -0,0 +1,523 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <libgimp/gimp.h>
+
+#include "color-lut.h"
+#include "face-detect.h"
+#include "guided-filter.h"
+#include "pixel-kernel.h"
+#include "skin-mask.h"
+
+#define TILE_SIZE 256
+
+/* a cell of the color grid is 8 x 8 x 8 colors */
+#define GRID_INDEX(r, g, b) ((((r) >> 3) << 10) | (((g) >> 3) << 5) | ((b) >> 3))
+
+typedef struct
+{
+  const guchar *src;     /* rows src_y .. src_y + src_rows of the area */
+  gint          src_y;
+  gint          src_rows;
+  guchar       *dest[SKIN_MASK_MAX_OUTPUTS];  /* rows y .. y + rows */
+  gint          y;
+  gint          rows;
+  const guchar *mask;    /* the selection over rows y .. y + rows, or NULL */
+  const GArray *faces;   /* the skin is limited to around them, or NULL */
+
+  gint          width;   /* of the area */
+  gint          height;
+  gint          bpp;
+  gint          radius;  /* of the feathering */
+  gint          smooth_radius;
+  gfloat        smooth_epsilon;
+  gint          halo;    /* the larger one */
+  gint          n_outputs;
+  guchar        map[SKIN_MASK_MAX_OUTPUTS][3][256];
+} Strip;
+
+static guchar grid[32 * 32 * 32];
+static gboolean grid_valid = FALSE;
+
+/* 1 inside low .. high, falling to 0 over margin outside */
+static gdouble
+ramp (gdouble value, gdouble low, gdouble high, gdouble margin)
+{
+  if (value < low)
+    return MAX (0, 1 - (low - value) / margin);
+  if (value > high)
+    return MAX (0, 1 - (value - high) / margin);
+  return 1;
+}
+
+guchar
+skin_mask_classify (guchar red,
+                    guchar green,
+                    guchar blue)
+{
+  gint    r = red, g = green, b = blue;
+  gdouble y = 0.299 * r + 0.587 * g + 0.114 * b;
+  gdouble cb = 128 - 0.168736 * r - 0.331264 * g + 0.5 * b;
+  gdouble cr = 128 + 0.5 * r - 0.418688 * g - 0.081312 * b;
+  gint    max = MAX (r, MAX (g, b));
+  gint    min = MIN (r, MIN (g, b));
+  gdouble hue;
+
+  /* skin is reddish: red is the largest, the hue is 0 .. 50 degrees */
+  if (max != r || max == min)
+    return 0;
+
+  hue = 60.0 * (g - b) / (max - min);
+  if (hue < -20 || hue > 50)
+    return 0;
+
+  /* the chroma box of Chai and Ngan, too dark pixels are left alone */
+  return ROUND (255 * ramp (cb, 77, 127, 10) * ramp (cr, 133, 173, 10) *
+                ramp (y, 60, 255, 30));
+}
+
+/* the grid is filled at the center of each cell */
+static void
+grid_init (void)
+{
+  gint r, g, b;
+
+  if (grid_valid)
+    return;
+
+  for (r = 0; r < 256; r += 8)
+    for (g = 0; g < 256; g += 8)
+      for (b = 0; b < 256; b += 8)
+        grid[GRID_INDEX (r, g, b)] = skin_mask_classify (r + 4, g + 4, b + 4);
+
+  grid_valid = TRUE;
+}
+
+void
+skin_mask_feather (const gfloat *src,
+                   gfloat       *dest,
+                   gint          width,
+                   gint          height,
+                   gint          radius)
+{
+  gint    outer_width = width + 6 * radius;
+  gint    outer_height = height + 6 * radius;
+  gfloat *tmp = g_new (gfloat, (outer_width - 2 * radius) * outer_height);
+  gfloat *pass1 = g_new (gfloat, (outer_width - 2 * radius) * (outer_height - 2 * radius));
+  gfloat *pass2 = g_new (gfloat, (outer_width - 4 * radius) * (outer_height - 4 * radius));
+
+  /* each pass takes radius off every side */
+  guided_filter_box_mean (src, pass1, tmp,
+                          outer_width, outer_height, radius);
+  guided_filter_box_mean (pass1, pass2, tmp,
+                          outer_width - 2 * radius, outer_height - 2 * radius, radius);
+  guided_filter_box_mean (pass2, dest, tmp,
+                          outer_width - 4 * radius, outer_height - 4 * radius, radius);
+
+  g_free (tmp);
+  g_free (pass1);
+  g_free (pass2);
+}
+
+/* the tile at x1 with halo pixels around, edge pixels repeated outside
+ * the area, either the skin values or channel c (0..1) of the pixels.
+ * FALSE when it is all 0. Away from the faces there is no skin.
+ */
+static gboolean
+tile_plane (const Strip *strip,
+            gint         x1,
+            gint         width,
+            gint         halo,
+            gint         c,
+            gfloat      *plane)
+{
+  gint     outer_width = width + 2 * halo;
+  gint     outer_height = strip->rows + 2 * halo;
+  gint     rowstride = strip->width * strip->bpp;
+  gboolean any = FALSE;
+  gint     x, y;
+
+  for (y = 0; y < outer_height; y++)
+  {
+    gint          sy = CLAMP (strip->y + y - halo, 0, strip->height - 1);
+    const guchar *row = strip->src + (sy - strip->src_y) * rowstride;
+    gfloat       *p = plane + y * outer_width;
+
+    for (x = 0; x < outer_width; x++)
+    {
+      gint          sx = CLAMP (x1 + x - halo, 0, strip->width - 1);
+      const guchar *pixel = row + sx * strip->bpp;
+      guchar        value;
+
+      if (c >= 0)
+        value = pixel[c];
+      else if (strip->faces && !face_near (strip->faces, sx, sy))
+        value = 0;
+      else
+        value = grid[GRID_INDEX (pixel[0], pixel[1], pixel[2])];
+
+      p[x] = value / 255.0;
+      any |= (value != 0);
+    }
+  }
+
+  return any;
+}
+
+/* smooth and whiten the tiles [start, end) of a strip */
+static void
+strip_tiles (gint start, gint end, gint thread, gpointer data)
+{
+  Strip *strip = data;
+  gint   skin_halo = SKIN_MASK_HALO (strip->radius);
+  gint   smooth_halo = GUIDED_FILTER_HALO (strip->smooth_radius);
+  gint   bpp = strip->bpp;
+  gint   rowstride = strip->width * bpp;
+  gint   tile;
+
+  for (tile = start; tile < end; tile++)
+  {
+    gint          x1 = tile * TILE_SIZE;
+    gint          width = MIN (TILE_SIZE, strip->width - x1);
+    gint          n_pixels = width * strip->rows;
+    const guchar *s = strip->src + (strip->y - strip->src_y) * rowstride + x1 * bpp;
+    gfloat       *plane = g_new (gfloat, (width + 2 * strip->halo) * (strip->rows + 2 * strip->halo));
+    gboolean      skin = FALSE;
+    gint          i, o, x, y, c;
+
+    if ((!strip->mask ||
+         pixel_kernel_mask_any (strip->mask + x1, width, strip->rows, strip->width)) &&
+        (!strip->faces ||
+         face_near_rect (strip->faces, x1 - skin_halo, strip->y - skin_halo,
+                         width + 2 * skin_halo, strip->rows + 2 * skin_halo)) &&
+        pixel_kernel_classify (s, width, strip->rows, rowstride,
+                               bpp) != PIXEL_KERNEL_TILE_TRANSPARENT)
+      skin = tile_plane (strip, x1, width, skin_halo, -1, plane);
+
+    /* no skin around, the tile is copied as it is */
+    if (!skin)
+    {
+      for (o = 0; o < strip->n_outputs; o++)
+        for (y = 0; y < strip->rows; y++)
+          memcpy (strip->dest[o] + y * rowstride + x1 * bpp, s + y * rowstride, width * bpp);
+      g_free (plane);
+      continue;
+    }
+
+    gfloat *mask = g_new (gfloat, n_pixels);
+    gfloat *smooth = g_new (gfloat, 3 * n_pixels);
+
+    skin_mask_feather (plane, mask, width, strip->rows, strip->radius);
+
+    /* the smoothed channels, the color values as they are without */
+    for (c = 0; c < 3; c++)
+    {
+      gfloat *result = smooth + c * n_pixels;
+
+      if (strip->smooth_radius > 0)
+      {
+        tile_plane (strip, x1, width, smooth_halo, c, plane);
+        guided_filter_plane (plane, result, width, strip->rows,
+                             strip->smooth_radius, strip->smooth_epsilon);
+      }
+      else
+      {
+        for (y = 0, i = 0; y < strip->rows; y++)
+          for (x = 0; x < width; x++, i++)
+            result[i] = s[y * rowstride + x * bpp + c] / 255.0;
+      }
+    }
+
+    /* both mixed in by the skin mask, the smoothing first, and each
+     * output with its own colors mapping
+     */
+    for (y = 0, i = 0; y < strip->rows; y++)
+    {
+      const guchar *sp = s + y * rowstride;
+      gsize         offset = y * rowstride + x1 * bpp;
+
+      for (x = 0; x < width; x++, i++, sp += bpp, offset += bpp)
+      {
+        gfloat m = mask[i];
+
+        for (c = 0; c < 3; c++)
+        {
+          gfloat filtered = smooth[c * n_pixels + i] * 255;
+          gint   value = CLAMP (ROUND (sp[c] + (filtered - sp[c]) * m), 0, 255);
+
+          for (o = 0; o < strip->n_outputs; o++)
+            strip->dest[o][offset + c] = value + ROUND ((strip->map[o][c][value] - value) * m);
+        }
+        if (bpp == 4)
+          for (o = 0; o < strip->n_outputs; o++)
+            strip->dest[o][offset + 3] = sp[3];
+      }
+    }
+
+    g_free (plane);
+    g_free (mask);
+    g_free (smooth);
+  }
+}
+
+typedef struct
+{
+  const guchar *buf;
+  gint          bpp;
+  SkinStats    *stats;   /* one per thread */
+} Count;
+
+static void
+count_skin (gint start, gint end, gint thread, gpointer data)
+{
+  Count        *count = data;
+  SkinStats    *stats = &count->stats[thread];
+  gint          bpp = count->bpp;
+  const guchar *p = count->buf + (gsize) start * bpp;
+  gint          i;
+
+  for (i = start; i < end; i++, p += bpp)
+  {
+    gdouble weight = grid[GRID_INDEX (p[0], p[1], p[2])] / 255.0;
+    gint    max = MAX (p[0], MAX (p[1], p[2]));
+    gint    min = MIN (p[0], MIN (p[1], p[2]));
+
+    if (bpp == 4)
+      weight *= p[3] / 255.0;
+    if (weight <= 0)
+      continue;
+
+    /* skin has red as the largest */
+    stats->weight += weight;
+    stats->luminance += weight * (0.299 * p[0] + 0.587 * p[1] + 0.114 * p[2]);
+    stats->hue += weight * 60.0 * (p[1] - p[2]) / (max - min);
+    stats->red_blue += weight * (p[0] - p[2]);
+  }
+}
+
+void
+skin_stats_buffer (SkinStats    *stats,
+                   const guchar *buf,
+                   gint          n_pixels,
+                   gint          bpp)
+{
+  Count count;
+  gint  i;
+
+  grid_init ();
+
+  count.buf = buf;
+  count.bpp = bpp;
+  count.stats = g_new0 (SkinStats, pixel_kernel_num_threads ());
+
+  pixel_kernel_parallel (n_pixels, count_skin, &count);
+
+  /* add up the threads */
+  memset (stats, 0, sizeof (SkinStats));
+  for (i = 0; i < pixel_kernel_num_threads (); i++)
+  {
+    stats->weight += count.stats[i].weight;
+    stats->luminance += count.stats[i].luminance;
+    stats->hue += count.stats[i].hue;
+    stats->red_blue += count.stats[i].red_blue;
+  }
+
+  if (stats->weight > 0)
+  {
+    stats->luminance /= stats->weight;
+    stats->hue /= stats->weight;
+    stats->red_blue /= stats->weight;
+  }
+  stats->fraction = (n_pixels > 0) ? stats->weight / n_pixels : 0;
+
+  g_free (count.stats);
+}
+
+void
+skin_stats_collect (SkinStats *stats,
+                    gint32     drawable_ID,
+                    gint       max_pixels)
+{
+  guchar *buf;
+  gint    x, y, width, height;
+  gint    step = 1;
+  gint    columns, rows, bpp;
+
+  memset (stats, 0, sizeof (SkinStats));
+
+  if (!gimp_drawable_is_rgb (drawable_ID) ||
+      !gimp_drawable_mask_intersect (drawable_ID, &x, &y, &width, &height))
+    return;
+
+  if (max_pixels > 0 && (gdouble) width * height > max_pixels)
+    step = ceil (sqrt ((gdouble) width * height / max_pixels));
+
+  columns = (width + step - 1) / step;
+  rows = (height + step - 1) / step;
+  buf = pixel_kernel_sample (drawable_ID, x, y, width, height, &columns, &rows, &bpp);
+  if (!buf)
+    return;
+
+  skin_stats_buffer (stats, buf, columns * rows, bpp);
+
+  g_free (buf);
+}
+
+/* the settings of a sweep over width x height pixels */
+static void
+strip_init (Strip          *strip,
+            const ColorLut *luts,
+            gint            n_outputs,
+            gint            width,
+            gint            height,
+            gint            bpp,
+            gint            radius,
+            gint            smooth_radius,
+            gdouble         smooth_epsilon,
+            const GArray   *faces)
+{
+  gint o, c, v;
+
+  grid_init ();
+
+  /* the value table goes in front of each color table */
+  for (o = 0; o < n_outputs; o++)
+    for (c = 0; c < 3; c++)
+      for (v = 0; v < 256; v++)
+        strip->map[o][c][v] = luts[o].lut[COLOR_LUT_RED + c][luts[o].lut[COLOR_LUT_VALUE][v]];
+
+  strip->n_outputs = n_outputs;
+  strip->mask = NULL;
+  strip->faces = faces;
+  strip->width = width;
+  strip->height = height;
+  strip->bpp = bpp;
+  strip->radius = MAX (1, radius);
+  strip->smooth_radius = MAX (0, smooth_radius);
+  strip->smooth_epsilon = smooth_epsilon;
+  strip->halo = MAX (SKIN_MASK_HALO (strip->radius),
+                     GUIDED_FILTER_HALO (strip->smooth_radius));
+}
+
+void
+skin_mask_buffer (const guchar    *src,
+                  guchar         **dests,
+                  const ColorLut  *luts,
+                  gint             n_outputs,
+                  gint             width,
+                  gint             height,
+                  gint             bpp,
+                  gint             radius,
+                  gint             smooth_radius,
+                  gdouble          smooth_epsilon,
+                  const GArray    *faces)
+{
+  Strip strip;
+  gint  row, o;
+
+  n_outputs = MIN (n_outputs, SKIN_MASK_MAX_OUTPUTS);
+  strip_init (&strip, luts, n_outputs, width, height, bpp,
+              radius, smooth_radius, smooth_epsilon, faces);
+
+  /* all of src is there, each strip reads its halo from it */
+  strip.src = src;
+  strip.src_y = 0;
+  strip.src_rows = height;
+
+  for (row = 0; row < height; row += TILE_SIZE)
+  {
+    strip.y = row;
+    strip.rows = MIN (TILE_SIZE, height - row);
+    for (o = 0; o < n_outputs; o++)
+      strip.dest[o] = dests[o] + (gsize) row * width * bpp;
+
+    pixel_kernel_parallel ((width + TILE_SIZE - 1) / TILE_SIZE, strip_tiles, &strip);
+  }
+}
+
+void
+skin_mask_run (gint32          drawable_ID,
+               const ColorLut *lut,
+               gint            radius,
+               gint            smooth_radius,
+               gdouble         smooth_epsilon,
+               const GArray   *faces)
+{
+  GimpDrawable    *drawable;
+  GimpPixelRgn     src_rgn, dest_rgn;
+  PixelKernelMask  mask;
+  Strip            strip;
+  gint             x, y, width, height;
+  gint             halo;
+  gint             row;
+
+  if (!gimp_drawable_is_rgb (drawable_ID) ||
+      (color_lut_is_identity (lut) && smooth_radius < 1))
+    return;
+
+  if (!gimp_drawable_mask_intersect (drawable_ID, &x, &y, &width, &height))
+    return;
+
+  drawable = gimp_drawable_get (drawable_ID);
+
+  strip_init (&strip, lut, 1, width, height, drawable->bpp,
+              radius, smooth_radius, smooth_epsilon, faces);
+  halo = strip.halo;
+
+  gimp_tile_cache_ntiles (3 * (width / gimp_tile_width () + 1) *
+                          ((TILE_SIZE + 2 * halo) / gimp_tile_height () + 2));
+
+  guchar *src = g_new (guchar, (gsize) width * (TILE_SIZE + 2 * halo) * drawable->bpp);
+  guchar *dest = g_new (guchar, (gsize) width * TILE_SIZE * drawable->bpp);
+
+  gimp_pixel_rgn_init (&src_rgn, drawable, x, y, width, height, FALSE, FALSE);
+  gimp_pixel_rgn_init (&dest_rgn, drawable, x, y, width, height, TRUE, TRUE);
+  pixel_kernel_mask_init (&mask, drawable_ID, x, y, width, TILE_SIZE);
+
+  /* strips of TILE_SIZE rows, read with the halo rows above and below,
+   * the tiles of a strip are spread over the threads
+   */
+  for (row = 0; row < height; row += TILE_SIZE)
+  {
+    if (!pixel_kernel_mask_read (&mask, y + row, MIN (TILE_SIZE, height - row)))
+      continue;
+
+    strip.mask = mask.buf;
+    strip.y = row;
+    strip.rows = MIN (TILE_SIZE, height - row);
+    strip.src_y = MAX (0, row - halo);
+    strip.src_rows = MIN (height, row + strip.rows + halo) - strip.src_y;
+    strip.src = src;
+    strip.dest[0] = dest;
+
+    gimp_pixel_rgn_get_rect (&src_rgn, src, x, y + strip.src_y, width, strip.src_rows);
+    pixel_kernel_parallel ((width + TILE_SIZE - 1) / TILE_SIZE, strip_tiles, &strip);
+    gimp_pixel_rgn_set_rect (&dest_rgn, dest, x, y + row, width, strip.rows);
+  }
+
+  g_free (src);
+  g_free (dest);
+  pixel_kernel_mask_free (&mask);
+
+  gimp_drawable_flush (drawable);
+  gimp_drawable_merge_shadow (drawable_ID, TRUE);
+  gimp_drawable_update (drawable_ID, x, y, width, height);
+  gimp_drawable_detach (drawable);
+}
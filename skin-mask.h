@@ -0,0 +1,96 @@
+/**
+ * Copyright (C) 2012 hejian <hejian.he@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Skin detection for the whitening. A color is skin when its chroma
+ * (Cb, Cr) and its hue fall in the usual skin tone ranges, the test is
+ * done once for a 32 x 32 x 32 grid of colors and looked up per pixel.
+ * The mask is feathered with three box blurs, which is close to a
+ * gaussian and costs the same for any radius. The guided filter smooths
+ * the skin and the colors mapping whitens it, both mixed in by the mask.
+ * Everything runs in one sweep over the tiles.
+ */
+
+/* pixels of context needed around each output pixel */
+#define SKIN_MASK_HALO(radius) (3 * (radius))
+
+#define SKIN_MASK_MAX_OUTPUTS 9
+
+/* how much a color is skin, 0..255 */
+guchar skin_mask_classify (guchar          red,
+                           guchar          green,
+                           guchar          blue);
+
+/* the skin tones of an image, each pixel counts as much as it is skin */
+typedef struct
+{
+  gdouble weight;     /* the amount of skin, in pixels */
+  gdouble fraction;   /* of the pixels looked at */
+  gdouble luminance;  /* the means, 0..255 */
+  gdouble hue;        /* degrees, yellow is larger */
+  gdouble red_blue;   /* red minus blue */
+} SkinStats;
+
+/* n_pixels RGB or RGBA pixels, counted by all threads */
+void   skin_stats_buffer  (SkinStats      *stats,
+                           const guchar   *buf,
+                           gint            n_pixels,
+                           gint            bpp);
+
+/* the selected part of an RGB drawable, scaled down to look at no more
+ * than about max_pixels, 0 looks at all
+ */
+void   skin_stats_collect (SkinStats      *stats,
+                           gint32          drawable_ID,
+                           gint            max_pixels);
+
+/* feather the skin values (0..1) of a tile, src is (width + 6 * radius)
+ * x (height + 6 * radius) values, dest gets width x height
+ */
+void   skin_mask_feather  (const gfloat   *src,
+                           gfloat         *dest,
+                           gint            width,
+                           gint            height,
+                           gint            radius);
+
+/* smooth and whiten the skin of the selected part of an RGB drawable:
+ * the guided filter (smooth_radius 0 for none) and then lut are mixed
+ * in by the skin mask, feathered over radius. With faces, an array of
+ * Face in the coordinates of the selected part, only the skin near them
+ * is, NULL takes all of it.
+ */
+void   skin_mask_run      (gint32          drawable_ID,
+                           const ColorLut *lut,
+                           gint            radius,
+                           gint            smooth_radius,
+                           gdouble         smooth_epsilon,
+                           const GArray   *faces);
+
+/* the same on a buffer of width x height RGB or RGBA pixels, written
+ * to n_outputs buffers, each mapped through its own lut. The mask and
+ * the smoothing are done once for all of them.
+ */
+void   skin_mask_buffer   (const guchar    *src,
+                           guchar         **dests,
+                           const ColorLut  *luts,
+                           gint             n_outputs,
+                           gint             width,
+                           gint             height,
+                           gint             bpp,
+                           gint             radius,
+                           gint             smooth_radius,
+                           gdouble          smooth_epsilon,
+                           const GArray    *faces);
@@ -15,20 +15,28 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+
 #include <libgimp/gimp.h>
 
+#include "color-lut.h"
+#include "face-detect.h"
+#include "skin-mask.h"
 #include "skin-whitening-effect.h"
 
-void
-run_effect (gint32 image_ID, WhiteningEffectType effect)
+/* the curves of each effect, for red, green and blue */
+typedef struct
 {
-  gint32 layer = gimp_image_get_active_layer (image_ID);
+  WhiteningEffectType effect;
+  guint8              control_pts[3][18];
+} WhiteningCurves;
 
-  switch (effect)
+static const WhiteningCurves whitening_curves[] =
+{
   {
-    case WHITENING_EFFECT_LITTLE_WHITENING:
+    WHITENING_EFFECT_LITTLE_WHITENING,
     {
-      guint8 pts[] = {
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.160784 * 255,
         0.247059 * 255, 0.317647 * 255,
@@ -38,15 +46,35 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.819608 * 255,
         0.874510 * 255, 0.913725 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_RED, 18, pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_GREEN, 18, pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_BLUE, 18, pts);
-      break;
-    }
-    case WHITENING_EFFECT_MODERATE_WHITENING:
+      },
+      {
+        0.000000 * 255, 0.007843 * 255,
+        0.121569 * 255, 0.160784 * 255,
+        0.247059 * 255, 0.317647 * 255,
+        0.372549 * 255, 0.462745 * 255,
+        0.498039 * 255, 0.592157 * 255,
+        0.623529 * 255, 0.713725 * 255,
+        0.749020 * 255, 0.819608 * 255,
+        0.874510 * 255, 0.913725 * 255,
+        1.000000 * 255, 0.996078 * 255,
+      },
+      {
+        0.000000 * 255, 0.007843 * 255,
+        0.121569 * 255, 0.160784 * 255,
+        0.247059 * 255, 0.317647 * 255,
+        0.372549 * 255, 0.462745 * 255,
+        0.498039 * 255, 0.592157 * 255,
+        0.623529 * 255, 0.713725 * 255,
+        0.749020 * 255, 0.819608 * 255,
+        0.874510 * 255, 0.913725 * 255,
+        1.000000 * 255, 0.996078 * 255,
+      },
+    },
+  },
+  {
+    WHITENING_EFFECT_MODERATE_WHITENING,
     {
-      guint8 pts[] = {
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.192157 * 255,
         0.247059 * 255, 0.372549 * 255,
@@ -56,15 +84,35 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.874510 * 255,
         0.874510 * 255, 0.945098 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_RED, 18, pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_GREEN, 18, pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_BLUE, 18, pts);
-      break;
-    }
-    case WHITENING_EFFECT_HIGH_WHITENING:
+      },
+      {
+        0.000000 * 255, 0.007843 * 255,
+        0.121569 * 255, 0.192157 * 255,
+        0.247059 * 255, 0.372549 * 255,
+        0.372549 * 255, 0.529412 * 255,
+        0.498039 * 255, 0.666667 * 255,
+        0.623529 * 255, 0.784314 * 255,
+        0.749020 * 255, 0.874510 * 255,
+        0.874510 * 255, 0.945098 * 255,
+        1.000000 * 255, 0.996078 * 255,
+      },
+      {
+        0.000000 * 255, 0.007843 * 255,
+        0.121569 * 255, 0.192157 * 255,
+        0.247059 * 255, 0.372549 * 255,
+        0.372549 * 255, 0.529412 * 255,
+        0.498039 * 255, 0.666667 * 255,
+        0.623529 * 255, 0.784314 * 255,
+        0.749020 * 255, 0.874510 * 255,
+        0.874510 * 255, 0.945098 * 255,
+        1.000000 * 255, 0.996078 * 255,
+      },
+    },
+  },
+  {
+    WHITENING_EFFECT_HIGH_WHITENING,
     {
-      guint8 pts[] = {
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.223529 * 255,
         0.247059 * 255, 0.427451 * 255,
@@ -74,15 +122,35 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.933333 * 255,
         0.874510 * 255, 0.980392 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_RED, 18, pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_GREEN, 18, pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_BLUE, 18, pts);
-      break;
-    }
-    case WHITENING_EFFECT_LITTLE_PINK:
+      },
+      {
+        0.000000 * 255, 0.007843 * 255,
+        0.121569 * 255, 0.223529 * 255,
+        0.247059 * 255, 0.427451 * 255,
+        0.372549 * 255, 0.600000 * 255,
+        0.498039 * 255, 0.741176 * 255,
+        0.623529 * 255, 0.854902 * 255,
+        0.749020 * 255, 0.933333 * 255,
+        0.874510 * 255, 0.980392 * 255,
+        1.000000 * 255, 0.996078 * 255,
+      },
+      {
+        0.000000 * 255, 0.007843 * 255,
+        0.121569 * 255, 0.223529 * 255,
+        0.247059 * 255, 0.427451 * 255,
+        0.372549 * 255, 0.600000 * 255,
+        0.498039 * 255, 0.741176 * 255,
+        0.623529 * 255, 0.854902 * 255,
+        0.749020 * 255, 0.933333 * 255,
+        0.874510 * 255, 0.980392 * 255,
+        1.000000 * 255, 0.996078 * 255,
+      },
+    },
+  },
+  {
+    WHITENING_EFFECT_LITTLE_PINK,
     {
-      guint8 red_pts[] = {
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.160784 * 255,
         0.247059 * 255, 0.317647 * 255,
@@ -92,8 +160,8 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.819608 * 255,
         0.874510 * 255, 0.913725 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      guint8 pts[] = {
+      },
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.145098 * 255,
         0.247059 * 255, 0.290196 * 255,
@@ -103,15 +171,24 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.792157 * 255,
         0.874510 * 255, 0.898039 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_GREEN, 18, pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_BLUE, 18, pts);
-      break;
-    }
-    case WHITENING_EFFECT_MODERATE_PINK:
+      },
+      {
+        0.000000 * 255, 0.007843 * 255,
+        0.121569 * 255, 0.145098 * 255,
+        0.247059 * 255, 0.290196 * 255,
+        0.372549 * 255, 0.427451 * 255,
+        0.498039 * 255, 0.556863 * 255,
+        0.623529 * 255, 0.678431 * 255,
+        0.749020 * 255, 0.792157 * 255,
+        0.874510 * 255, 0.898039 * 255,
+        1.000000 * 255, 0.996078 * 255,
+      },
+    },
+  },
+  {
+    WHITENING_EFFECT_MODERATE_PINK,
     {
-      guint8 red_pts[] = {
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.192157 * 255,
         0.247059 * 255, 0.372549 * 255,
@@ -121,8 +198,8 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.874510 * 255,
         0.874510 * 255, 0.945098 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      guint8 pts[] = {
+      },
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.160784 * 255,
         0.247059 * 255, 0.321569 * 255,
@@ -132,15 +209,24 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.827451 * 255,
         0.874510 * 255, 0.917647 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_GREEN, 18, pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_BLUE, 18, pts);
-      break;
-    }
-    case WHITENING_EFFECT_HIGH_PINK:
+      },
+      {
+        0.000000 * 255, 0.007843 * 255,
+        0.121569 * 255, 0.160784 * 255,
+        0.247059 * 255, 0.321569 * 255,
+        0.372549 * 255, 0.470588 * 255,
+        0.498039 * 255, 0.600000 * 255,
+        0.623529 * 255, 0.721569 * 255,
+        0.749020 * 255, 0.827451 * 255,
+        0.874510 * 255, 0.917647 * 255,
+        1.000000 * 255, 0.996078 * 255,
+      },
+    },
+  },
+  {
+    WHITENING_EFFECT_HIGH_PINK,
     {
-      guint8 red_pts[] = {
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.223529 * 255,
         0.247059 * 255, 0.427451 * 255,
@@ -150,8 +236,8 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.933333 * 255,
         0.874510 * 255, 0.980392 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      guint8 pts[] = {
+      },
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.180392 * 255,
         0.247059 * 255, 0.356863 * 255,
@@ -161,15 +247,24 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.862745 * 255,
         0.874510 * 255, 0.937255 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_GREEN, 18, pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_BLUE, 18, pts);
-      break;
-    }
-    case WHITENING_EFFECT_LITTLE_FLESH:
+      },
+      {
+        0.000000 * 255, 0.007843 * 255,
+        0.121569 * 255, 0.180392 * 255,
+        0.247059 * 255, 0.356863 * 255,
+        0.372549 * 255, 0.513725 * 255,
+        0.498039 * 255, 0.647059 * 255,
+        0.623529 * 255, 0.764706 * 255,
+        0.749020 * 255, 0.862745 * 255,
+        0.874510 * 255, 0.937255 * 255,
+        1.000000 * 255, 0.996078 * 255,
+      },
+    },
+  },
+  {
+    WHITENING_EFFECT_LITTLE_FLESH,
     {
-      guint8 red_pts[] = {
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.160784 * 255,
         0.247059 * 255, 0.317647 * 255,
@@ -179,8 +274,8 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.819608 * 255,
         0.874510 * 255, 0.913725 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      guint8 green_pts[] = {
+      },
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.152941 * 255,
         0.247059 * 255, 0.301961 * 255,
@@ -190,8 +285,8 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.807843 * 255,
         0.874510 * 255, 0.905882 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      guint8 blue_pts[] = {
+      },
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.145098 * 255,
         0.247059 * 255, 0.294118 * 255,
@@ -201,15 +296,13 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.796078 * 255,
         0.874510 * 255, 0.901961 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
-    }
-    case WHITENING_EFFECT_MODERATE_FLESH:
+      },
+    },
+  },
+  {
+    WHITENING_EFFECT_MODERATE_FLESH,
     {
-      guint8 red_pts[] = {
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.192157 * 255,
         0.247059 * 255, 0.372549 * 255,
@@ -219,8 +312,8 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.874510 * 255,
         0.874510 * 255, 0.945098 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      guint8 green_pts[] = {
+      },
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.176471 * 255,
         0.247059 * 255, 0.345098 * 255,
@@ -230,8 +323,8 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.850980 * 255,
         0.874510 * 255, 0.933333 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      guint8 blue_pts[] = {
+      },
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.164706 * 255,
         0.247059 * 255, 0.329412 * 255,
@@ -241,15 +334,13 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.835294 * 255,
         0.874510 * 255, 0.921569 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
-    }
-    case WHITENING_EFFECT_HIGH_FLESH:
+      },
+    },
+  },
+  {
+    WHITENING_EFFECT_HIGH_FLESH,
     {
-      guint8 red_pts[] = {
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.223529 * 255,
         0.247059 * 255, 0.427451 * 255,
@@ -259,8 +350,8 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.933333 * 255,
         0.874510 * 255, 0.980392 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      guint8 green_pts[] = {
+      },
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.203922 * 255,
         0.247059 * 255, 0.392157 * 255,
@@ -270,8 +361,8 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.898039 * 255,
         0.874510 * 255, 0.960784 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      guint8 blue_pts[] = {
+      },
+      {
         0.000000 * 255, 0.007843 * 255,
         0.121569 * 255, 0.188235 * 255,
         0.247059 * 255, 0.368627 * 255,
@@ -281,11 +372,271 @@ run_effect (gint32 image_ID, WhiteningEffectType effect)
         0.749020 * 255, 0.874510 * 255,
         0.874510 * 255, 0.945098 * 255,
         1.000000 * 255, 0.996078 * 255,
-      };
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_RED, 18, red_pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_GREEN, 18, green_pts);
-      gimp_curves_spline (layer, GIMP_HISTOGRAM_BLUE, 18, blue_pts);
-      break;
+      },
+    },
+  },
+};
+
+void
+whitening_effect_lut (WhiteningEffectType effect, ColorLut *lut)
+{
+  gint i, c;
+
+  for (i = 0; i < G_N_ELEMENTS (whitening_curves); i++)
+  {
+    const WhiteningCurves *curves = &whitening_curves[i];
+
+    if (curves->effect != effect)
+      continue;
+
+    for (c = 0; c < 3; c++)
+      color_lut_spline (lut, COLOR_LUT_RED + c, 18, curves->control_pts[c]);
+  }
+}
+
+void
+whitening_effect_params (WhiteningEffectType  effect,
+                         WhiteningFamily     *family,
+                         gdouble             *strength)
+{
+  if (effect < WHITENING_EFFECT_LITTLE_WHITENING ||
+      effect > WHITENING_EFFECT_HIGH_FLESH)
+  {
+    *family = WHITENING_FAMILY_WHITENING;
+    *strength = 0;
+    return;
+  }
+
+  /* three presets per family, from little to high */
+  *family = (effect - 1) / 3;
+  *strength = WHITENING_STRENGTH ((effect - 1) % 3 + 1);
+}
+
+void
+whitening_lut (WhiteningFamily  family,
+               gdouble          strength,
+               ColorLut        *lut)
+{
+  static ColorLut presets[3][4];
+  static gboolean presets_valid = FALSE;
+  gdouble         level = CLAMP (strength, 0, 100) * 3 / 100;
+  gint            low = MIN ((gint) level, 2);
+  gdouble         t = level - low;
+  gint            f, i, c, v;
+
+  /* the splines are evaluated once, level 0 is no change */
+  if (!presets_valid)
+  {
+    for (f = 0; f < 3; f++)
+      for (i = 0; i < 4; i++)
+      {
+        color_lut_init (&presets[f][i]);
+        if (i > 0)
+          whitening_effect_lut (f * 3 + i, &presets[f][i]);
+      }
+    presets_valid = TRUE;
+  }
+
+  family = CLAMP (family, WHITENING_FAMILY_WHITENING, WHITENING_FAMILY_FLESH);
+
+  color_lut_init (lut);
+  for (c = COLOR_LUT_RED; c <= COLOR_LUT_BLUE; c++)
+  {
+    const guchar *a = presets[family][low].lut[c];
+    const guchar *b = presets[family][low + 1].lut[c];
+
+    for (v = 0; v < 256; v++)
+      lut->lut[c][v] = ROUND (a[v] + (b[v] - a[v]) * t);
+  }
+}
+
+void
+whitening_auto (const SkinStats *stats,
+                WhiteningFamily *family,
+                gdouble         *strength)
+{
+  ColorLut high;
+  gint     luminance = CLAMP (ROUND (stats->luminance), 0, 255);
+  gdouble  lift;
+
+  /* sallow skin gets pinker, red skin is only lightened, the rest
+   * gets the warm flesh curves
+   */
+  if (stats->hue > 28)
+    *family = WHITENING_FAMILY_PINK;
+  else if (stats->hue < 12 || stats->red_blue > 90)
+    *family = WHITENING_FAMILY_WHITENING;
+  else
+    *family = WHITENING_FAMILY_FLESH;
+
+  /* too little skin to go by */
+  if (stats->fraction < 0.005)
+  {
+    *strength = 0;
+    return;
+  }
+
+  /* lift the mean skin luminance toward 195, as a part of what the
+   * high preset of the family does there
+   */
+  whitening_lut (*family, 100, &high);
+  lift = high.lut[COLOR_LUT_GREEN][luminance] - luminance;
+
+  if (lift <= 0)
+    *strength = 0;
+  else
+    *strength = CLAMP (100 * CLAMP (195 - stats->luminance, 0, 60) / lift, 0, 100);
+}
+
+/* the feathering and the smoothing follow the image size, so the
+ * preview looks like the result
+ */
+static void
+whitening_radii (gint     width,
+                 gint     height,
+                 gdouble  smoothing,
+                 gint    *radius,
+                 gint    *smooth_radius,
+                 gdouble *epsilon)
+{
+  gint    size = MIN (width, height);
+  gdouble t = CLAMP (smoothing, 0, 100) / 100;
+
+  *radius = ROUND (size / 300.0);
+  *smooth_radius = (t > 0) ? MAX (1, ROUND (size / 150.0)) : 0;
+  *epsilon = 0.02 * t * t;
+}
+
+/* no skin to find in gray, the green curve lightens everything */
+static void
+gray_lut (const ColorLut *lut, ColorLut *gray)
+{
+  color_lut_init (gray);
+  color_lut_map (gray, COLOR_LUT_VALUE, lut->lut[COLOR_LUT_GREEN]);
+}
+
+const FaceCascade *
+whitening_face_cascade (void)
+{
+  static FaceCascade *cascade = NULL;
+  static gboolean     loaded = FALSE;
+
+  if (!loaded)
+  {
+    gchar *filename = gimp_personal_rc_file (WHITENING_FACE_CASCADE);
+
+    /* no file, no faces */
+    if (g_file_test (filename, G_FILE_TEST_IS_REGULAR))
+    {
+      GError *error = NULL;
+
+      cascade = face_cascade_load (filename, &error);
+      if (!cascade)
+      {
+        g_message ("Could not read face cascade: %s", error->message);
+        g_error_free (error);
+      }
     }
+
+    g_free (filename);
+    loaded = TRUE;
   }
+
+  return cascade;
+}
+
+void
+run_whitening (gint32             image_ID,
+               const ColorLut    *lut,
+               gdouble            smoothing,
+               const FaceCascade *cascade)
+{
+  gint32 layer = gimp_image_get_active_layer (image_ID);
+
+  if (gimp_drawable_is_rgb (layer))
+  {
+    GArray *faces = NULL;
+    gint    radius, smooth_radius;
+    gdouble epsilon;
+
+    if (cascade)
+      faces = face_detect_drawable (cascade, layer, WHITENING_FACE_SIZE);
+
+    whitening_radii (gimp_image_width (image_ID), gimp_image_height (image_ID),
+                     smoothing, &radius, &smooth_radius, &epsilon);
+    skin_mask_run (layer, lut, radius, smooth_radius, epsilon, faces);
+
+    if (faces)
+      g_array_free (faces, TRUE);
+  }
+  else
+  {
+    ColorLut gray;
+
+    gray_lut (lut, &gray);
+    color_lut_run (layer, &gray);
+  }
+}
+
+void
+whitening_buffer (const guchar    *src,
+                  guchar         **dests,
+                  const ColorLut  *luts,
+                  gint             n_outputs,
+                  gint             width,
+                  gint             height,
+                  gint             bpp,
+                  gboolean         gray,
+                  gdouble          smoothing,
+                  const GArray    *faces)
+{
+  gint    radius, smooth_radius;
+  gdouble epsilon;
+  gint    o;
+
+  whitening_radii (width, height, smoothing, &radius, &smooth_radius, &epsilon);
+
+  if (gray)
+  {
+    for (o = 0; o < n_outputs; o++)
+    {
+      ColorLut gray_table;
+
+      gray_lut (&luts[o], &gray_table);
+      color_lut_apply (&gray_table, src, dests[o], width * height, bpp);
+    }
+  }
+  else if (n_outputs == 1 && color_lut_is_identity (luts) && smooth_radius < 1)
+  {
+    memcpy (dests[0], src, (gsize) width * height * bpp);
+  }
+  else
+  {
+    skin_mask_buffer (src, dests, luts, n_outputs, width, height, bpp,
+                      radius, smooth_radius, epsilon, faces);
+  }
+}
+
+void
+run_effect (gint32 image_ID, WhiteningEffectType effect)
+{
+  WhiteningFamily family;
+  gdouble         strength;
+  ColorLut        lut;
+
+  if (effect == WHITENING_EFFECT_AUTO)
+  {
+    SkinStats stats;
+
+    skin_stats_collect (&stats, gimp_image_get_active_layer (image_ID),
+                        WHITENING_AUTO_PIXELS);
+    whitening_auto (&stats, &family, &strength);
+  }
+  else
+  {
+    whitening_effect_params (effect, &family, &strength);
+  }
+
+  whitening_lut (family, strength, &lut);
+  run_whitening (image_ID, &lut, 0, NULL);
 }
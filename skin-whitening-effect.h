@@ -27,7 +27,76 @@ typedef enum
   WHITENING_EFFECT_LITTLE_FLESH,
   WHITENING_EFFECT_MODERATE_FLESH,
   WHITENING_EFFECT_HIGH_FLESH,
+  WHITENING_EFFECT_AUTO,
 } WhiteningEffectType;
 
-void run_effect (gint32 image_ID, WhiteningEffectType effect);
+typedef enum
+{
+  WHITENING_FAMILY_WHITENING,
+  WHITENING_FAMILY_PINK,
+  WHITENING_FAMILY_FLESH,
+} WhiteningFamily;
+
+/* the pixels looked at by WHITENING_EFFECT_AUTO */
+#define WHITENING_AUTO_PIXELS (256 * 256)
+
+/* the face cascade, read from this file in the personal GIMP directory */
+#define WHITENING_FACE_CASCADE "facefinder"
+
+/* the size faces are searched at */
+#define WHITENING_FACE_SIZE 480
+
+/* the strength (0..100) of the little, moderate and high presets */
+#define WHITENING_STRENGTH(level) ((level) * 100.0 / 3)
+
+/* chain the curves of an effect into lut */
+void whitening_effect_lut    (WhiteningEffectType  effect,
+                              ColorLut            *lut);
+
+/* the family and strength of a preset, not of WHITENING_EFFECT_AUTO */
+void whitening_effect_params (WhiteningEffectType  effect,
+                              WhiteningFamily     *family,
+                              gdouble             *strength);
+
+/* the curves of a family at any strength (0..100), interpolated between
+ * no change and the little, moderate and high presets
+ */
+void whitening_lut           (WhiteningFamily      family,
+                              gdouble              strength,
+                              ColorLut            *lut);
+
+/* pick the family and the strength for the skin tones of an image */
+void whitening_auto          (const SkinStats     *stats,
+                              WhiteningFamily     *family,
+                              gdouble             *strength);
+
+/* the face cascade, NULL when there is none */
+const FaceCascade *whitening_face_cascade (void);
+
+/* smooth (0..100) and whiten the skin of the active layer through lut,
+ * gray layers are whitened as a whole. With a cascade only the skin
+ * around the faces found is.
+ */
+void run_whitening           (gint32               image_ID,
+                              const ColorLut      *lut,
+                              gdouble              smoothing,
+                              const FaceCascade   *cascade);
+
+/* the same on a buffer of RGB or RGBA pixels, gray when they come from
+ * a gray layer, written to n_outputs buffers through one lut each. With
+ * faces, found in the buffer, only the skin around them.
+ */
+void whitening_buffer        (const guchar        *src,
+                              guchar             **dests,
+                              const ColorLut      *luts,
+                              gint                 n_outputs,
+                              gint                 width,
+                              gint                 height,
+                              gint                 bpp,
+                              gboolean             gray,
+                              gdouble              smoothing,
+                              const GArray        *faces);
 
+/* a preset, or the one picked for the skin of the active layer */
+void run_effect              (gint32               image_ID,
+                              WhiteningEffectType  effect);
@@ -15,13 +15,19 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+
 #include <libgimp/gimp.h>
 #include <libgimp/gimpui.h>
 
+#include "color-lut.h"
+#include "face-detect.h"
+#include "skin-mask.h"
 #include "skin-whitening-effect.h"
-#include "skin-whitening-images.h"
+#include "preview-surface.h"
 
 #define PLUG_IN_PROC   "plug-in-skin-whitening"
+#define PLUG_IN_BATCH_PROC "plug-in-skin-whitening-batch"
 #define PLUG_IN_BINARY "skin-whitening"
 #define PLUG_IN_ROLE   "gimp-skin-whitening"
 
@@ -30,7 +36,10 @@
 
 typedef struct
 {
-  WhiteningEffectType effect;
+  WhiteningFamily family;
+  gdouble         strength;  /* 0..100 */
+  gdouble         smoothing; /* 0..100 */
+  gboolean        faces;     /* only the skin around faces */
 } WhiteningValues;
 
 static const WhiteningEffectType effects[] =
@@ -54,17 +63,29 @@ static void     run      (const gchar      *name,
                           GimpParam       **return_vals);
 
 static void     skin_whitening (GimpDrawable *drawable);
-static void     skin_whitening_effect (GimpDrawable *drawable);
+static void     skin_whitening_batch (const gint32 *images,
+                                      gint          n_images,
+                                      gboolean      all_layers,
+                                      gint          effect,
+                                      gdouble       strength,
+                                      gdouble       smoothing);
 
 static gboolean skin_whitening_dialog (gint32        image_ID,
                                        GimpDrawable *drawable);
 
 static void     reset_pressed (GtkButton *button, gpointer user_date);
+static void     auto_pressed (GtkButton *button, gpointer user_data);
+
+static void     whitening_update ();
 
-static void     preview_update (GtkWidget *preview);
+static void     family_toggled (GtkToggleButton *button, gpointer data);
+static void     strength_update (GtkRange *range, gpointer data);
+static void     smoothing_update (GtkRange *range, gpointer data);
+static void     faces_toggled (GtkToggleButton *button, gpointer data);
 
 static GtkWidget* effects_box_new ();
 static GtkWidget* effect_icon_new (WhiteningEffectType effect);
+static gboolean   render_thumbnails (gpointer data);
 static gboolean   effect_select (GtkWidget *event_box, GdkEventButton *event, WhiteningEffectType effect);
 
 const GimpPlugInInfo PLUG_IN_INFO =
@@ -77,7 +98,10 @@ const GimpPlugInInfo PLUG_IN_INFO =
 
 static WhiteningValues wvals =
 {
-  WHITENING_EFFECT_NONE,  /* effect */
+  WHITENING_FAMILY_WHITENING,  /* family */
+  0,                           /* strength */
+  0,                           /* smoothing */
+  FALSE,                       /* faces */
 };
 
 static gint32     image_ID         = 0;
@@ -85,7 +109,26 @@ static gint       width;
 static gint       height;
 
 static GtkWidget *preview          = NULL;
-static gint32     preview_image    = 0;
+static PreviewSurface *preview_surface = NULL;
+/* the drawable at preview size, as it is, and the layer it was read
+ * from, -1 when the proxy is the whole image
+ */
+static guchar    *proxy            = NULL;
+static gint32     proxy_layer      = -1;
+static guchar    *proxy_whitened   = NULL;
+static gboolean   proxy_gray       = FALSE;
+/* the faces found in the proxy, NULL without a face cascade */
+static GArray    *proxy_faces      = NULL;
+
+static GtkWidget *family_buttons[3];
+static GtkWidget *strength         = NULL;
+static GtkWidget *smoothing        = NULL;
+/* the widgets are being set from wvals */
+static gboolean   syncing          = FALSE;
+
+/* the preset icons, rendered from the image after the dialog is up */
+static GtkWidget *effect_images[G_N_ELEMENTS (effects)];
+static guint      thumbnails_id    = 0;
 
 /* compatable with gtk2 */
 #if GTK_MAJOR_VERSION < 3
@@ -110,7 +153,7 @@ query (void)
     { GIMP_PDB_INT32,    "run-mode",   "The run mode { RUN-INTERACTIVE (0), RUN-NONINTERACTIVE (1) }" },
     { GIMP_PDB_IMAGE,    "image",      "Input image" },
     { GIMP_PDB_DRAWABLE, "drawable",   "Input drawable" },
-    { GIMP_PDB_INT32,    "effect",     "The effect to apply { LITTLE_WHITENING (1), MODERATE_WHITENING (2), HIGH_WHITENING (3), LITTLE_PINK (4), MODERATE_PINK (5), HIGH_PINK (6), LITTLE_FLESH (7), MODERATE_FLESH (8), HIGH_FLESH (9) }" }
+    { GIMP_PDB_INT32,    "effect",     "The effect to apply { LITTLE_WHITENING (1), MODERATE_WHITENING (2), HIGH_WHITENING (3), LITTLE_PINK (4), MODERATE_PINK (5), HIGH_PINK (6), LITTLE_FLESH (7), MODERATE_FLESH (8), HIGH_FLESH (9), AUTO (10) }" }
   };
 
   gimp_install_procedure (PLUG_IN_PROC,
@@ -126,6 +169,29 @@ query (void)
                           args, NULL);
 
   gimp_plugin_menu_register (PLUG_IN_PROC, "<Image>/Filters/Beautify");
+
+  static const GimpParamDef batch_args[] =
+  {
+    { GIMP_PDB_INT32,      "run-mode",   "The run mode { RUN-NONINTERACTIVE (1) }" },
+    { GIMP_PDB_INT32,      "num-images", "The number of images" },
+    { GIMP_PDB_INT32ARRAY, "images",     "The images" },
+    { GIMP_PDB_INT32,      "all-layers", "Whiten every layer of each image, not only the active one (TRUE, FALSE)" },
+    { GIMP_PDB_INT32,      "effect",     "The preset, see plug-in-skin-whitening, AUTO (10) picks one for each layer" },
+    { GIMP_PDB_FLOAT,      "strength",   "The strength (0 <= strength <= 100), -1 for the one of the preset" },
+    { GIMP_PDB_FLOAT,      "smoothing",  "Skin smoothing (0 <= smoothing <= 100)" }
+  };
+
+  gimp_install_procedure (PLUG_IN_BATCH_PROC,
+                          "Whiten the skin of many images.",
+                          "Whiten the skin of the active layer, or of all the layers, of each image in one call. The curves are prepared once for all of them, unless AUTO picks them for each layer.",
+                          "Hejian <hejian.he@gmail.com>",
+                          "Hejian <hejian.he@gmail.com>",
+                          "2012",
+                          NULL,
+                          NULL,
+                          GIMP_PLUGIN,
+                          G_N_ELEMENTS (batch_args), 0,
+                          batch_args, NULL);
 }
 
 static void
@@ -148,6 +214,22 @@ run (const gchar      *name,
   values[0].type          = GIMP_PDB_STATUS;
   values[0].data.d_status = status;
 
+  if (strcmp (name, PLUG_IN_BATCH_PROC) == 0)
+  {
+    if (nparams != 7 ||
+        param[4].data.d_int32 < WHITENING_EFFECT_LITTLE_WHITENING ||
+        param[4].data.d_int32 > WHITENING_EFFECT_AUTO)
+    {
+      values[0].data.d_status = GIMP_PDB_CALLING_ERROR;
+      return;
+    }
+
+    skin_whitening_batch (param[2].data.d_int32array, param[1].data.d_int32,
+                          param[3].data.d_int32, param[4].data.d_int32,
+                          param[5].data.d_float, param[6].data.d_float);
+    return;
+  }
+
   image_ID = param[1].data.d_image;
   drawable = gimp_drawable_get (param[2].data.d_drawable);
 
@@ -168,7 +250,18 @@ run (const gchar      *name,
 
       if (status == GIMP_PDB_SUCCESS)
       {
-        wvals.effect = param[3].data.d_int32;
+        if (param[3].data.d_int32 == WHITENING_EFFECT_AUTO)
+        {
+          SkinStats stats;
+
+          skin_stats_collect (&stats, drawable->drawable_id, WHITENING_AUTO_PIXELS);
+          whitening_auto (&stats, &wvals.family, &wvals.strength);
+        }
+        else
+        {
+          whitening_effect_params (param[3].data.d_int32,
+                                   &wvals.family, &wvals.strength);
+        }
       }
       break;
 
@@ -187,10 +280,7 @@ run (const gchar      *name,
     {
       /* Run! */
       gimp_image_undo_group_start (image_ID);
-      if (run_mode == GIMP_RUN_INTERACTIVE)
-        skin_whitening (drawable);
-      else
-        skin_whitening_effect (drawable);
+      skin_whitening (drawable);
       gimp_image_undo_group_end (image_ID);
 
       /* If run mode is interactive, flush displays */
@@ -209,16 +299,126 @@ run (const gchar      *name,
 static void
 skin_whitening (GimpDrawable *drawable)
 {
-  gint32 source = gimp_image_get_active_layer (preview_image);
-  gimp_edit_copy (source);
-  gint32 floating_sel = gimp_edit_paste (drawable->drawable_id, FALSE);
-  gimp_floating_sel_anchor (floating_sel);
+  ColorLut lut;
+
+  gimp_image_set_active_layer (image_ID, drawable->drawable_id);
+
+  whitening_lut (wvals.family, wvals.strength, &lut);
+  run_whitening (image_ID, &lut, wvals.smoothing,
+                 wvals.faces ? whitening_face_cascade () : NULL);
+}
+
+/* whiten a layer of the batch, with the tables shared by all of them
+ * or, for AUTO, picked for the layer
+ */
+static void
+batch_layer (gint32          image,
+             gint32          layer,
+             const ColorLut *lut,
+             gint            effect,
+             gdouble         strength,
+             gdouble         smoothing)
+{
+  ColorLut auto_lut;
+
+  if (!gimp_drawable_is_rgb (layer) && !gimp_drawable_is_gray (layer))
+    return;
+
+  if (effect == WHITENING_EFFECT_AUTO)
+  {
+    SkinStats       stats;
+    WhiteningFamily family;
+    gdouble         auto_strength;
+
+    skin_stats_collect (&stats, layer, WHITENING_AUTO_PIXELS);
+    whitening_auto (&stats, &family, &auto_strength);
+    whitening_lut (family, (strength >= 0) ? strength : auto_strength, &auto_lut);
+    lut = &auto_lut;
+  }
+
+  gimp_image_set_active_layer (image, layer);
+  run_whitening (image, lut, smoothing, NULL);
+}
+
+/* the layers inside groups are whitened, not the groups */
+static void
+batch_layers (gint32          image,
+              const gint32   *layers,
+              gint            num_layers,
+              const ColorLut *lut,
+              gint            effect,
+              gdouble         strength,
+              gdouble         smoothing)
+{
+  gint i;
+
+  for (i = 0; i < num_layers; i++)
+  {
+    if (gimp_item_is_group (layers[i]))
+    {
+      gint32 *children;
+      gint    num_children;
+
+      children = gimp_item_get_children (layers[i], &num_children);
+      batch_layers (image, children, num_children, lut, effect, strength, smoothing);
+      g_free (children);
+    }
+    else
+    {
+      batch_layer (image, layers[i], lut, effect, strength, smoothing);
+    }
+  }
 }
 
+/* one process for all the images: the tables are prepared once and the
+ * worker threads are kept from one layer to the next
+ */
 static void
-skin_whitening_effect (GimpDrawable *drawable)
+skin_whitening_batch (const gint32 *images,
+                      gint          n_images,
+                      gboolean      all_layers,
+                      gint          effect,
+                      gdouble       strength,
+                      gdouble       smoothing)
 {
-  run_effect (image_ID, wvals.effect);
+  ColorLut lut;
+  gint     i;
+
+  if (effect != WHITENING_EFFECT_AUTO)
+  {
+    WhiteningFamily family;
+    gdouble         preset_strength;
+
+    whitening_effect_params (effect, &family, &preset_strength);
+    whitening_lut (family, (strength >= 0) ? strength : preset_strength, &lut);
+  }
+
+  for (i = 0; i < n_images; i++)
+  {
+    gint32 image = images[i];
+    gint32 active = gimp_image_get_active_layer (image);
+
+    gimp_image_undo_group_start (image);
+
+    if (all_layers)
+    {
+      gint32 *layers;
+      gint    num_layers;
+
+      layers = gimp_image_get_layers (image, &num_layers);
+      batch_layers (image, layers, num_layers, &lut, effect, strength, smoothing);
+      g_free (layers);
+
+      if (active != -1)
+        gimp_image_set_active_layer (image, active);
+    }
+    else if (active != -1)
+    {
+      batch_layers (image, &active, 1, &lut, effect, strength, smoothing);
+    }
+
+    gimp_image_undo_group_end (image);
+  }
 }
 
 static gboolean
@@ -277,11 +477,41 @@ skin_whitening_dialog (gint32        image_ID,
   gtk_widget_show (reset);
   g_signal_connect (reset, "pressed", G_CALLBACK (reset_pressed), NULL);
 
-  /* preview */
-  preview_image = gimp_image_duplicate (image_ID);
+  GtkWidget *auto_button = gtk_button_new_with_label ("Auto");
+  gtk_box_pack_start (GTK_BOX (buttons), auto_button, FALSE, FALSE, 0);
+  gtk_widget_show (auto_button);
+  g_signal_connect (auto_button, "clicked", G_CALLBACK (auto_pressed), NULL);
+
+  /* preview, the drawable is read once at preview size. OK only
+   * whitens the drawable, so the other layers are composited with it
+   * as they are; a drawable in a group or a mask whitens the whole
+   * image instead
+   */
+  gint    rowstride;
+  guchar *pixels;
+
+  preview_surface = preview_surface_new (width, height, PREVIEW_SIZE);
+  preview = preview_surface->widget;
 
-  preview = gtk_image_new();
-  preview_update (preview);
+  if (gimp_item_is_layer (drawable->drawable_id) &&
+      gimp_item_get_parent (drawable->drawable_id) == -1)
+  {
+    proxy_layer = drawable->drawable_id;
+    proxy = preview_surface_read_layer (preview_surface, image_ID, proxy_layer);
+    proxy_whitened = g_memdup (proxy, preview_surface->width * preview_surface->height * 4);
+  }
+  else
+  {
+    proxy_layer = -1;
+    preview_surface_composite_image (preview_surface, image_ID);
+    pixels = preview_surface_get_pixels (preview_surface, &rowstride);
+    proxy = g_memdup (pixels, rowstride * preview_surface->height);
+  }
+  proxy_gray = !gimp_drawable_is_rgb (drawable->drawable_id);
+  if (whitening_face_cascade () && !proxy_gray)
+    proxy_faces = face_detect_rgb (whitening_face_cascade (), proxy,
+                                   preview_surface->width, preview_surface->height, 4);
+  whitening_update ();
 
   gtk_box_pack_start (GTK_BOX (middle_vbox), preview, TRUE, TRUE, 0);
   gtk_widget_show (preview);
@@ -295,9 +525,89 @@ skin_whitening_dialog (gint32        image_ID,
   gtk_box_pack_start (GTK_BOX (right_vbox), effects, FALSE, FALSE, 0);
   gtk_widget_show (effects);
 
+  /* family and strength */
+  static const gchar *family_names[] = { "Whitening", "Pink", "Flesh" };
+  GtkWidget *families = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 6);
+  GSList    *group = NULL;
+  gint       i;
+
+  gtk_box_pack_start (GTK_BOX (right_vbox), families, FALSE, FALSE, 0);
+  gtk_widget_show (families);
+
+  for (i = 0; i < G_N_ELEMENTS (family_names); i++)
+  {
+    family_buttons[i] = gtk_radio_button_new_with_label (group, family_names[i]);
+    group = gtk_radio_button_get_group (GTK_RADIO_BUTTON (family_buttons[i]));
+    gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (family_buttons[i]), i == wvals.family);
+    gtk_box_pack_start (GTK_BOX (families), family_buttons[i], FALSE, FALSE, 0);
+    gtk_widget_show (family_buttons[i]);
+
+    g_signal_connect (family_buttons[i], "toggled",
+                      G_CALLBACK (family_toggled),
+                      GINT_TO_POINTER (i));
+  }
+
+  label = gtk_label_new ("Strength");
+  gtk_box_pack_start (GTK_BOX (right_vbox), label, FALSE, FALSE, 0);
+  gtk_widget_show (label);
+
+  strength = gtk_hscale_new_with_range (0, 100, 1);
+  gtk_range_set_value (GTK_RANGE (strength), wvals.strength);
+  gtk_scale_set_value_pos (GTK_SCALE (strength), GTK_POS_BOTTOM);
+  gtk_box_pack_start (GTK_BOX (right_vbox), strength, FALSE, FALSE, 0);
+  gtk_widget_show (strength);
+
+  g_signal_connect (strength, "value-changed",
+                    G_CALLBACK (strength_update),
+                    NULL);
+
+  /* skin smoothing */
+  label = gtk_label_new ("Smoothing");
+  gtk_box_pack_start (GTK_BOX (right_vbox), label, FALSE, FALSE, 0);
+  gtk_widget_show (label);
+
+  smoothing = gtk_hscale_new_with_range (0, 100, 1);
+  gtk_range_set_value (GTK_RANGE (smoothing), wvals.smoothing);
+  gtk_scale_set_value_pos (GTK_SCALE (smoothing), GTK_POS_BOTTOM);
+  gtk_box_pack_start (GTK_BOX (right_vbox), smoothing, FALSE, FALSE, 0);
+  gtk_widget_show (smoothing);
+
+  g_signal_connect (smoothing, "value-changed",
+                    G_CALLBACK (smoothing_update),
+                    NULL);
+
+  /* faces, when there is a face cascade to find them with */
+  GtkWidget *faces = gtk_check_button_new_with_label ("Faces only");
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (faces), wvals.faces && proxy_faces);
+  gtk_widget_set_sensitive (faces, proxy_faces != NULL);
+  if (!proxy_faces)
+    gtk_widget_set_tooltip_text (faces, "Needs a face cascade in the GIMP directory");
+  gtk_box_pack_start (GTK_BOX (right_vbox), faces, FALSE, FALSE, 0);
+  gtk_widget_show (faces);
+
+  g_signal_connect (faces, "toggled",
+                    G_CALLBACK (faces_toggled),
+                    NULL);
+
+  thumbnails_id = g_idle_add_full (G_PRIORITY_LOW, render_thumbnails, NULL, NULL);
+
   gboolean run = (gimp_dialog_run (GIMP_DIALOG (dialog)) == GTK_RESPONSE_OK);
 
+  if (thumbnails_id)
+  {
+    g_source_remove (thumbnails_id);
+    thumbnails_id = 0;
+  }
+
   gtk_widget_destroy (dialog);
+  preview_surface_free (preview_surface);
+  g_free (proxy);
+  proxy = NULL;
+  g_free (proxy_whitened);
+  proxy_whitened = NULL;
+  if (proxy_faces)
+    g_array_free (proxy_faces, TRUE);
+  proxy_faces = NULL;
 
   return run;
 }
@@ -305,22 +615,82 @@ skin_whitening_dialog (gint32        image_ID,
 static void
 reset_pressed (GtkButton *button, gpointer user_date)
 {
-  gimp_image_delete (preview_image);
-  preview_image = gimp_image_duplicate (image_ID);
-  preview_update (preview);
+  wvals.strength = 0;
+  wvals.smoothing = 0;
+
+  syncing = TRUE;
+  gtk_range_set_value (GTK_RANGE (strength), 0);
+  gtk_range_set_value (GTK_RANGE (smoothing), 0);
+  syncing = FALSE;
+
+  whitening_update ();
+}
+
+/* render the preview from the proxy, a slider change rebuilds the
+ * tables and runs them in one pass over the preview pixels, only OK
+ * touches the image
+ */
+static void
+whitening_update ()
+{
+  ColorLut lut;
+  gint     rowstride;
+  guchar  *pixels = preview_surface_get_pixels (preview_surface, &rowstride);
+
+  whitening_lut (wvals.family, wvals.strength, &lut);
+
+  if (proxy_layer != -1)
+    pixels = proxy_whitened;
+
+  /* the rows of an RGBA pixbuf are not padded */
+  whitening_buffer (proxy, &pixels, &lut, 1,
+                    preview_surface->width, preview_surface->height,
+                    4, proxy_gray, wvals.smoothing,
+                    wvals.faces ? proxy_faces : NULL);
+
+  if (proxy_layer != -1)
+    preview_surface_composite_image_with (preview_surface, image_ID,
+                                          proxy_layer, proxy_whitened);
+
+  preview_surface_flatten (preview_surface);
+}
+
+static void
+family_toggled (GtkToggleButton *button, gpointer data)
+{
+  if (!gtk_toggle_button_get_active (button))
+    return;
+
+  wvals.family = GPOINTER_TO_INT (data);
+  if (!syncing)
+    whitening_update ();
 }
 
 static void
-preview_update (GtkWidget *preview)
+strength_update (GtkRange *range, gpointer data)
 {
-  gint preview_size = PREVIEW_SIZE;
-  gint max_size = height;
-  if (height < width)
-    max_size = width;
-  if (preview_size > max_size)
-    preview_size = max_size;
-  GdkPixbuf *pixbuf = gimp_image_get_thumbnail (preview_image, preview_size, preview_size, GIMP_PIXBUF_SMALL_CHECKS);
-  gtk_image_set_from_pixbuf (GTK_IMAGE(preview), pixbuf);
+  wvals.strength = gtk_range_get_value (range);
+  if (!syncing)
+    whitening_update ();
+}
+
+static void
+smoothing_update (GtkRange *range, gpointer data)
+{
+  wvals.smoothing = gtk_range_get_value (range);
+  if (!syncing)
+    whitening_update ();
+}
+
+static void
+faces_toggled (GtkToggleButton *button, gpointer data)
+{
+  wvals.faces = gtk_toggle_button_get_active (button);
+  whitening_update ();
+
+  /* the icons follow */
+  if (!thumbnails_id)
+    thumbnails_id = g_idle_add_full (G_PRIORITY_LOW, render_thumbnails, NULL, NULL);
 }
 
 static GtkWidget *
@@ -355,53 +725,44 @@ effects_box_new ()
 static GtkWidget *
 effect_icon_new (WhiteningEffectType effect)
 {
-  const guint8 *data;
   gchar  *title;
 
   switch (effect) {
     case WHITENING_EFFECT_LITTLE_WHITENING:
-      data = skin_whitening_1;
       title = "Little\nWhitening";
       break;
     case WHITENING_EFFECT_MODERATE_WHITENING:
-      data = skin_whitening_2;
       title = "Moderate\nWhitening";
       break;
     case WHITENING_EFFECT_HIGH_WHITENING:
-      data = skin_whitening_3;
       title = "High\nWhitening";
       break;
     case WHITENING_EFFECT_LITTLE_PINK:
-      data = skin_whitening_4;
       title = "Little Pink";
       break;
     case WHITENING_EFFECT_MODERATE_PINK:
-      data = skin_whitening_5;
       title = "Moderate\nPink";
       break;
     case WHITENING_EFFECT_HIGH_PINK:
-      data = skin_whitening_6;
       title = "High Pink";
       break;
     case WHITENING_EFFECT_LITTLE_FLESH:
-      data = skin_whitening_7;
       title = "Little Flesh";
       break;
     case WHITENING_EFFECT_MODERATE_FLESH:
-      data = skin_whitening_8;
       title = "Moderate\nFlesh";
       break;
     case WHITENING_EFFECT_HIGH_FLESH:
-      data = skin_whitening_9;
       title = "High Flesh";
       break;
   }
 
   GtkWidget *box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 2);
 
-  /* image */
-  GdkPixbuf *pixbuf = gdk_pixbuf_new_from_inline (-1, data, FALSE, NULL);
-  GtkWidget *image = gtk_image_new_from_pixbuf (pixbuf);
+  /* image, rendered later by render_thumbnails () */
+  GtkWidget *image = gtk_image_new ();
+  gtk_widget_set_size_request (image, THUMBNAIL_SIZE, THUMBNAIL_SIZE);
+  effect_images[effect - 1] = image;
   GtkWidget *event_box = gtk_event_box_new ();
   gtk_container_add (GTK_CONTAINER (event_box), image);
   gtk_widget_show (image);
@@ -422,10 +783,123 @@ effect_icon_new (WhiteningEffectType effect)
   return box;
 }
 
+/* the proxy scaled down to fit THUMBNAIL_SIZE, averaging the pixels */
+static guchar *
+thumbnail_proxy (gint *thumbnail_width, gint *thumbnail_height)
+{
+  gint    src_width = preview_surface->width;
+  gint    src_height = preview_surface->height;
+  gint    size = MAX (src_width, src_height);
+  gint    w = MAX (1, src_width * THUMBNAIL_SIZE / size);
+  gint    h = MAX (1, src_height * THUMBNAIL_SIZE / size);
+  guchar *thumbnail = g_new (guchar, w * h * 4);
+  gint    x, y, c, sx, sy;
+
+  for (y = 0; y < h; y++)
+    for (x = 0; x < w; x++)
+    {
+      gint x1 = x * src_width / w, x2 = MAX (x1 + 1, (x + 1) * src_width / w);
+      gint y1 = y * src_height / h, y2 = MAX (y1 + 1, (y + 1) * src_height / h);
+      gint sum[4] = { 0, 0, 0, 0 };
+
+      for (sy = y1; sy < y2; sy++)
+        for (sx = x1; sx < x2; sx++)
+          for (c = 0; c < 4; c++)
+            sum[c] += proxy[(sy * src_width + sx) * 4 + c];
+
+      for (c = 0; c < 4; c++)
+        thumbnail[(y * w + x) * 4 + c] = sum[c] / ((x2 - x1) * (y2 - y1));
+    }
+
+  *thumbnail_width = w;
+  *thumbnail_height = h;
+
+  return thumbnail;
+}
+
+/* all the presets in one pass over a small copy of the image */
+static gboolean
+render_thumbnails (gpointer data)
+{
+  ColorLut  luts[G_N_ELEMENTS (effects)];
+  guchar   *dests[G_N_ELEMENTS (effects)];
+  guchar   *thumbnail;
+  GArray   *faces = NULL;
+  gint      w, h;
+  gint      i;
+
+  thumbnail = thumbnail_proxy (&w, &h);
+
+  /* the faces of the proxy, scaled down with it */
+  if (wvals.faces && proxy_faces)
+  {
+    faces = g_array_new (FALSE, FALSE, sizeof (Face));
+    g_array_append_vals (faces, proxy_faces->data, proxy_faces->len);
+    face_scale (faces, (gdouble) w / preview_surface->width);
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (effects); i++)
+  {
+    color_lut_init (&luts[i]);
+    whitening_effect_lut (effects[i], &luts[i]);
+    dests[i] = g_new (guchar, w * h * 4);
+  }
+
+  whitening_buffer (thumbnail, dests, luts, G_N_ELEMENTS (effects),
+                    w, h, 4, proxy_gray, 0, faces);
+
+  for (i = 0; i < G_N_ELEMENTS (effects); i++)
+  {
+    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_data (dests[i], GDK_COLORSPACE_RGB,
+                                                  TRUE, 8, w, h, w * 4,
+                                                  (GdkPixbufDestroyNotify) g_free,
+                                                  NULL);
+
+    gtk_image_set_from_pixbuf (GTK_IMAGE (effect_images[effects[i] - 1]), pixbuf);
+    g_object_unref (pixbuf);
+  }
+
+  g_free (thumbnail);
+  if (faces)
+    g_array_free (faces, TRUE);
+
+  thumbnails_id = 0;
+  return FALSE;
+}
+
+/* show the family and the strength of wvals, and the preview */
+static void
+values_sync ()
+{
+  syncing = TRUE;
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (family_buttons[wvals.family]), TRUE);
+  gtk_range_set_value (GTK_RANGE (strength), wvals.strength);
+  syncing = FALSE;
+
+  whitening_update ();
+}
+
+/* a preset sets the family and the strength */
 static gboolean
 effect_select (GtkWidget *event_box, GdkEventButton *event, WhiteningEffectType effect)
 {
-  run_effect (preview_image, effect);
+  whitening_effect_params (effect, &wvals.family, &wvals.strength);
+  values_sync ();
+
+  return TRUE;
+}
+
+/* pick them from the skin tones of the proxy */
+static void
+auto_pressed (GtkButton *button, gpointer user_data)
+{
+  SkinStats stats;
+
+  if (proxy_gray)
+    return;
 
-  preview_update (preview);
+  skin_stats_buffer (&stats, proxy,
+                     preview_surface->width * preview_surface->height, 4);
+  whitening_auto (&stats, &wvals.family, &wvals.strength);
+  values_sync ();
 }
@@ -18,6 +18,8 @@
 #include <libgimp/gimp.h>
 #include <libgimp/gimpui.h>
 
+#include "preview-surface.h"
+
 #define PLUG_IN_PROC   "plug-in-text-font"
 #define PLUG_IN_BINARY "text-font"
 #define PLUG_IN_ROLE   "gimp-text-font"
@@ -68,6 +70,7 @@ static gint       width;
 static gint       height;
 
 static GtkWidget *preview          = NULL;
+static PreviewSurface *preview_surface = NULL;
 static gint32     preview_image    = 0;
 
 MAIN ()
@@ -183,14 +186,7 @@ text_font (GimpDrawable *drawable)
 static void
 preview_update (GtkWidget *preview)
 {
-  gint preview_size = PREVIEW_SIZE;
-  gint max_size = height;
-  if (height < width)
-    max_size = width;
-  if (preview_size > max_size)
-    preview_size = max_size;
-  GdkPixbuf *pixbuf = gimp_image_get_thumbnail (preview_image, preview_size, preview_size, GIMP_PIXBUF_SMALL_CHECKS);
-  gtk_image_set_from_pixbuf (GTK_IMAGE(preview), pixbuf);
+  preview_surface_draw_image (preview_surface, preview_image);
 }
 
 static gboolean
@@ -247,7 +243,8 @@ text_font_dialog (gint32        image_ID,
 
   preview_image = gimp_image_duplicate (image_ID);
 
-  preview = gtk_image_new();
+  preview_surface = preview_surface_new (width, height, PREVIEW_SIZE);
+  preview = preview_surface->widget;
   preview_update (preview);
 
   gtk_box_pack_start (GTK_BOX (middle_vbox), preview, TRUE, TRUE, 0);
@@ -327,6 +324,7 @@ text_font_dialog (gint32        image_ID,
   gboolean run = (gimp_dialog_run (GIMP_DIALOG (dialog)) == GTK_RESPONSE_OK);
 
   gtk_widget_destroy (dialog);
+  preview_surface_free (preview_surface);
 
   return run;
 }